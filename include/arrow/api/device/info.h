@@ -34,6 +34,8 @@ void device_info_init(device_info_t *gd);
 void device_info_free(device_info_t *gd);
 void device_info_move(device_info_t *dst, device_info_t *src);
 int device_info_parse(device_info_t **list, const char *s);
+// the same but the text is destroyed (the strings are decoded in place)
+int device_info_parse_insitu(device_info_t **list, char *s);
 
 #if defined(__cplusplus)
 }
@@ -38,6 +38,8 @@ void gateway_info_init(gateway_info_t *gi);
 void gateway_info_free(gateway_info_t *gi);
 void gateway_info_move(gateway_info_t *dst, gateway_info_t *src);
 int gateway_info_parse(gateway_info_t **list, const char *s);
+// the same but the text is destroyed (the strings are decoded in place)
+int gateway_info_parse_insitu(gateway_info_t **list, char *s);
 
 #if defined(__cplusplus)
 }
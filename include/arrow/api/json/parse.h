@@ -16,6 +16,7 @@ extern "C" {
 #include <data/property.h>
 #include <json/json.h>
 #include <time/time.h>
+#include <data/linkedlist.h>
 
 // FIXME move to file
 typedef struct _page_size_ {
@@ -35,6 +36,64 @@ void who_when_free(who_when_t *ww);
 void who_when_move(who_when_t *dst, who_when_t *src);
 int who_when_parse(JsonNode *tmp, who_when_t *ww, const char *date, const char *person);
 
+// take the node out of the parsed tree to keep it
+// (a copy if the tree is in an arena)
+JsonNode *json_keep_node(JsonNode *node);
+
+// the struct <-> JSON binding
+// a table of the struct fields describes the JSON object members,
+// the members are dispatched to the fields in one pass by the key hash
+typedef enum {
+    json_field_string,  // property_t, a JSON string
+    json_field_date,    // struct tm, a JSON string "%Y-%m-%dT%H:%M:%S"
+    json_field_bool,    // int, a JSON bool
+    json_field_int,     // int, a JSON number
+    json_field_node     // JsonNode *, any JSON value kept as is
+} json_field_kind_t;
+
+typedef struct _json_field_ {
+    const char *key;
+    uint16_t offset;
+    uint8_t kind;
+} json_field_t;
+
+#define JSON_FIELD_KEY(key, st, member, kind) { key, (uint16_t)offsetof(st, member), kind }
+#define JSON_FIELD(st, member, kind) JSON_FIELD_KEY(xstr(member), st, member, kind)
+// who_when_t member: the "<prefix>Date" and "<prefix>By" keys
+#define JSON_FIELD_WHO_WHEN(st, member, prefix) \
+    JSON_FIELD_KEY(prefix "Date", st, member.date, json_field_date), \
+    JSON_FIELD_KEY(prefix "By", st, member.by, json_field_string)
+
+// the key hash table size, twice as large as the biggest field table at least
+#if !defined(JSON_FIELDS_SLOTS)
+# define JSON_FIELDS_SLOTS 32
+#endif
+
+typedef struct _json_fields_ {
+    const json_field_t *field;
+    uint8_t count;
+    uint8_t ready;
+    // field index + 1 by the key hash, filled at the first use
+    uint8_t slot[JSON_FIELDS_SLOTS];
+} json_fields_t;
+
+#define JSON_FIELDS(name, table) \
+    json_fields_t name = { table, sizeof(table)/sizeof(table[0]), 0, { 0 } }
+
+// the key hash table is filled at the first parse under this lock
+// a multithreaded platform should override these
+void json_fields_lock(void);
+void json_fields_unlock(void);
+
+void json_fields_init(json_fields_t *d, void *obj);
+void json_fields_free(json_fields_t *d, void *obj);
+void json_fields_move(json_fields_t *d, void *dst, void *src);
+// fill the fields from the members of the object
+// the unknown members and the ones of the wrong type are skipped
+int json_fields_parse(json_fields_t *d, void *obj, JsonNode *object);
+// a new JSON object with the set fields
+JsonNode *json_fields_encode(json_fields_t *d, const void *obj);
+
 #define json_fill_property(tmp, gx, x) do { \
     JsonNode *t = json_find_member(tmp, xstr(x)); \
     if ( t && t->tag == JSON_STRING ) \
@@ -37,9 +37,28 @@ int mqtt_subscribe(void);
 // The user's command or software update command
 int mqtt_yield(int timeout_ms);
 
+// Process the incoming MQTT packets in reactor_poll
+// mqtt_yield is still needed from time to time to keep the connection alive
+// the new socket is attached again after mqtt_connect
+int mqtt_reactor_attach(void);
+void mqtt_reactor_detach(void);
+
 // Send the telemetry data to the cloud
 // there is extremely needed the telemetry_serialize function implementation to serealize 'data' correctly
 int mqtt_publish(arrow_device_t *device, void *data);
+// Send the already serialized telemetry message
+int mqtt_publish_payload(const char *payload, int len);
+
+// The QoS 1/2 messages are pipelined up to MQTT_INFLIGHT: mqtt_publish
+// returns after the sending, the acks are read by mqtt_yield.
+// The messages without the ack are sent again after the reconnection.
+// cb gets the packet id and 0 when the ack came or -1 if it's dropped
+typedef void (*mqtt_publish_done_f)(int id, int rc);
+void mqtt_publish_set_cb(mqtt_publish_done_f cb);
+// the number of the messages waiting for the ack
+int mqtt_publish_pending(void);
+// drop the messages waiting for the ack
+void mqtt_publish_abort(void);
 
 #if defined(__cplusplus)
 }
@@ -37,6 +37,7 @@ void sign(char *signature,
           const char *apiVersion);
 
 // Add needed headers for the Arrow cloud
-void sign_request(http_request_t *req);
+// return: 0 or -1 if the payload can't be hashed
+int sign_request(http_request_t *req);
 
 #endif /* ARROW_SIGN_H_ */
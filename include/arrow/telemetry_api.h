@@ -45,7 +45,15 @@ int add_telemetry_data_info(telemetry_response_data_list_t *data,
 // create telemetry data to the cloud
 int arrow_send_telemetry(arrow_device_t *device, void *data);
 // create telemetry data batch
+// the records are int sized, use arrow_telemetry_batch_create_stride for the others
 int arrow_telemetry_batch_create(arrow_device_t *device, void *data, int size);
+// create telemetry data batch of count records of stride bytes each
+// the records are serialized one by one while the request is sent,
+// every record is serialized twice: for the signature hash and for the sending
+int arrow_telemetry_batch_create_stride(arrow_device_t *device, void *data, int count, int stride);
+// send the already serialized telemetry data,
+// batch - the payload is a [rec,rec,...] array for the batch request
+int arrow_send_telemetry_payload(const char *payload, int batch);
 // find telemetry data by an application hid
 int arrow_telemetry_find_by_application_hid(const char *hid, int n, ...);
 // find telemetry data by a device hid
@@ -0,0 +1,85 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_ARROW_TELEMETRY_QUEUE_H_
+#define ACN_SDK_C_ARROW_TELEMETRY_QUEUE_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// The serialized telemetry messages kept while the cloud is unreachable.
+// The queue is a ring of TELEMETRY_QUEUE_SEGMENTS segments, the records are
+// appended to the last one and the oldest segment is dropped when the ring
+// is full. A record is never rewritten: only its state byte goes
+// 0xFF (free) -> 0xFE (stored) -> 0x00 (sent), so a flash sector fits.
+
+#if !defined(TELEMETRY_QUEUE_SEGMENTS)
+# define TELEMETRY_QUEUE_SEGMENTS     4
+#endif
+#if !defined(TELEMETRY_QUEUE_SEGMENT_SIZE)
+# define TELEMETRY_QUEUE_SEGMENT_SIZE 4096
+#endif
+// max number of the stored messages sent per routine cycle
+#if !defined(TELEMETRY_QUEUE_BATCH)
+# define TELEMETRY_QUEUE_BATCH        8
+#endif
+// the segment files on Linux: TELEMETRY_QUEUE_PATH<n>.seg,
+// the directory should exist, the files are created by the first push
+#if !defined(TELEMETRY_QUEUE_PATH)
+# define TELEMETRY_QUEUE_PATH         "/var/lib/acnsdkc/telemetry_queue"
+#endif
+
+#if TELEMETRY_QUEUE_SEGMENTS < 2
+# error "TELEMETRY_QUEUE_SEGMENTS must be 2 at least"
+#endif
+#if TELEMETRY_QUEUE_SEGMENT_SIZE > 0xFFFF
+# error "TELEMETRY_QUEUE_SEGMENT_SIZE is too big"
+#endif
+
+// The segment storage: memory mapped files on Linux,
+// the default ones return -1 on the other platforms (no queue).
+// An erased segment reads as 0xFF, the storage shouldn't be created
+// before the first write.
+// return: len or -1
+int telemetry_queue_seg_read(int seg, int offset, void *buf, int len);
+int telemetry_queue_seg_write(int seg, int offset, const void *buf, int len);
+// return: 0 or -1
+int telemetry_queue_seg_erase(int seg);
+
+// find the stored messages after the reboot,
+// it's called by the first queue function and writes nothing
+// return: 0 or -1 if there is no storage
+int telemetry_queue_init(void);
+// forget the queue state (the stored messages are kept)
+void telemetry_queue_close(void);
+// drop all stored messages
+int telemetry_queue_clear(void);
+
+// append the serialized message
+// return: 0 or -1 if it's too long or the storage failed
+int telemetry_queue_push(const char *payload, int len);
+// the number of the messages waiting for the sending
+int telemetry_queue_count(void);
+// the number of the messages dropped because the queue was full
+int telemetry_queue_dropped(void);
+
+// send the null terminated message(s), return: 0 or -1
+typedef int (*telemetry_queue_send_f)(const char *payload, int len, void *arg);
+// send up to max messages one by one, the oldest first;
+// the sending stops on the first failure and the message is kept
+// return: the number of the sent messages
+int telemetry_queue_drain(int max, telemetry_queue_send_f send, void *arg);
+// the same but up to max messages are sent at once as [msg,msg,...]
+int telemetry_queue_drain_batch(int max, telemetry_queue_send_f send, void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_ARROW_TELEMETRY_QUEUE_H_ */
@@ -0,0 +1,44 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_BSD_CONNECT_H_
+#define ACN_SDK_C_BSD_CONNECT_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <bsd/socket.h>
+#include <bsd/resolve.h>
+
+// delay in ms before the next address is tried
+// while the previous attempts are still in progress
+#if !defined(SOCK_CONNECT_DELAY)
+# define SOCK_CONNECT_DELAY 250
+#endif
+
+// resolve the host and connect a TCP socket to it
+// the resolved addresses are tried with SOCK_CONNECT_DELAY between
+// the attempts, the first connected socket is kept
+// return: the socket or -1
+int soc_connect_host(const char *host, uint16_t port, uint32_t timeout_ms);
+
+// platform hooks, the default ones use the blocking connect()
+// start the connection: 0 - connected, 1 - in progress, <0 - error
+int soc_connect_start(int sock, struct sockaddr_in *addr, uint32_t timeout_ms);
+// wait up to timeout_ms for one of the started connections
+// the failed sockets should be closed and set to -1
+// return: the index of the connected socket, -1 - not yet
+int soc_connect_wait(int *sock, int count, uint32_t timeout_ms);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_BSD_CONNECT_H_ */
@@ -0,0 +1,40 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_BSD_REACTOR_H_
+#define ACN_SDK_C_BSD_REACTOR_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+
+// max number of the watched sockets
+#if !defined(REACTOR_SIZE)
+# define REACTOR_SIZE 4
+#endif
+
+typedef void (*reactor_cb_f)(int sock, void *arg);
+
+// call the handler when the socket has data to read
+int reactor_add(int sock, reactor_cb_f cb, void *arg);
+void reactor_del(int sock);
+
+// wait up to timeout_ms for the readable sockets and run their handlers
+// epoll is used on linux (ARCH_SOCK), without it all the handlers are called
+// in turn and should wait for the data themselves (socket timeout)
+// return: the number of the handled sockets, <0 - error
+int reactor_poll(uint32_t timeout_ms);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_BSD_REACTOR_H_ */
@@ -0,0 +1,62 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_BSD_RESOLVE_H_
+#define ACN_SDK_C_BSD_RESOLVE_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+
+// max number of the kept addresses of a host
+#if !defined(SOCK_CONNECT_ADDRESSES)
+# define SOCK_CONNECT_ADDRESSES 4
+#endif
+
+// number of the cached host names, 0 - no cache
+#if !defined(SOCK_DNS_CACHE_SIZE)
+# define SOCK_DNS_CACHE_SIZE 4
+#endif
+#if !defined(SOCK_DNS_HOST_LEN)
+# define SOCK_DNS_HOST_LEN 64
+#endif
+// lifetime of the resolved and the failed names in seconds
+#if !defined(SOCK_DNS_TTL)
+# define SOCK_DNS_TTL 300
+#endif
+#if !defined(SOCK_DNS_NEG_TTL)
+# define SOCK_DNS_NEG_TTL 10
+#endif
+
+typedef struct {
+  int count;
+  uint32_t addr[SOCK_CONNECT_ADDRESSES];   // network byte order
+} soc_addr_list_t;
+
+// the IPv4 addresses of the host from the cache or gethostbyname
+// return: 0 - ok, -1 - no such host
+int soc_resolve(const char *host, soc_addr_list_t *list);
+// resolve the name in advance
+int soc_resolve_prefetch(const char *host);
+// drop the cached name (NULL - all the names)
+// f.e. if the addresses don't answer anymore
+void soc_resolve_flush(const char *host);
+
+// the cache and gethostbyname are used under this lock
+// a multithreaded platform should override these
+void soc_resolve_lock(void);
+void soc_resolve_unlock(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_BSD_RESOLVE_H_ */
@@ -17,6 +17,29 @@
 # define HTTP_CIPHER
 #endif
 
+/* keep-alive connection pool */
+#if !defined(HTTP_POOL_SIZE)
+# define HTTP_POOL_SIZE 2
+#endif
+/* idle connection lifetime in seconds, 0 - close after each request */
+#if !defined(HTTP_POOL_IDLE_TIMEOUT)
+# if defined(SINGLE_SOCKET)
+#  define HTTP_POOL_IDLE_TIMEOUT 0
+# else
+#  define HTTP_POOL_IDLE_TIMEOUT 30
+# endif
+#endif
+/* max number of the requests sent back to back on one connection */
+#if !defined(HTTP_PIPELINE_SIZE)
+# define HTTP_PIPELINE_SIZE 4
+#endif
+/* HTTP_PIPELINE_EVENT_ANS: the "received" event answer waits for the
+ * handler and goes together with the result, a round trip less but
+ * the cloud gets no receipt while the handler runs */
+#if defined(NO_HTTP_PIPELINE) && defined(HTTP_PIPELINE_EVENT_ANS)
+# undef HTTP_PIPELINE_EVENT_ANS
+#endif
+
 /* cloud connectivity */
 #if defined(HTTP_CIPHER)
 # define ARROW_SCH "https"
@@ -22,6 +22,11 @@
 #define MQTT_BUF_LEN 1200
 #endif
 
+/* yield time of the reactor handler of the MQTT socket */
+#if !defined(MQTT_REACTOR_YIELD)
+# define MQTT_REACTOR_YIELD 10
+#endif
+
 #if defined(MQTT_CIPHER)
 #  define MQTT_SCH "tls"
 #  define MQTT_PORT 8883
@@ -62,4 +67,10 @@
 #define MQTT_DUP        0
 #endif
 
+/* QoS 1/2 telemetry messages sent without waiting for the ack,
+ * 0 - mqtt_publish waits for the ack of every message */
+#if !defined(MQTT_INFLIGHT)
+# define MQTT_INFLIGHT 8
+#endif
+
 #endif // ACN_SDK_C_MQTT_CONFIG_H_
@@ -35,6 +35,16 @@ int ringbuf_clear( ring_buffer_t *buf );
 int ringbuf_push(ring_buffer_t *buf, uint8_t *s, int len);
 int ringbuf_pop(ring_buffer_t *buf, uint8_t *s, int len);
 
+// direct access to the buffer memory without a copy
+// the free contiguous space to write into, then commit the written size
+uint8_t *ringbuf_write_span(ring_buffer_t *buf, uint16_t *len);
+int ringbuf_commit(ring_buffer_t *buf, uint16_t len);
+// the contiguous data from the head, then consume the processed size
+uint8_t *ringbuf_read_span(ring_buffer_t *buf, uint16_t *len);
+int ringbuf_consume(ring_buffer_t *buf, uint16_t len);
+// move the data to the buffer beginning so the read span covers all of it
+void ringbuf_linearize(ring_buffer_t *buf);
+
 
 #if defined(__cplusplus)
 }
@@ -0,0 +1,35 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_HTTP_ASYNC_H_
+#define ACN_SDK_C_HTTP_ASYNC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <http/client.h>
+
+// status: 0 - the response is received, <0 - error
+typedef void (*http_complete_f)(http_request_t *req, http_response_t *res,
+                                int status, void *arg);
+
+// send the request on a pooled connection and return at once,
+// the response is received by reactor_poll then
+// the request should be alive until on_complete is called
+// up to HTTP_POOL_SIZE requests may be in flight
+int http_client_do_async(http_request_t *req, http_complete_f on_complete, void *arg);
+
+// number of the requests waiting for the response
+int http_async_pending(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_HTTP_ASYNC_H_ */
@@ -13,6 +13,7 @@
 #include <http/response.h>
 
 #include <data/ringbuffer.h>
+#include <time/time.h>
 
 #define LINE_CHUNK 40
 
@@ -31,6 +32,14 @@ typedef struct {
   ring_buffer_t  *queue;
   rw_func         _r_func;
   rw_func         _w_func;
+  // the endpoint the socket is connected to
+  property_t      host;
+  uint16_t        port;
+  uint8_t         is_cipher;
+  uint8_t         busy;
+  // the server closed the connection (recv 0 or a reset)
+  uint8_t         peer_closed;
+  time_t          last_used;
 } http_client_t;
 
 void http_session_close_set(http_client_t *cli, bool mode);
@@ -38,7 +47,14 @@ bool http_session_close(http_client_t *cli);
 
 void http_client_init(http_client_t *cli);
 void http_client_free(http_client_t *cli);
+void http_client_close(http_client_t *cli);
 
 int http_client_do(http_client_t *cli, http_request_t *req, http_response_t *res);
 
+// pipelining: send the requests one after another and receive
+// the responses in the same order then
+// the connection is closed on error
+int http_client_send(http_client_t *cli, http_request_t *req);
+int http_client_receive(http_client_t *cli, http_request_t *req, http_response_t *res);
+
 #endif /* ACN_SDK_C_HTTP_CLIENT_H_ */
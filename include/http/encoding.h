@@ -0,0 +1,71 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_HTTP_ENCODING_H_
+#define ACN_SDK_C_HTTP_ENCODING_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+
+// inflate window, should be a power of two
+// a server may refer up to 32K back so a less size works only
+// if the server is known to use the small window
+#if !defined(HTTP_INFLATE_WINDOW)
+# define HTTP_INFLATE_WINDOW 0x8000
+#endif
+
+// request body compression: history window (max 32K),
+// hash table size and the size of the output parts
+#if !defined(HTTP_DEFLATE_WINDOW)
+# define HTTP_DEFLATE_WINDOW 0x1000
+#endif
+#if !defined(HTTP_DEFLATE_HASH_BITS)
+# define HTTP_DEFLATE_HASH_BITS 11
+#endif
+#if !defined(HTTP_DEFLATE_OUTPUT)
+# define HTTP_DEFLATE_OUTPUT 512
+#endif
+
+typedef enum {
+  http_identity = 0,
+  http_gzip,
+  http_deflate
+} http_encoding_t;
+
+// read the next part of the encoded stream: >0 size, 0 - end of the stream, <0 - error
+typedef int (*http_enc_read_f)(void *arg, uint8_t *buf, int len);
+// write the next part of the decoded stream: <0 - error
+typedef int (*http_enc_write_f)(void *arg, uint8_t *buf, int len);
+
+http_encoding_t http_encoding_parse(const char *name);
+
+// decode the gzip or deflate (zlib) stream
+// the decoded data are written by parts no more than HTTP_INFLATE_WINDOW
+int http_inflate(http_encoding_t enc,
+                 http_enc_read_f in, void *in_arg,
+                 http_enc_write_f out, void *out_arg);
+
+// gzip compression of the stream written by parts
+// the compressed data are passed to the out function by HTTP_DEFLATE_OUTPUT bytes
+typedef struct http_deflate http_deflate_t;
+http_deflate_t *http_deflate_init(http_enc_write_f out, void *out_arg);
+int http_deflate_write(http_deflate_t *d, const uint8_t *buf, int len);
+// write the rest of the data and free the compressor
+int http_deflate_finish(http_deflate_t *d);
+
+uint32_t http_crc32(uint32_t crc, const uint8_t *buf, int len);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_HTTP_ENCODING_H_
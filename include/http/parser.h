@@ -0,0 +1,75 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_HTTP_PARSER_H_
+#define ACN_SDK_C_HTTP_PARSER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <sys/type.h>
+
+typedef enum {
+  http_parse_status = 0,  // the status line
+  http_parse_header,      // a header line
+  http_parse_done         // the empty line after the headers
+} http_parse_event_t;
+
+// the headers the client is interested in
+typedef enum {
+  http_hdr_other = 0,
+  http_hdr_content_length,
+  http_hdr_transfer_encoding,
+  http_hdr_content_type,
+  http_hdr_connection,
+  http_hdr_content_encoding
+} http_header_id_t;
+
+// a part of the parsed data, not null terminated
+typedef struct {
+  char *ptr;
+  uint16_t len;
+} http_span_t;
+
+typedef struct {
+  // current element state
+  uint8_t state;
+  uint8_t match;
+  uint16_t pos;
+  uint16_t name_end;
+  uint16_t value_start;
+  uint16_t value_end;
+  // the last parsed element
+  uint8_t event;        // http_parse_event_t
+  uint8_t minor;        // HTTP/1.x version
+  uint16_t status;
+  uint8_t id;           // http_header_id_t
+  http_span_t name;     // empty for a folded header line
+  http_span_t value;
+} http_parser_t;
+
+void http_parser_init(http_parser_t *p);
+
+// parse the next element (the status line or a header) from the buf
+// the buf should start at the element beginning, the already parsed
+// part isn't scanned again so the same data can be passed with the new
+// tail appended (the buf itself may move)
+// return: the element size to consume, 0 - more data needed, -1 - error
+int http_parser_execute(http_parser_t *p, char *buf, int len);
+
+// the comma separated list contains the token (case insensitive)
+int http_span_has_token(http_span_t *s, const char *token);
+// decimal value: 0 - ok, -1 - not a number
+int http_span_to_uint(http_span_t *s, uint32_t *val);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_HTTP_PARSER_H_ */
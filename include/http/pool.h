@@ -0,0 +1,35 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_HTTP_POOL_H_
+#define ACN_SDK_C_HTTP_POOL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <http/client.h>
+
+// get a client connected (or ready to connect) to the request endpoint
+// an idle keep-alive connection to the same host:port:scheme is reused
+http_client_t *http_pool_acquire(http_request_t *req);
+// return the client into the pool after the request
+void http_pool_release(http_client_t *cli);
+// the last used client
+http_client_t *http_pool_current(void);
+// close all of the idle connections
+void http_pool_close_all(void);
+
+// check that an idle socket still can be used (platform dependent)
+int http_pool_sock_alive(int sock);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_HTTP_POOL_H_
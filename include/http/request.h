@@ -48,8 +48,16 @@ typedef int(*__payload_handler)(void *,property_t,int);
 typedef struct __payload_meth {
   __payload_handler _p_set_handler;
   __payload_handler _p_add_handler;
+  void *arg;  // the handler data, it's in the response _p_meth as well
 } _payload_meth_t;
 
+// the request payload producer
+// fill up to len bytes of the buf with the next part of the payload
+// buf == NULL - start the payload again from the beginning
+// (it is read once for the signature and once more to send)
+// return: the size of the part, 0 - the end of the payload, <0 - error
+typedef int (*http_payload_producer_f)(void *arg, uint8_t *buf, int len);
+
 typedef struct __attribute_packed__ {
     property_t meth;
     property_t scheme;
@@ -59,11 +67,16 @@ typedef struct __attribute_packed__ {
     int8_t is_corrupt;
     int8_t is_cipher;
     int8_t is_chunked;
+    // compress the payload (Content-Encoding: gzip, chunked transfer)
+    int8_t is_gzip;
     property_map_t *header;
     property_map_t content_type;
     property_map_t *query;
     http_payload_t payload;
     _payload_meth_t _response_payload_meth;
+    // the payload is pulled by parts instead of payload.buf
+    http_payload_producer_f payload_producer;
+    void *payload_arg;
 } http_request_t;
 
 void http_request_init(http_request_t *req, int meth, const char *url);
@@ -73,6 +86,10 @@ void http_request_add_query(http_request_t *req, property_t key, property_t valu
 void http_request_set_content_type(http_request_t *req, property_t value);
 property_map_t *http_request_first_header(http_request_t *req);
 void http_request_set_payload(http_request_t *req, property_t payload);
+// stream the payload from the producer (chunked transfer)
+void http_request_set_payload_producer(http_request_t *req,
+                                       http_payload_producer_f producer,
+                                       void *arg);
 int http_request_set_findby(http_request_t *req, find_by_t *fb);
 
 #endif /* HTTPCLIENT_REQUEST_H_ */
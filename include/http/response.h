@@ -22,6 +22,7 @@ typedef struct {
     http_payload_t payload;
     _payload_meth_t _p_meth;
     int processed_payload_chunk;
+    uint8_t content_encoding;
 } http_response_t;
 
 void http_response_init(http_response_t *req, _payload_meth_t *handler);
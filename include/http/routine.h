@@ -22,6 +22,21 @@ typedef int (*response_proc_f)(http_response_t *response, void *arg);
 int __http_routine(response_init_f req_init, void *arg_init,
                    response_proc_f resp_proc, void *arg_proc);
 
+typedef struct {
+  response_init_f req_init;
+  void *arg_init;
+  response_proc_f resp_proc;
+  void *arg_proc;
+  int ret;
+} http_routine_t;
+
+// send the requests back to back on one connection and process the responses
+// in the same order; a request without the response is repeated on a new
+// connection so the requests should be idempotent
+// return: the number of the leading routines processed successfully,
+// the result of each one is in its ret
+int __http_routine_pipeline(http_routine_t *r, int count);
+
 #define STD_ROUTINE(init, i_arg, proc, p_arg, ...) { \
   int ret = __http_routine(init, i_arg, proc, p_arg); \
   if ( ret < 0 ) { \
@@ -0,0 +1,38 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_JSON_DTOA_H_
+#define ACN_SDK_C_JSON_DTOA_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <sys/type.h>
+
+// the buffer size enough for any number
+#define JSON_DTOA_SIZE 32
+
+// the shortest text that reads back as the same double (Grisu2),
+// the integers up to 2^53 are written without the fraction and exponent
+// the text doesn't depend on the locale
+// return: the text length or -1 for NaN and infinity
+int json_dtoa(double v, char *buf);
+
+// the integer, return the text length
+int json_itoa(int64_t v, char *buf);
+
+// the same text as printf("%.*f", prec, v), prec is up to 9
+// return: the text length or -1 if it doesn't fit the size
+int json_dtoa_fixed(double v, int prec, char *buf, int size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_JSON_DTOA_H_ */
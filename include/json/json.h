@@ -41,6 +41,16 @@ typedef enum {
 
 typedef struct JsonNode JsonNode;
 
+/*
+ * Member lookup index of an object: an open-addressed hash table built
+ * by json_find_member (or by the arena decoders) for the objects with at
+ * least JSON_INDEX_MIN members. Any change of the members drops it.
+ */
+#if !defined(JSON_INDEX_MIN)
+# define JSON_INDEX_MIN 8
+#endif
+typedef struct JsonIndex JsonIndex;
+
 struct JsonNode
 {
 	/* only if parent is an object or array (NULL otherwise) */
@@ -51,6 +61,8 @@ struct JsonNode
 	char *key; /* Must be valid UTF-8. */
 	
 	JsonTag tag;
+	/* allocated from an arena: freed only with the arena */
+	bool arena_;
   union {
 		/* JSON_BOOL */
 		bool bool_;
@@ -65,14 +77,56 @@ struct JsonNode
 		/* JSON_OBJECT */
 		struct {
 			JsonNode *head, *tail;
+#if !defined(NO_JSON_INDEX)
+			/* JSON_OBJECT only, NULL until the first lookup */
+			JsonIndex *index;
+#endif
 		} children;
   };
 };
 
+/*** Arena ***/
+
+/*
+ * The nodes, keys and strings are bump-allocated from a few large blocks
+ * and freed all at once by json_arena_free. json_delete of an arena node
+ * only unlinks it. Don't mix the heap and the arena nodes in one tree.
+ */
+#if !defined(JSON_ARENA_BLOCK)
+# define JSON_ARENA_BLOCK 1024
+#endif
+
+typedef struct json_arena_block {
+	struct json_arena_block *next;
+	size_t size;
+	size_t used;
+} json_arena_block_t;
+
+typedef struct {
+	json_arena_block_t *head;
+	size_t block_size;
+} json_arena_t;
+
+/* block_size 0 - JSON_ARENA_BLOCK */
+void        json_arena_init     (json_arena_t *arena, size_t block_size);
+void        json_arena_free     (json_arena_t *arena);
+
 /*** Encoding, decoding, and validation ***/
 
 JsonNode   *json_decode         (const char *json);
+JsonNode   *json_decode_arena   (json_arena_t *arena, const char *json);
+/*
+ * Destructive decoding: the strings are unescaped inside @json and the
+ * nodes point there, only the nodes take the arena memory (required).
+ * @json should live as long as the tree.
+ */
+JsonNode   *json_decode_insitu  (json_arena_t *arena, char *json);
 char       *json_encode         (const JsonNode *node);
+/*
+ * Encode into the caller buffer, @cap includes the null terminator.
+ * Returns the text length or -1 if it doesn't fit.
+ */
+int         json_encode_into    (const JsonNode *node, char *buf, int cap);
 char       *json_encode_string  (const char *str);
 char       *json_stringify      (const JsonNode *node, const char *space);
 void        json_delete         (JsonNode *node);
@@ -100,13 +154,26 @@ JsonNode *json_mknumber(double n);
 JsonNode *json_mkarray(void);
 JsonNode *json_mkobject(void);
 
+/* the arena versions, arena NULL - the heap */
+JsonNode *json_arena_mknull(json_arena_t *arena);
+JsonNode *json_arena_mkbool(json_arena_t *arena, bool b);
+JsonNode *json_arena_mkstring(json_arena_t *arena, const char *s);
+JsonNode *json_arena_mknumber(json_arena_t *arena, double n);
+JsonNode *json_arena_mkarray(json_arena_t *arena);
+JsonNode *json_arena_mkobject(json_arena_t *arena);
+
 void json_append_element(JsonNode *array, JsonNode *element);
 void json_prepend_element(JsonNode *array, JsonNode *element);
 void json_append_member(JsonNode *object, const char *key, JsonNode *value);
 void json_prepend_member(JsonNode *object, const char *key, JsonNode *value);
+/* the key is copied to the arena */
+void json_arena_append_member(json_arena_t *arena, JsonNode *object, const char *key, JsonNode *value);
 
 void json_remove_from_parent(JsonNode *node);
 
+/* the deep copy on the heap (to keep a part of an arena tree) */
+JsonNode *json_copy(const JsonNode *node);
+
 /*** Debugging ***/
 
 /*
@@ -0,0 +1,90 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_JSON_SAX_H_
+#define ACN_SDK_C_JSON_SAX_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <sys/type.h>
+
+// max size of a string or a number value (the longer strings are cut)
+#if !defined(JSON_SAX_VALUE_SIZE)
+# define JSON_SAX_VALUE_SIZE 256
+#endif
+
+// max size of a member key (the longer keys are cut)
+#if !defined(JSON_SAX_KEY_SIZE)
+# define JSON_SAX_KEY_SIZE 64
+#endif
+
+// max nesting level (up to 32)
+#if !defined(JSON_SAX_DEPTH)
+# define JSON_SAX_DEPTH 16
+#endif
+
+typedef enum {
+  json_sax_null = 0,
+  json_sax_bool,
+  json_sax_string,
+  json_sax_number,
+  json_sax_object_start,
+  json_sax_object_end,
+  json_sax_array_start,
+  json_sax_array_end
+} json_sax_event_t;
+
+typedef struct json_sax json_sax_t;
+
+// called for every value, the event data is in the parser:
+// key - the member name of the value (empty in an array, valid for
+//       the scalars and the container start)
+// depth - the number of the containers around the value
+// return: <0 - stop the parsing
+typedef int (*json_sax_cb_f)(json_sax_t *p, json_sax_event_t ev, void *arg);
+
+struct json_sax {
+  json_sax_cb_f cb;
+  void *arg;
+  // current element state
+  uint8_t state;
+  uint8_t is_key;
+  uint8_t hex_n;
+  uint8_t lit_pos;
+  const char *lit;
+  uint16_t hex;
+  uint16_t high;        // the first half of a surrogate pair
+  uint16_t key_len;
+  uint16_t len;
+  uint32_t stack;       // bit per level: 1 - object, 0 - array
+  // the event data
+  int depth;
+  int truncated;        // the value (or key) is longer than the buffer
+  int bool_;
+  double number;
+  char key[JSON_SAX_KEY_SIZE];
+  char value[JSON_SAX_VALUE_SIZE];  // a string or the number text
+};
+
+void json_sax_init(json_sax_t *p, json_sax_cb_f cb, void *arg);
+
+// parse the next part of the text, the parts may be split anywhere
+// return: 0 - ok, -1 - a syntax error or stopped by the callback
+int json_sax_feed(json_sax_t *p, const char *buf, int len);
+
+// the end of the text
+// return: 0 - the whole value is parsed, -1 - otherwise
+int json_sax_finish(json_sax_t *p);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_JSON_SAX_H_ */
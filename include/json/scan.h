@@ -0,0 +1,38 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_JSON_SCAN_H_
+#define ACN_SDK_C_JSON_SCAN_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// the string scanners use SSE2 or NEON when the compiler targets them
+// and a word at a time otherwise; NO_JSON_SIMD keeps the word version only
+#if !defined(NO_JSON_SIMD)
+# if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#  define JSON_SCAN_SSE2
+# elif defined(__ARM_NEON) && defined(__ARM_ARCH_ISA_A64)
+#  define JSON_SCAN_NEON
+# endif
+#endif
+
+// the length of the printable ASCII run (0x20..0x7F) at the start of s
+// the null terminated string is never read past its aligned block
+int json_scan_ascii(const char *s);
+
+// the same but the run stops at '"' and '\\' too:
+// the string literal part that is copied as is
+int json_scan_plain(const char *s);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_JSON_SCAN_H_ */
@@ -17,6 +17,15 @@ extern "C" {
     
 char *telemetry_serialize(arrow_device_t *device, void *data);
 
+// serialize into the buffer without the heap (json_encode_into),
+// the default one returns -1 and the caller takes telemetry_serialize
+// return: the text length or -1
+int telemetry_serialize_into(arrow_device_t *device, void *data, char *buf, int size);
+
+// the record of the array by the index, stride - the record size
+#define telemetry_record(data, i, stride) \
+  ((void *)((uint8_t *)(data) + (size_t)(i) * (size_t)(stride)))
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,75 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_JSON_WRITER_H_
+#define ACN_SDK_C_JSON_WRITER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <sys/type.h>
+#include <json/json.h>
+
+// max nesting level (up to 32)
+#if !defined(JSON_WRITER_DEPTH)
+# define JSON_WRITER_DEPTH 16
+#endif
+
+// take the full buffer: return <0 to stop the writing
+typedef int (*json_writer_flush_f)(void *arg, const char *buf, int len);
+
+typedef struct json_writer {
+  char *buf;
+  int size;
+  int len;
+  json_writer_flush_f flush;
+  void *arg;
+  int total;        // the text size written so far
+  int depth;
+  uint32_t object;  // bit per level: 1 - object, 0 - array
+  uint32_t first;   // bit per level: no elements yet
+  int key;          // a member key is written, the value is expected
+  int err;
+} json_writer_t;
+
+// write into the buffer, the text is null terminated by json_writer_finish
+// buf == NULL - count the text size only
+void json_writer_init(json_writer_t *w, char *buf, int size);
+// write through the buffer: it's passed to flush every time it's full
+void json_writer_init_flush(json_writer_t *w, char *buf, int size,
+                            json_writer_flush_f flush, void *arg);
+
+// the errors are sticky, it's enough to check the finish result
+int json_write_begin_object(json_writer_t *w);
+int json_write_end_object(json_writer_t *w);
+int json_write_begin_array(json_writer_t *w);
+int json_write_end_array(json_writer_t *w);
+int json_write_key(json_writer_t *w, const char *key);
+int json_write_string(json_writer_t *w, const char *s);
+int json_write_number(json_writer_t *w, double n);
+int json_write_bool(json_writer_t *w, int b);
+int json_write_null(json_writer_t *w);
+// a ready JSON subtree
+int json_write_node(json_writer_t *w, const JsonNode *node);
+
+#define json_write_member(w, k, type, v) \
+  ( json_write_key((w), (k)) < 0 ? -1 : json_write_##type((w), (v)) )
+
+// return: the text size or -1 if it's incomplete or doesn't fit
+int json_writer_finish(json_writer_t *w);
+
+// measure the text and write it into a new heap string of the exact size
+typedef int (*json_write_f)(json_writer_t *w, void *arg);
+char *json_write_alloc(json_write_f write, void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ACN_SDK_C_JSON_WRITER_H_ */
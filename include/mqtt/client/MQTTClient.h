@@ -87,6 +87,20 @@ typedef struct MessageData {
 
 typedef void (*messageHandler)(MessageData*);
 
+/* the ack of a pipelined publish came (MQTT_SUCCESS) or it was dropped (FAILURE) */
+typedef void (*publishDone)(void* arg, unsigned short id, int rc);
+
+/* a QoS 1/2 publish waiting for the ack */
+typedef struct MQTTInflight {
+    unsigned short id;          /* 0 - the slot is free */
+    unsigned char qos;
+    unsigned char released;     /* QoS 2: PUBREC came and PUBREL is sent */
+    unsigned char* packet;      /* the PUBLISH copy to send again with DUP */
+    int len;
+    publishDone done;
+    void* arg;
+} MQTTInflight;
+
 typedef struct MQTTClient {
     unsigned short int next_packetid;
     unsigned int command_timeout_ms;
@@ -108,6 +122,8 @@ typedef struct MQTTClient {
 
     Network* ipstack;
     TimerInterval ping_timer;
+    MQTTInflight* inflight;
+    int inflight_size;
 #if defined(MQTT_TASK)
 	Mutex mutex;
 	Thread thread;
@@ -142,6 +158,40 @@ DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
  */
 DLLExport int MQTTPublish(MQTTClient* client, const char*, MQTTMessage*);
 
+/** MQTT Inflight - give the client a table for the pipelined publishes.
+ *  The table is zeroed by the caller once and outlives the reconnects:
+ *  MQTTClientInit detaches it, the new session takes it again by this call
+ *  and MQTTConnect sends the pending messages again with DUP.
+ *  @param client - the client object to use
+ *  @param table - the slots, one per outstanding packet id
+ *  @param size - the window size
+ */
+DLLExport void MQTTSetInflight(MQTTClient* client, MQTTInflight* table, int size);
+
+/** MQTT Publish Async - send an MQTT publish packet without waiting for the ack.
+ *  A QoS 1/2 message takes a slot of the in-flight table until its ack comes,
+ *  the call waits (reading the acks) only while the window is full.
+ *  Without the table it waits for the ack like MQTTPublish.
+ *  @param client - the client object to use
+ *  @param topic - the topic to publish to
+ *  @param message - the message to send, message->id is set to the packet id
+ *  @param done - called when the message is complete, NULL - no call
+ *  @param arg - the done argument
+ *  @return success code
+ */
+DLLExport int MQTTPublishAsync(MQTTClient* client, const char*, MQTTMessage*, publishDone done, void* arg);
+
+/** MQTT Inflight Count - the number of the messages waiting for the ack
+ *  @param client - the client object to use
+ *  @return the count
+ */
+DLLExport int MQTTInflightCount(MQTTClient* client);
+
+/** MQTT Inflight Abort - drop all the pending messages, their done gets FAILURE
+ *  @param client - the client object to use
+ */
+DLLExport void MQTTInflightAbort(MQTTClient* client);
+
 /** MQTT Subscribe - send an MQTT subscribe packet and wait for suback before returning.
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter to subscribe to
@@ -29,10 +29,22 @@
 #include <time/time.h>
 #include <bsd/socket.h>
 
+// the socket data is read by blocks into the receive buffer
+// and the packets are framed from there
+#if !defined(MQTT_RECV_BUF_LEN)
+# define MQTT_RECV_BUF_LEN 256
+#endif
+
 typedef struct Network {
     int my_socket;
     int (*mqttread) (struct Network*, unsigned char*, int, int);
     int (*mqttwrite) (struct Network*, unsigned char*, int, int);
+    int timeout_ms;     // the receive timeout set on the socket (a power of two), -1 - unknown
+#if !defined(NO_MQTT_RECV_BUF)
+    unsigned char rx[MQTT_RECV_BUF_LEN];
+    int rx_pos;
+    int rx_len;
+#endif
 } Network;
 
 typedef struct TimerInterval {
@@ -48,5 +60,8 @@ int TimerLeftMS(TimerInterval*);
 DLLExport void NetworkInit(Network*);
 DLLExport int NetworkConnect(Network*, char*, int);
 DLLExport void NetworkDisconnect(Network*);
+// the bytes already received but not read yet:
+// they don't make the socket readable again
+DLLExport int NetworkPending(Network*);
 
 #endif /* ACN_SDK_C_MQTT_NETWORK_H_ */
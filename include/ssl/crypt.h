@@ -9,7 +9,12 @@
 #ifndef _ARROW_INCLUDE_CRYPT_SHA256_H_
 #define _ARROW_INCLUDE_CRYPT_SHA256_H_
 
+#include <sys/type.h>
+
 void sha256(char *shasum, char *buf, int size);
+// hash the data pulled part by part until the read function returns 0
+// return: 0 - ok, <0 - the read error
+int sha256_stream(char *shasum, int (*read)(void *arg, uint8_t *buf, int len), void *arg);
 void hmac256(char *hmacdig, const char *key, int key_size, const char *buf, int buf_size);
 
 #endif // _ARROW_INCLUDE_CRYPT_SHA256_H_
@@ -3,6 +3,7 @@
 #include <sys/mem.h>
 #include <debug.h>
 #include <data/chunk.h>
+#include <json/writer.h>
 
 #define URI_LEN sizeof(ARROW_API_DEVICE_ENDPOINT) + 50
 
@@ -11,6 +12,18 @@ struct _dev_model {
   dev_action_model_t *model;
 };
 
+static int _device_action_write(json_writer_t *w, void *arg) {
+  dev_action_model_t *model = (dev_action_model_t *)arg;
+  json_write_begin_object(w);
+  json_write_member(w, "criteria", string, model->criteria);
+  json_write_member(w, "description", string, model->description);
+  json_write_member(w, "enabled", bool, model->enabled);
+  json_write_member(w, "expiration", number, model->expiration);
+  json_write_member(w, "index", number, model->index);
+  json_write_member(w, "systemName", string, model->systemName);
+  return json_write_end_object(w);
+}
+
 static void _device_action_create_init(http_request_t *request, void *arg) {
   struct _dev_model *dm = (struct _dev_model *)arg;
   CREATE_CHUNK(uri, URI_LEN);
@@ -20,17 +33,8 @@ static void _device_action_create_init(http_request_t *request, void *arg) {
   strcat(uri, "/actions");
   http_request_init(request, POST, uri);
   FREE_CHUNK(uri);
-  JsonNode *_main = json_mkobject();
-  json_append_member(_main, "criteria", json_mkstring(dm->model->criteria));
-  json_append_member(_main, "description", json_mkstring(dm->model->description));
-  json_append_member(_main, "enabled", json_mkbool(dm->model->enabled));
-  json_append_member(_main, "expiration", json_mknumber(dm->model->expiration));
-  json_append_member(_main, "index", json_mknumber(dm->model->index));
-//  json_append_member(_main, "", json_mkstring(dm->model));
-  json_append_member(_main, "systemName", json_mkstring(dm->model->systemName));
-  char *payload = json_encode(_main);
+  char *payload = json_write_alloc(_device_action_write, dm->model);
   http_request_set_payload(request, p_heap(payload));
-  json_delete(_main);
 }
 
 int arrow_create_device_action(arrow_device_t *dev, dev_action_model_t *model) {
@@ -115,17 +119,8 @@ static void _device_action_update_init(http_request_t *request, void *arg) {
            P_VALUE(dm->device->hid), dm->model->index);
   http_request_init(request, PUT, uri);
   FREE_CHUNK(uri);
-  JsonNode *_main = json_mkobject();
-  json_append_member(_main, "criteria", json_mkstring(dm->model->criteria));
-  json_append_member(_main, "description", json_mkstring(dm->model->description));
-  json_append_member(_main, "enabled", json_mkbool(dm->model->enabled));
-  json_append_member(_main, "expiration", json_mknumber(dm->model->expiration));
-  json_append_member(_main, "index", json_mknumber(dm->model->index));
-//  json_append_member(_main, "", json_mkstring(dm->model));
-  json_append_member(_main, "systemName", json_mkstring(dm->model->systemName));
-  char *payload = json_encode(_main);
+  char *payload = json_write_alloc(_device_action_write, dm->model);
   http_request_set_payload(request, p_heap(payload));
-  json_delete(_main);
 }
 
 
@@ -46,7 +46,7 @@ static void _device_find_by_init(http_request_t *request, void *arg) {
 static int _device_find_by_proc(http_response_t *response, void *arg) {
     device_info_t **devs = (device_info_t **)arg;
     *devs = NULL;
-    return device_info_parse(devs, P_VALUE(response->payload.buf));
+    return device_info_parse_insitu(devs, P_VALUE(response->payload.buf));
 }
 
 int arrow_device_find_by(device_info_t **list, int n, ...) {
@@ -9,36 +9,40 @@
 #include "arrow/api/device/event.h"
 #include <arrow/api/json/parse.h>
 
+static const json_field_t _device_event_field[] = {
+    JSON_FIELD_WHO_WHEN(device_event_t, created, "created"),
+    JSON_FIELD(device_event_t, criteria, json_field_string),
+    JSON_FIELD(device_event_t, deviceActionTypeName, json_field_string),
+    JSON_FIELD(device_event_t, status, json_field_string)
+};
+static JSON_FIELDS(_device_event_fields, _device_event_field);
+
 void device_event_init(device_event_t *de) {
-    who_when_init(&de->created);
-    property_init(&de->criteria);
-    property_init(&de->deviceActionTypeName);
-    property_init(&de->status);
+    json_fields_init(&_device_event_fields, de);
 }
 
 void device_event_free(device_event_t *de) {
-    who_when_free(&de->created);
-    property_free(&de->criteria);
-    property_free(&de->deviceActionTypeName);
-    property_free(&de->status);
+    json_fields_free(&_device_event_fields, de);
 }
 
 int device_event_parse(device_event_t **list, const char *text) {
-    JsonNode *_main = json_decode(text);
-    if ( !_main ) return -1;
+    json_arena_t arena;
+    json_arena_init(&arena, 0);
+    JsonNode *_main = json_decode_arena(&arena, text);
+    if ( !_main ) {
+        json_arena_free(&arena);
+        return -1;
+    }
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             device_event_t *de = (device_event_t *)malloc(sizeof(device_event_t));
             device_event_init(de);
-            who_when_parse(tmp, &de->created, "createdDate", "createdBy");
-            json_fill_property(tmp, de, criteria);
-            json_fill_property(tmp, de, deviceActionTypeName);
-            json_fill_property(tmp, de, status);
+            json_fields_parse(&_device_event_fields, de, tmp);
             linked_list_add_node_last(*list, device_event_t, de);
         }
     }
-    json_delete(_main);
+    json_arena_free(&arena);
     return 0;
 }
@@ -8,71 +8,45 @@
 
 #include <arrow/api/device/info.h>
 
+static const json_field_t _device_info_field[] = {
+    JSON_FIELD_WHO_WHEN(device_info_t, created, "created"),
+    JSON_FIELD_WHO_WHEN(device_info_t, lastModified, "lastModified"),
+    JSON_FIELD(device_info_t, hid, json_field_string),
+    JSON_FIELD(device_info_t, uid, json_field_string),
+    JSON_FIELD(device_info_t, name, json_field_string),
+    JSON_FIELD(device_info_t, type, json_field_string),
+    JSON_FIELD(device_info_t, gatewayHid, json_field_string),
+    JSON_FIELD(device_info_t, enabled, json_field_bool),
+    JSON_FIELD(device_info_t, info, json_field_node),
+    JSON_FIELD(device_info_t, properties, json_field_node)
+};
+static JSON_FIELDS(_device_info_fields, _device_info_field);
+
 void device_info_init(device_info_t *gd) {
-    who_when_init(&gd->created);
-    who_when_init(&gd->lastModified);
-    property_init(&gd->hid);
-    property_init(&gd->uid);
-    property_init(&gd->name);
-    property_init(&gd->type);
-    property_init(&gd->gatewayHid);
-    gd->enabled = 0;
-    gd->info = NULL;
-    gd->properties = NULL;
+    json_fields_init(&_device_info_fields, gd);
 }
 
 void device_info_free(device_info_t *gd) {
-    who_when_free(&gd->created);
-    who_when_free(&gd->lastModified);
-    property_free(&gd->hid);
-    property_free(&gd->uid);
-    property_free(&gd->name);
-    property_free(&gd->type);
-    property_free(&gd->gatewayHid);
-    gd->enabled = 0;
-    json_delete(gd->info);
-    json_delete(gd->properties);
+    json_fields_free(&_device_info_fields, gd);
 }
 
 void device_info_move(device_info_t *dst, device_info_t *src) {
-    who_when_move(&dst->created, &src->created);
-    who_when_move(&dst->lastModified, &src->lastModified);
-    property_move(&dst->hid, &src->hid);
-    property_move(&dst->uid, &src->uid);
-    property_move(&dst->name, &src->name);
-    property_move(&dst->type, &src->type);
-    property_move(&dst->gatewayHid, &src->gatewayHid);
-    dst->enabled = src->enabled;
-    dst->info = src->info;
-    src->info = NULL;
-    dst->properties = src->properties;
-    src->properties = NULL;
+    json_fields_move(&_device_info_fields, dst, src);
 }
 
 int _device_info_parse(device_info_t *gd, JsonNode *tmp) {
     device_info_init(gd);
-    who_when_parse(tmp, &gd->created, "createdDate", "createdBy");
-    who_when_parse(tmp, &gd->lastModified, "lastModifiedDate", "lastModifiedBy");
-    json_fill_property(tmp, gd, hid);
-    json_fill_property(tmp, gd, uid);
-    json_fill_property(tmp, gd, name);
-    json_fill_property(tmp, gd, type);
-    json_fill_property(tmp, gd, gatewayHid);
-    JsonNode *t = json_find_member(tmp, "enabled");
-    if ( t && t->tag == JSON_BOOL )
-        gd->enabled = t->bool_;
-    t = json_find_member(tmp, "info");
-    json_remove_from_parent(t);
-    gd->info = t;
-    t = json_find_member(tmp, "properties");
-    json_remove_from_parent(t);
-    gd->properties = t;
-    return 0;
+    return json_fields_parse(&_device_info_fields, gd, tmp);
 }
 
-int device_info_parse(device_info_t **list, const char *s) {
-    JsonNode *_main = json_decode(s);
-    if ( !_main ) return -1;
+static int _device_info_list_parse(device_info_t **list, char *s, int insitu) {
+    json_arena_t arena;
+    json_arena_init(&arena, 0);
+    JsonNode *_main = insitu ? json_decode_insitu(&arena, s) : json_decode_arena(&arena, s);
+    if ( !_main ) {
+        json_arena_free(&arena);
+        return -1;
+    }
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
         JsonNode *tmp = NULL;
@@ -82,6 +56,14 @@ int device_info_parse(device_info_t **list, const char *s) {
             linked_list_add_node_last(*list, device_info_t, gd);
         }
     }
-    json_delete(_main);
+    json_arena_free(&arena);
     return 0;
 }
+
+int device_info_parse(device_info_t **list, const char *s) {
+    return _device_info_list_parse(list, (char *)s, 0);
+}
+
+int device_info_parse_insitu(device_info_t **list, char *s) {
+    return _device_info_list_parse(list, s, 1);
+}
@@ -175,7 +175,7 @@ static void _gateway_find_init(http_request_t *request, void *arg) {
 static int _gateway_find_proc(http_response_t *response, void *arg) {
     gateway_info_t *info = (gateway_info_t *)arg;
     gateway_info_t *list;
-    int ret = gateway_info_parse(&list, P_VALUE(response->payload.buf));
+    int ret = gateway_info_parse_insitu(&list, P_VALUE(response->payload.buf));
     if ( ret < 0 ) return -1;
     if ( list ) {
         gateway_info_move(info, list);
@@ -203,7 +203,7 @@ static void _gateway_find_by_init(http_request_t *request, void *arg) {
 static int _gateway_find_by_proc(http_response_t *response, void *arg) {
   gateway_info_t **info = (gateway_info_t **)arg;
   *info = NULL;
-  return gateway_info_parse(info, P_VALUE(response->payload.buf));
+  return gateway_info_parse_insitu(info, P_VALUE(response->payload.buf));
 }
 
 
@@ -260,7 +260,7 @@ static void _gateway_devices_list_init(http_request_t *request, void *arg) {
 static int _gateway_devices_list_proc(http_response_t *response, void *arg) {
     device_info_t **devs = (device_info_t **)arg;
     *devs = NULL;
-    return device_info_parse(devs, P_VALUE(response->payload.buf));
+    return device_info_parse_insitu(devs, P_VALUE(response->payload.buf));
 }
 
 int arrow_gateway_devices_list(device_info_t **list, const char *hid) {
@@ -8,83 +8,62 @@
 
 #include "arrow/api/gateway/info.h"
 
+static const json_field_t _gateway_info_field[] = {
+    JSON_FIELD_WHO_WHEN(gateway_info_t, created, "created"),
+    JSON_FIELD_WHO_WHEN(gateway_info_t, lastModified, "lastModified"),
+    JSON_FIELD(gateway_info_t, hid, json_field_string),
+    JSON_FIELD(gateway_info_t, applicationHid, json_field_string),
+    JSON_FIELD(gateway_info_t, userHid, json_field_string),
+    JSON_FIELD(gateway_info_t, pri, json_field_string),
+    JSON_FIELD(gateway_info_t, uid, json_field_string),
+    JSON_FIELD(gateway_info_t, name, json_field_string),
+    JSON_FIELD(gateway_info_t, type, json_field_string),
+    JSON_FIELD(gateway_info_t, deviceType, json_field_string),
+    JSON_FIELD(gateway_info_t, osName, json_field_string),
+    JSON_FIELD(gateway_info_t, sdkVersion, json_field_string),
+    JSON_FIELD(gateway_info_t, softwareName, json_field_string),
+    JSON_FIELD(gateway_info_t, softwareVersion, json_field_string)
+};
+static JSON_FIELDS(_gateway_info_fields, _gateway_info_field);
+
 void gateway_info_init(gateway_info_t *gd) {
-    who_when_init(&gd->created);
-    who_when_init(&gd->lastModified);
-    property_init(&gd->applicationHid);
-    property_init(&gd->deviceType);
-    property_init(&gd->hid);
-    property_init(&gd->name);
-    property_init(&gd->osName);
-    property_init(&gd->pri);
-    property_init(&gd->sdkVersion);
-    property_init(&gd->softwareName);
-    property_init(&gd->softwareVersion);
-    property_init(&gd->type);
-    property_init(&gd->uid);
-    property_init(&gd->userHid);
+    json_fields_init(&_gateway_info_fields, gd);
 }
 
 void gateway_info_free(gateway_info_t *gd) {
-    who_when_free(&gd->created);
-    who_when_free(&gd->lastModified);
-    property_free(&gd->applicationHid);
-    property_free(&gd->deviceType);
-    property_free(&gd->hid);
-    property_free(&gd->name);
-    property_free(&gd->osName);
-    property_free(&gd->pri);
-    property_free(&gd->sdkVersion);
-    property_free(&gd->softwareName);
-    property_free(&gd->softwareVersion);
-    property_free(&gd->type);
-    property_free(&gd->uid);
-    property_free(&gd->userHid);
+    json_fields_free(&_gateway_info_fields, gd);
 }
 
 void gateway_info_move(gateway_info_t *dst, gateway_info_t *src) {
-    who_when_move(&dst->created, &src->created);
-    who_when_move(&dst->lastModified, &src->lastModified);
-    property_move(&dst->applicationHid, &src->applicationHid);
-    property_move(&dst->deviceType, &src->deviceType);
-    property_move(&dst->hid, &src->hid);
-    property_move(&dst->name, &src->name);
-    property_move(&dst->osName, &src->osName);
-    property_move(&dst->pri, &src->pri);
-    property_move(&dst->sdkVersion, &src->sdkVersion);
-    property_move(&dst->softwareName, &src->softwareName);
-    property_move(&dst->softwareVersion, &src->softwareVersion);
-    property_move(&dst->type, &src->type);
-    property_move(&dst->uid, &src->uid);
-    property_move(&dst->userHid, &src->userHid);
+    json_fields_move(&_gateway_info_fields, dst, src);
 }
 
-int gateway_info_parse(gateway_info_t **list, const char *s) {
-    JsonNode *_main = json_decode(s);
-    if ( !_main ) return -1;
+static int _gateway_info_parse(gateway_info_t **list, char *s, int insitu) {
+    json_arena_t arena;
+    json_arena_init(&arena, 0);
+    JsonNode *_main = insitu ? json_decode_insitu(&arena, s) : json_decode_arena(&arena, s);
+    if ( !_main ) {
+        json_arena_free(&arena);
+        return -1;
+    }
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             gateway_info_t *gi = (gateway_info_t *)malloc(sizeof(gateway_info_t));
             gateway_info_init(gi);
-            who_when_parse(tmp, &gi->created, "createdDate", "createdBy");
-            who_when_parse(tmp, &gi->lastModified, "lastModifiedDate", "lastModifiedBy");
-            json_fill_property(tmp, gi, hid);
-            json_fill_property(tmp, gi, applicationHid);
-            json_fill_property(tmp, gi, userHid);
-            json_fill_property(tmp, gi, pri);
-            json_fill_property(tmp, gi, uid);
-            json_fill_property(tmp, gi, name);
-            json_fill_property(tmp, gi, type);
-            json_fill_property(tmp, gi, deviceType);
-            json_fill_property(tmp, gi, osName);
-            json_fill_property(tmp, gi, sdkVersion);
-            json_fill_property(tmp, gi, softwareName);
-            json_fill_property(tmp, gi, softwareVersion);
+            json_fields_parse(&_gateway_info_fields, gi, tmp);
             linked_list_add_node_last(*list, gateway_info_t, gi);
         }
     }
-    json_delete(_main);
+    json_arena_free(&arena);
     return 0;
 }
+
+int gateway_info_parse(gateway_info_t **list, const char *s) {
+    return _gateway_info_parse(list, (char *)s, 0);
+}
+
+int gateway_info_parse_insitu(gateway_info_t **list, char *s) {
+    return _gateway_info_parse(list, s, 1);
+}
@@ -58,3 +58,171 @@ int who_when_parse(JsonNode *tmp, who_when_t *ww, const char *date, const char *
         property_copy( &ww->by, p_stack(t->string_));
     return 0;
 }
+
+JsonNode *json_keep_node(JsonNode *node) {
+    if ( !node ) return NULL;
+    // the arena is freed at once with the strings
+    if ( node->arena_ ) return json_copy(node);
+    json_remove_from_parent(node);
+    return node;
+}
+
+#define field_ptr(obj, f) ( (char *)(obj) + (f)->offset )
+
+// FNV-1a
+static unsigned int field_hash(const char *key) {
+    unsigned int h = 2166136261u;
+    while ( *key ) h = ( h ^ (unsigned char)*key++ ) * 16777619u;
+    return h;
+}
+
+void __attribute__((weak)) json_fields_lock(void) {}
+void __attribute__((weak)) json_fields_unlock(void) {}
+
+static void json_fields_prepare(json_fields_t *d) {
+    int i;
+    json_fields_lock();
+    // too many fields: the lookup is a scan
+    if ( !d->ready && d->count * 2 <= JSON_FIELDS_SLOTS ) {
+        for ( i = 0; i < d->count; i++ ) {
+            unsigned int h = field_hash(d->field[i].key) & ( JSON_FIELDS_SLOTS - 1 );
+            while ( d->slot[h] ) h = ( h + 1 ) & ( JSON_FIELDS_SLOTS - 1 );
+            d->slot[h] = (uint8_t)( i + 1 );
+        }
+    }
+    d->ready = 1;
+    json_fields_unlock();
+}
+
+static const json_field_t *json_fields_find(json_fields_t *d, const char *key) {
+    int i;
+    if ( d->count * 2 > JSON_FIELDS_SLOTS ) {
+        for ( i = 0; i < d->count; i++ )
+            if ( strcmp(d->field[i].key, key) == 0 ) return d->field + i;
+        return NULL;
+    }
+    unsigned int h = field_hash(key) & ( JSON_FIELDS_SLOTS - 1 );
+    // the table is half empty at least, the bound is a safety net
+    for ( i = 0; i < JSON_FIELDS_SLOTS && d->slot[h]; i++ ) {
+        const json_field_t *f = d->field + d->slot[h] - 1;
+        if ( strcmp(f->key, key) == 0 ) return f;
+        h = ( h + 1 ) & ( JSON_FIELDS_SLOTS - 1 );
+    }
+    return NULL;
+}
+
+void json_fields_init(json_fields_t *d, void *obj) {
+    int i;
+    for ( i = 0; i < d->count; i++ ) {
+        const json_field_t *f = d->field + i;
+        switch ( f->kind ) {
+        case json_field_string: property_init((property_t *)field_ptr(obj, f)); break;
+        case json_field_date: memset(field_ptr(obj, f), 0x0, sizeof(struct tm)); break;
+        case json_field_bool:
+        case json_field_int: *(int *)field_ptr(obj, f) = 0; break;
+        case json_field_node: *(JsonNode **)field_ptr(obj, f) = NULL; break;
+        }
+    }
+}
+
+void json_fields_free(json_fields_t *d, void *obj) {
+    int i;
+    for ( i = 0; i < d->count; i++ ) {
+        const json_field_t *f = d->field + i;
+        switch ( f->kind ) {
+        case json_field_string: property_free((property_t *)field_ptr(obj, f)); break;
+        case json_field_bool:
+        case json_field_int: *(int *)field_ptr(obj, f) = 0; break;
+        case json_field_node:
+            json_delete(*(JsonNode **)field_ptr(obj, f));
+            *(JsonNode **)field_ptr(obj, f) = NULL;
+            break;
+        default: break;
+        }
+    }
+}
+
+void json_fields_move(json_fields_t *d, void *dst, void *src) {
+    int i;
+    for ( i = 0; i < d->count; i++ ) {
+        const json_field_t *f = d->field + i;
+        switch ( f->kind ) {
+        case json_field_string:
+            property_move((property_t *)field_ptr(dst, f), (property_t *)field_ptr(src, f));
+            break;
+        case json_field_date: memcpy(field_ptr(dst, f), field_ptr(src, f), sizeof(struct tm)); break;
+        case json_field_bool:
+        case json_field_int: *(int *)field_ptr(dst, f) = *(int *)field_ptr(src, f); break;
+        case json_field_node:
+            *(JsonNode **)field_ptr(dst, f) = *(JsonNode **)field_ptr(src, f);
+            *(JsonNode **)field_ptr(src, f) = NULL;
+            break;
+        }
+    }
+}
+
+int json_fields_parse(json_fields_t *d, void *obj, JsonNode *object) {
+    JsonNode *t = json_first_child(object);
+    if ( !object || object->tag != JSON_OBJECT ) return -1;
+    json_fields_prepare(d);
+    while ( t ) {
+        // the kept node leaves the tree
+        JsonNode *next = t->next;
+        const json_field_t *f = json_fields_find(d, t->key);
+        if ( f ) switch ( f->kind ) {
+        case json_field_string:
+            if ( t->tag == JSON_STRING )
+                property_copy((property_t *)field_ptr(obj, f), p_stack(t->string_));
+            break;
+        case json_field_date:
+            // FIXME parse timestamp
+            if ( t->tag == JSON_STRING )
+                strptime(t->string_, "%Y-%m-%dT%H:%M:%S", (struct tm *)field_ptr(obj, f));
+            break;
+        case json_field_bool:
+            if ( t->tag == JSON_BOOL ) *(int *)field_ptr(obj, f) = t->bool_;
+            break;
+        case json_field_int:
+            if ( t->tag == JSON_NUMBER ) *(int *)field_ptr(obj, f) = (int)t->number_;
+            break;
+        case json_field_node:
+            json_delete(*(JsonNode **)field_ptr(obj, f));
+            *(JsonNode **)field_ptr(obj, f) = json_keep_node(t);
+            break;
+        }
+        t = next;
+    }
+    return 0;
+}
+
+JsonNode *json_fields_encode(json_fields_t *d, const void *obj) {
+    JsonNode *_main = json_mkobject();
+    int i;
+    for ( i = 0; i < d->count; i++ ) {
+        const json_field_t *f = d->field + i;
+        switch ( f->kind ) {
+        case json_field_string: {
+            property_t *p = (property_t *)field_ptr(obj, f);
+            if ( !IS_EMPTY(*p) ) json_append_member(_main, f->key, json_mkstring(P_VALUE(*p)));
+        } break;
+        case json_field_date: {
+            struct tm *tm = (struct tm *)field_ptr(obj, f);
+            char date[32];
+            // the day of month is 1..31 if it was parsed
+            if ( tm->tm_mday && strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", tm) )
+                json_append_member(_main, f->key, json_mkstring(date));
+        } break;
+        case json_field_bool:
+            json_append_member(_main, f->key, json_mkbool(*(int *)field_ptr(obj, f)));
+            break;
+        case json_field_int:
+            json_append_member(_main, f->key, json_mknumber(*(int *)field_ptr(obj, f)));
+            break;
+        case json_field_node: {
+            JsonNode *n = *(JsonNode **)field_ptr(obj, f);
+            if ( n ) json_append_member(_main, f->key, json_copy(n));
+        } break;
+        }
+    }
+    return _main;
+}
@@ -8,41 +8,41 @@
 
 #include "arrow/api/log.h"
 
+static const json_field_t _log_field[] = {
+    JSON_FIELD_WHO_WHEN(log_t, created, "created"),
+    JSON_FIELD(log_t, productName, json_field_string),
+    JSON_FIELD(log_t, type, json_field_string),
+    JSON_FIELD(log_t, objectHid, json_field_string),
+    JSON_FIELD(log_t, parameters, json_field_node)
+};
+static JSON_FIELDS(_log_fields, _log_field);
+
 void log_init(log_t *gi) {
-    who_when_init(&gi->created);
-    property_init(&gi->objectHid);
-    property_init(&gi->productName);
-    property_init(&gi->type);
-    gi->parameters = NULL;
+    json_fields_init(&_log_fields, gi);
 }
 
 void log_free(log_t *gi) {
-    who_when_free(&gi->created);
-    property_free(&gi->objectHid);
-    property_free(&gi->productName);
-    property_free(&gi->type);
-    if (gi->parameters) json_delete(gi->parameters);
+    json_fields_free(&_log_fields, gi);
 }
 
 int log_parse(log_t **list, const char *text) {
-    JsonNode *_main = json_decode(text);
-    if ( !_main ) return -1;
+    json_arena_t arena;
+    json_arena_init(&arena, 0);
+    JsonNode *_main = json_decode_arena(&arena, text);
+    if ( !_main ) {
+        json_arena_free(&arena);
+        return -1;
+    }
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             log_t *gl = (log_t *)malloc(sizeof(log_t));
             log_init(gl);
-            who_when_parse(tmp, &gl->created, "createdDate", "createdBy");
-            json_fill_property(tmp, gl, productName);
-            json_fill_property(tmp, gl, type);
-            json_fill_property(tmp, gl, objectHid);
-            JsonNode *t = json_find_member(tmp, "parameters");
-            json_remove_from_parent(t);
-            gl->parameters = t;
+            json_fields_parse(&_log_fields, gl, tmp);
             linked_list_add_node_last(*list, log_t, gl);
         }
     }
-    json_delete(_main);
+    json_arena_free(&arena);
     return 0;
 }
@@ -7,6 +7,7 @@
  */
 
 #include "arrow/device.h"
+#include <json/writer.h>
 #include <sys/mem.h>
 #include <config.h>
 
@@ -50,21 +51,22 @@ void arrow_device_add_property(arrow_device_t *dev, const char *key, const char
   json_append_member(dev->prop, key, json_mkstring(value));
 }
 
+static int _device_write(json_writer_t *w, void *arg) {
+  arrow_device_t *dev = (arrow_device_t *)arg;
+  json_write_begin_object(w);
+  json_write_member(w, "name", string, P_VALUE(dev->name));
+  json_write_member(w, "type", string, P_VALUE(dev->type));
+  json_write_member(w, "uid", string, P_VALUE(dev->uid));
+  json_write_member(w, "gatewayHid", string, P_VALUE(dev->gateway_hid));
+  json_write_member(w, "softwareName", string, P_VALUE(dev->softwareName));
+  json_write_member(w, "softwareName", string, P_VALUE(dev->softwareVersion));
+  if ( dev->info ) json_write_member(w, "info", node, dev->info);
+  if ( dev->prop ) json_write_member(w, "properties", node, dev->prop);
+  return json_write_end_object(w);
+}
+
 char *arrow_device_serialize(arrow_device_t *dev) {
-  JsonNode *_main = json_mkobject();
-  json_append_member(_main, "name", json_mkstring(P_VALUE(dev->name)));
-  json_append_member(_main, "type", json_mkstring(P_VALUE(dev->type)));
-  json_append_member(_main, "uid", json_mkstring(P_VALUE(dev->uid)));
-  json_append_member(_main, "gatewayHid", json_mkstring(P_VALUE(dev->gateway_hid)));
-  json_append_member(_main, "softwareName", json_mkstring(P_VALUE(dev->softwareName)));
-  json_append_member(_main, "softwareName", json_mkstring(P_VALUE(dev->softwareVersion)));
-  if ( dev->info ) json_append_member(_main, "info", dev->info);
-  if ( dev->prop ) json_append_member(_main, "properties", dev->prop);
-  char *dev_str = json_encode(_main);
-  if ( dev->info ) json_remove_from(_main, dev->info);
-  if ( dev->prop ) json_remove_from(_main, dev->prop);
-  json_delete(_main);
-  return dev_str;
+  return json_write_alloc(_device_write, dev);
 }
 
 int arrow_device_parse(arrow_device_t *dev, const char *str) {
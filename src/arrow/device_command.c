@@ -118,48 +118,58 @@ int __attribute__((weak)) command_handler(const char *name,
   return ret;
 }
 
+#if defined(HTTP_PIPELINE_EVENT_ANS)
+# define ANS_PIPELINE 1
+#else
+# define ANS_PIPELINE 0
+#endif
+
 int ev_DeviceCommand(void *_ev, JsonNode *_parameters) {
   int ret = -1;
   JsonNode *_error = NULL;
   mqtt_event_t *ev = (mqtt_event_t *)_ev;
   int retry = 0;
-  http_session_close_set(current_client(), false);
-  while( arrow_send_event_ans(ev->gateway_hid, received, NULL) < 0 ) {
-      RETRY_UP(retry, {return -2;});
-      msleep(ARROW_RETRY_DELAY);
-  }
-  DBG("start device command processing");
 
   JsonNode *tmp = json_find_member(_parameters, "deviceHid");
-  if ( !tmp || tmp->tag != JSON_STRING ) return -1;
-
   JsonNode *cmd = json_find_member(_parameters, "command");
-  if ( !cmd || cmd->tag != JSON_STRING ) return -1;
-  DBG("ev cmd: %s", cmd->string_);
-
   JsonNode *pay = json_find_member(_parameters, "payload");
-  if ( !pay || pay->tag != JSON_STRING ) return -1;
+  int valid = tmp && tmp->tag == JSON_STRING &&
+              cmd && cmd->tag == JSON_STRING &&
+              pay && pay->tag == JSON_STRING;
+
+  // the receipt goes before the handler runs
+  // unless it's deferred to the result (HTTP_PIPELINE_EVENT_ANS)
+  if ( !ANS_PIPELINE || !valid ) {
+    while( arrow_send_event_ans(ev->gateway_hid, received, NULL) < 0 ) {
+        RETRY_UP(retry, {return -2;});
+        msleep(ARROW_RETRY_DELAY);
+    }
+    RETRY_CR(retry);
+  }
+  if ( !valid ) return -1;
+  DBG("start device command processing");
+  DBG("ev cmd: %s", cmd->string_);
   DBG("ev msg: %s", pay->string_);
 
   ret = command_handler(cmd->string_, pay, &_error);
   if ( ret < 0 ) {
       DBG("command_handler fail %d", ret);
   }
-  // close session after next request
-  http_session_close_set(current_client(), true);
-  RETRY_CR(retry);
-  if ( _error ) {
-    while ( arrow_send_event_ans(ev->gateway_hid, failed, json_encode(_error)) < 0 ) {
-        RETRY_UP(retry, {return -2;});
-        msleep(ARROW_RETRY_DELAY);
-    }
-    json_delete(_error);
-  } else {
-    while ( arrow_send_event_ans(ev->gateway_hid, succeeded, NULL) < 0 ) {
-        RETRY_UP(retry, {return -2;});
-        msleep(ARROW_RETRY_DELAY);
-    }
+  event_data_t ans[2] = {
+    { ev->gateway_hid, received, NULL },
+    { ev->gateway_hid, _error ? failed : succeeded, _error ? json_encode(_error) : NULL }
+  };
+  http_routine_t r[2] = {
+    { _event_ans_init, ans, NULL, NULL, 0 },
+    { _event_ans_init, ans + 1, NULL, NULL, 0 }
+  };
+  int done = ANS_PIPELINE ? 0 : 1;
+  ret = 0;
+  while ( ( done += __http_routine_pipeline(r + done, 2 - done) ) < 2 ) {
+      RETRY_UP(retry, {ret = -2; break;});
+      msleep(ARROW_RETRY_DELAY);
   }
-
-  return 0;
+  if ( ans[1].payload ) free(ans[1].payload);
+  if ( _error ) json_delete(_error);
+  return ret;
 }
@@ -22,6 +22,7 @@
 #include <debug.h>
 #include <http/client.h>
 #include <json/json.h>
+#include <json/dtoa.h>
 #include <sys/mem.h>
 #include <arrow/gateway_payload_sign.h>
 
@@ -121,7 +122,9 @@ static char *form_canonical_prm(JsonNode *param) {
       case JSON_BOOL: strcpy(can_list[count]+i+1, (child->bool_?"true\0":"false\0"));
         break;
       default: {
-        int r = snprintf(can_list[count]+i+1, 50, "%f", child->number_);
+        // the same text as "%f" whatever the locale is
+        int r = json_dtoa_fixed(child->number_, 6, can_list[count]+i+1, 50);
+        if ( r < 0 ) r = 0;
         *(can_list[count]+i+1 + r ) = 0x0;
       }
     }
@@ -143,9 +146,12 @@ int process_event(const char *str) {
   mqtt_event_t mqtt_e;
   int ret = -1;
   memset(&mqtt_e, 0x0, sizeof(mqtt_event_t));
-  JsonNode *_main = json_decode(str);
+  json_arena_t arena;
+  json_arena_init(&arena, 0);
+  JsonNode *_main = json_decode_arena(&arena, str);
   if ( !_main ) {
       DBG("event payload decode failed %d", strlen(str));
+      json_arena_free(&arena);
       return -1;
   }
 
@@ -199,6 +205,6 @@ int process_event(const char *str) {
 
 error:
   free_mqtt_event(&mqtt_e);
-  if ( _main ) json_delete(_main);
+  json_arena_free(&arena);
   return ret;
 }
@@ -7,6 +7,7 @@
  */
 
 #include "arrow/gateway.h"
+#include <json/writer.h>
 #include <debug.h>
 #include <sys/mac.h>
 
@@ -20,25 +21,28 @@ void arrow_gateway_init(arrow_gateway_t *gate) {
   memset(gate, 0, sizeof(arrow_gateway_t));
 }
 
-char *arrow_gateway_serialize(arrow_gateway_t *gate) {
-  JsonNode *_main = json_mkobject();
+static int _gateway_write(json_writer_t *w, void *arg) {
+  arrow_gateway_t *gate = (arrow_gateway_t *)arg;
+  json_write_begin_object(w);
   if ( !IS_EMPTY( gate->name ) )
-    json_append_member(_main, "name", json_mkstring( P_VALUE(gate->name) ));
+    json_write_member(w, "name", string, P_VALUE(gate->name));
   if ( !IS_EMPTY( gate->uid ) )
-    json_append_member(_main, "uid", json_mkstring( P_VALUE(gate->uid) ));
+    json_write_member(w, "uid", string, P_VALUE(gate->uid));
   if ( !IS_EMPTY(gate->os) )
-    json_append_member(_main, "osName", json_mkstring( P_VALUE(gate->os) ));
+    json_write_member(w, "osName", string, P_VALUE(gate->os));
   if ( !IS_EMPTY(gate->type) )
-    json_append_member(_main, "type", json_mkstring( P_VALUE(gate->type) ));
+    json_write_member(w, "type", string, P_VALUE(gate->type));
   if ( !IS_EMPTY(gate->software_name) )
-    json_append_member(_main, "softwareName", json_mkstring( P_VALUE(gate->software_name) ));
+    json_write_member(w, "softwareName", string, P_VALUE(gate->software_name));
   if ( !IS_EMPTY(gate->software_version) )
-    json_append_member(_main, "softwareVersion", json_mkstring( P_VALUE(gate->software_version) ));
+    json_write_member(w, "softwareVersion", string, P_VALUE(gate->software_version));
   if ( !IS_EMPTY(gate->sdkVersion) )
-    json_append_member(_main, "sdkVersion", json_mkstring( P_VALUE(gate->sdkVersion) ));
-  char *str = json_encode(_main);
-  json_delete(_main);
-  return str;
+    json_write_member(w, "sdkVersion", string, P_VALUE(gate->sdkVersion));
+  return json_write_end_object(w);
+}
+
+char *arrow_gateway_serialize(arrow_gateway_t *gate) {
+  return json_write_alloc(_gateway_write, gate);
 }
 
 int arrow_gateway_parse(arrow_gateway_t *gate, const char *str) {
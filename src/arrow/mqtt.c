@@ -15,6 +15,7 @@
 #include <debug.h>
 
 #include <arrow/events.h>
+#include <bsd/reactor.h>
 
 #define USE_STATIC
 #include <data/chunk.h>
@@ -29,6 +30,28 @@ static Network mqtt_net;
 static MQTTClient mqtt_client;
 static unsigned char buf[MQTT_BUF_LEN];
 static unsigned char readbuf[MQTT_BUF_LEN];
+#if defined(MQTT_PAYLOAD_BUF)
+// for a platform telemetry_serialize_into,
+// the payload can't be larger than the packet buffer anyway
+static char payload_buf[MQTT_BUF_LEN];
+#endif
+
+#if MQTT_INFLIGHT > 0
+static MQTTInflight inflight[MQTT_INFLIGHT];
+#endif
+static mqtt_publish_done_f publish_done_cb = NULL;
+// the socket is open / watched by the reactor (mqtt_reactor_attach)
+static int mqtt_net_up = 0;
+static int reactor_attached = 0;
+static void mqtt_ready(int sock, void *arg);
+
+static void mqtt_client_init(unsigned int command_timeout_ms) {
+  MQTTClientInit(&mqtt_client, &mqtt_net, command_timeout_ms, buf, MQTT_BUF_LEN, readbuf, MQTT_BUF_LEN);
+#if MQTT_INFLIGHT > 0
+  // the messages of the last connection are sent by MQTTConnect again
+  MQTTSetInflight(&mqtt_client, inflight, MQTT_INFLIGHT);
+#endif
+}
 
 #define S_TOP_NAME "krs/cmd/stg/"
 #define P_TOP_NAME "krs.tel.gts."
@@ -103,7 +126,7 @@ int mqtt_connect_ibm(arrow_device_t *device,
   rc = NetworkConnect(&mqtt_net, mqtt_addr, MQTT_PORT);
   DBG("Connecting to %s %d", mqtt_addr, MQTT_PORT);
   if ( rc < 0 ) return rc;
-  MQTTClientInit(&mqtt_client, &mqtt_net, 3000, buf, MQTT_BUF_LEN, readbuf, MQTT_BUF_LEN);
+  mqtt_client_init(3000);
   rc = MQTTConnect(&mqtt_client, &data);
   DBG("Connected %d", rc);
   return rc;
@@ -207,7 +230,7 @@ static int mqtt_connect_azure(arrow_gateway_t *gateway,
   rc = NetworkConnect(&mqtt_net, mqtt_addr, MQTT_PORT);
   DBG("Connecting to %s %d", mqtt_addr, MQTT_PORT);
   if ( rc < 0 ) return rc;
-  MQTTClientInit(&mqtt_client, &mqtt_net, 3000, buf, MQTT_BUF_LEN, readbuf, MQTT_BUF_LEN);
+  mqtt_client_init(3000);
   rc = MQTTConnect(&mqtt_client, &data);
   DBG("Connected %d", rc);
   if ( rc != MQTT_SUCCESS ) return FAILURE;
@@ -252,7 +275,7 @@ static int mqtt_connect_iot(arrow_gateway_t *gateway) {
       goto mqtt_network_connect_done;
   }
   DBG("Connecting to %s %d", MQTT_ADDR, MQTT_PORT);
-  MQTTClientInit(&mqtt_client, &mqtt_net, DEFAULT_MQTT_TIMEOUT, buf, MQTT_BUF_LEN, readbuf, MQTT_BUF_LEN);
+  mqtt_client_init(DEFAULT_MQTT_TIMEOUT);
   ret = MQTTConnect(&mqtt_client, &data);
 mqtt_network_connect_done:
   if ( ret < 0 ) NetworkDisconnect(&mqtt_net);
@@ -266,25 +289,39 @@ mqtt_connect_done:
 int mqtt_connect(arrow_gateway_t *gateway,
                  arrow_device_t *device,
                  arrow_gateway_config_t *config) {
+  int ret;
+  // the socket of the last (dropped) connection isn't used anymore
+  if ( mqtt_net_up ) {
+    reactor_del(mqtt_net.my_socket);
+    NetworkDisconnect(&mqtt_net);
+    mqtt_net_up = 0;
+  }
 #if defined(__IBM__)
   SSP_PARAMETER_NOT_USED(gateway);
-  return mqtt_connect_ibm(device, config);
+  ret = mqtt_connect_ibm(device, config);
 #elif defined(__AZURE__)
   SSP_PARAMETER_NOT_USED(gateway);
   SSP_PARAMETER_NOT_USED(device);
   SSP_PARAMETER_NOT_USED(config);
-  return mqtt_connect_azure(gateway, device, config);
+  ret = mqtt_connect_azure(gateway, device, config);
 #else
   SSP_PARAMETER_NOT_USED(device);
   SSP_PARAMETER_NOT_USED(config);
-  return mqtt_connect_iot(gateway);
+  ret = mqtt_connect_iot(gateway);
 #endif
-
+  if ( ret >= 0 ) {
+    mqtt_net_up = 1;
+    // the reactor follows the new socket
+    if ( reactor_attached ) reactor_add(mqtt_net.my_socket, mqtt_ready, NULL);
+  }
+  return ret;
 }
 
 void mqtt_disconnect(void) {
+    reactor_del(mqtt_net.my_socket);
     MQTTDisconnect(&mqtt_client);
     NetworkDisconnect(&mqtt_net);
+    mqtt_net_up = 0;
 }
 
 int mqtt_subscribe(void) {
@@ -297,7 +334,48 @@ int mqtt_subscribe(void) {
 }
 
 int mqtt_yield(int timeout_ms) {
-  return MQTTYield(&mqtt_client, timeout_ms);
+  int rc = MQTTYield(&mqtt_client, timeout_ms);
+  // the packets received together with the last one don't make
+  // the socket readable, every cycle takes one of them at least
+  while ( NetworkPending(&mqtt_net) > 0 )
+    rc = MQTTYield(&mqtt_client, MQTT_REACTOR_YIELD);
+  return rc;
+}
+
+static void mqtt_ready(int sock, void *arg) {
+  SSP_PARAMETER_NOT_USED(sock);
+  SSP_PARAMETER_NOT_USED(arg);
+  mqtt_yield(MQTT_REACTOR_YIELD);
+}
+
+int mqtt_reactor_attach(void) {
+  reactor_attached = 1;
+  return reactor_add(mqtt_net.my_socket, mqtt_ready, NULL);
+}
+
+void mqtt_reactor_detach(void) {
+  reactor_attached = 0;
+  reactor_del(mqtt_net.my_socket);
+}
+
+static void publish_done(void *arg, unsigned short id, int rc) {
+  SSP_PARAMETER_NOT_USED(arg);
+  if ( rc < 0 ) {
+    DBG("mqtt message %d dropped", id);
+  }
+  if ( publish_done_cb ) publish_done_cb(id, rc);
+}
+
+void mqtt_publish_set_cb(mqtt_publish_done_f cb) {
+  publish_done_cb = cb;
+}
+
+int mqtt_publish_pending(void) {
+  return MQTTInflightCount(&mqtt_client);
+}
+
+void mqtt_publish_abort(void) {
+  MQTTInflightAbort(&mqtt_client);
 }
 
 int mqtt_publish(arrow_device_t *device, void *d) {
@@ -309,14 +387,38 @@ int mqtt_publish(arrow_device_t *device, void *d) {
         NULL,
         0
     };
-    char *payload = telemetry_serialize(device, d);
-    msg.payload = payload;
-    msg.payloadlen = strlen(payload);
-    int ret = MQTTPublish(&mqtt_client, p_topic, &msg);
-    free(payload);
+    char *payload = NULL;
+#if defined(MQTT_PAYLOAD_BUF)
+    int len = telemetry_serialize_into(device, d, payload_buf, sizeof(payload_buf));
+    if ( len >= 0 ) {
+        msg.payload = payload_buf;
+        msg.payloadlen = (size_t)len;
+    } else
+#endif
+    {
+        payload = telemetry_serialize(device, d);
+        if ( !payload ) return -1;
+        msg.payload = payload;
+        msg.payloadlen = strlen(payload);
+    }
+    // the client keeps its own copy until the ack
+    int ret = MQTTPublishAsync(&mqtt_client, p_topic, &msg, publish_done, NULL);
+    if ( payload ) free(payload);
     return ret;
 }
 
+int mqtt_publish_payload(const char *payload, int len) {
+    MQTTMessage msg = {
+        MQTT_QOS,
+        MQTT_RETAINED,
+        MQTT_DUP,
+        0,
+        (void *)payload,
+        (size_t)len
+    };
+    return MQTTPublishAsync(&mqtt_client, p_topic, &msg, publish_done, NULL);
+}
+
 int mqtt_is_connect() {
     return mqtt_client.isconnected;
 }
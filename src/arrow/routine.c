@@ -13,6 +13,8 @@
 #include <arrow/api/device/device.h>
 #include <arrow/telemetry_api.h>
 #include <arrow/storage.h>
+#include <arrow/telemetry_queue.h>
+#include <json/telemetry.h>
 
 #define GATEWAY_CONNECT "Gateway connection [%s]"
 #define GATEWAY_CONFIG "Gateway config [%s]"
@@ -27,6 +29,42 @@ static arrow_device_t _device;
 static int _init_done = 0;
 static int _init_mqtt = 0;
 
+#if !defined(NO_TELEMETRY_QUEUE)
+// keep the data that can't be sent now
+static void store_telemetry(void *data) {
+  char *payload = telemetry_serialize(&_device, data);
+  if ( !payload || telemetry_queue_push(payload, (int)strlen(payload)) < 0 ) {
+    DBG(DEVICE_TELEMETRY, "lost");
+  }
+  if ( payload ) free(payload);
+}
+
+typedef int (*telemetry_drain_f)(int, telemetry_queue_send_f, void *);
+
+// send the stored data first, up to TELEMETRY_QUEUE_BATCH messages at once
+// return: 0 - nothing is stored, 1 - there is more, -1 - the sending failed
+static int drain_telemetry(telemetry_drain_f drain, telemetry_queue_send_f send) {
+  int sent;
+  if ( !telemetry_queue_count() ) return 0;
+  sent = drain(TELEMETRY_QUEUE_BATCH, send, NULL);
+  if ( !telemetry_queue_count() ) return 0;
+  return sent > 0 ? 1 : -1;
+}
+
+static int http_queue_send(const char *payload, int len, void *arg) {
+  SSP_PARAMETER_NOT_USED(len);
+  SSP_PARAMETER_NOT_USED(arg);
+  return arrow_send_telemetry_payload(payload, 1);
+}
+
+static int mqtt_queue_send(const char *payload, int len, void *arg) {
+  SSP_PARAMETER_NOT_USED(arg);
+  return mqtt_publish_payload(payload, len);
+}
+#else
+# define store_telemetry(data)
+#endif
+
 arrow_device_t *current_device(void) {
   return &_device;
 }
@@ -73,7 +111,6 @@ int arrow_connect_device(arrow_gateway_t *gateway, arrow_device_t *device) {
 arrow_routine_error_t arrow_initialize_routine(void) {
   wdt_feed();
   int retry = 0;
-  http_session_close_set(current_client(), false);
   DBG("register gateway via API");
   while ( arrow_connect_gateway(&_gateway) < 0 ) {
       RETRY_UP(retry, {return ROUTINE_ERROR;});
@@ -95,8 +132,6 @@ arrow_routine_error_t arrow_initialize_routine(void) {
   wdt_feed();
   RETRY_CR(retry);
   DBG("register device via API");
-  // close session after next request
-  http_session_close_set(current_client(), true);
   while ( arrow_connect_device(&_gateway, &_device) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(DEVICE_CONNECT, "fail");
@@ -119,9 +154,17 @@ arrow_routine_error_t arrow_update_state(const char *name, const char *value) {
 arrow_routine_error_t arrow_send_telemetry_routine(void *data) {
     if ( !_init_done ) return ROUTINE_NOT_INITIALIZE;
     wdt_feed();
+#if !defined(NO_TELEMETRY_QUEUE)
+    int stored = drain_telemetry(telemetry_queue_drain_batch, http_queue_send);
+    if ( stored ) {
+        // the new data waits behind the stored ones
+        store_telemetry(data);
+        return stored < 0 ? ROUTINE_ERROR : ROUTINE_SUCCESS;
+    }
+#endif
     int retry = 0;
     while ( arrow_send_telemetry(&_device, data) < 0) {
-        RETRY_UP(retry, {return ROUTINE_ERROR;});
+        RETRY_UP(retry, {store_telemetry(data); return ROUTINE_ERROR;});
         DBG(DEVICE_TELEMETRY, "fail");
         msleep(ARROW_RETRY_DELAY);
     }
@@ -185,8 +228,20 @@ arrow_routine_error_t arrow_mqtt_send_telemetry_routine(get_data_cb data_cb, voi
           continue;
       }
       wdt_feed();
+#if !defined(NO_TELEMETRY_QUEUE)
+      int stored = drain_telemetry(telemetry_queue_drain, mqtt_queue_send);
+      if ( stored ) {
+          store_telemetry(data);
+          if ( stored < 0 ) {
+              DBG(DEVICE_MQTT_TELEMETRY, "fail");
+              return ROUTINE_MQTT_PUBLISH_FAILED;
+          }
+          continue;
+      }
+#endif
       if ( mqtt_publish(&_device, data) < 0 ) {
           DBG(DEVICE_MQTT_TELEMETRY, "fail");
+          store_telemetry(data);
           return ROUTINE_MQTT_PUBLISH_FAILED;
       }
 #if defined(VALGRIND_TEST)
@@ -76,13 +76,14 @@ void set_secret_key(char *newkey) {
 
 static char canonicalRequest[sizeof(api_key) + 512];
 
-void sign(char *signature,
-          const char *timestamp,
-          const char *meth,
-          const char *uri,
-          const char *canQueryString,
-          const char *payload,
-          const char *apiVersion) {
+// the payload is hashed already
+static void sign_hashed(char *signature,
+                        const char *timestamp,
+                        const char *meth,
+                        const char *uri,
+                        const char *canQueryString,
+                        const char *payload_hash,
+                        const char *apiVersion) {
     int i;
 
     strcpy(canonicalRequest, meth);
@@ -94,9 +95,8 @@ void sign(char *signature,
 
     CREATE_CHUNK(hex_hash_payload, 66);
     CREATE_CHUNK(hash_payload, 34);
-    if (payload) {
-      sha256(hash_payload, (char*)payload, (int)strlen(payload));
-      hex_encode(hex_hash_payload, hash_payload, 32);
+    if (payload_hash) {
+      hex_encode(hex_hash_payload, payload_hash, 32);
       hex_hash_payload[64] = '\0';
     } else {
       strcpy(hex_hash_payload, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"); // pre calculated null string hash
@@ -143,6 +143,19 @@ void sign(char *signature,
     DBG_SIGN("sign: %s", signature);
 }
 
+void sign(char *signature,
+          const char *timestamp,
+          const char *meth,
+          const char *uri,
+          const char *canQueryString,
+          const char *payload,
+          const char *apiVersion) {
+    char hash_payload[32];
+    if ( payload ) sha256(hash_payload, (char*)payload, (int)strlen(payload));
+    sign_hashed(signature, timestamp, meth, uri, canQueryString,
+                payload ? hash_payload : NULL, apiVersion);
+}
+
 static void get_canonical_string(char *buffer, http_request_t *req){
     property_map_t *query = req->query;
     buffer[0] = '\0';
@@ -154,7 +167,7 @@ static void get_canonical_string(char *buffer, http_request_t *req){
     }
 }
 
-void sign_request(http_request_t *req) {
+int sign_request(http_request_t *req) {
     static char ts[25];
     static char signature[70];
     char *canonicalQuery = NULL;
@@ -173,9 +186,26 @@ void sign_request(http_request_t *req) {
                             p_const("x-arrow-version"),
                             p_const("1"));
 
-    sign(signature, ts, P_VALUE(req->meth),
-         P_VALUE(req->uri), canonicalQuery,
-         P_VALUE(req->payload.buf), "1");
+    if ( req->payload_producer ) {
+      // the streamed payload is produced twice: now for the hash and on send,
+      // so every telemetry batch record is serialized twice too -
+      // the CPU time is paid for not keeping the whole payload in memory
+      char hash_payload[32];
+      req->payload_producer(req->payload_arg, NULL, 0);
+      if ( sha256_stream(hash_payload, req->payload_producer, req->payload_arg) < 0 ) {
+        // the signature of a partial payload is useless
+        DBG("payload hash fail");
+        if (canonicalQuery) free(canonicalQuery);
+        return -1;
+      }
+      sign_hashed(signature, ts, P_VALUE(req->meth),
+                  P_VALUE(req->uri), canonicalQuery,
+                  hash_payload, "1");
+    } else {
+      sign(signature, ts, P_VALUE(req->meth),
+           P_VALUE(req->uri), canonicalQuery,
+           P_VALUE(req->payload.buf), "1");
+    }
 
     if (canonicalQuery) free(canonicalQuery);
     http_request_add_header(req,
@@ -188,10 +218,13 @@ void sign_request(http_request_t *req) {
     http_request_add_header(req,
                             p_const("Connection"),
                             p_const("Keep-Alive"));
+#if !defined(NO_HTTP_INFLATE)
     http_request_add_header(req,
                             p_const("Accept-Encoding"),
                             p_const("gzip, deflate"));
+#endif
     http_request_add_header(req,
                             p_const("User-Agent"),
                             p_const("Eos"));
+    return 0;
 }
@@ -7,6 +7,7 @@
  */
 
 #include "arrow/software_release.h"
+#include <json/writer.h>
 #include <http/routine.h>
 #include <debug.h>
 #include <sys/watchdog.h>
@@ -26,12 +27,23 @@ static __download_init_cb __download_init = NULL;
 static __download_payload_cb  __payload = NULL;
 static __download_complete_cb __download = NULL;
 
+typedef struct {
+  const char *hid;
+  release_sched_t *rs;
+} software_trans_t;
+
+static int _software_trans_write(json_writer_t *w, void *arg) {
+  software_trans_t *st = (software_trans_t *)arg;
+  json_write_begin_object(w);
+  json_write_member(w, "objectHid", string, st->hid);
+  json_write_member(w, "softwareReleaseScheduleHid", string, st->rs->schedule_hid);
+  json_write_member(w, "toSoftwareReleaseHid", string, st->rs->release_hid);
+  return json_write_end_object(w);
+}
+
 static char *serialize_software_trans(const char *hid, release_sched_t *rs) {
-  JsonNode *_main = json_mkobject();
-  json_append_member(_main, "objectHid", json_mkstring(hid));
-  json_append_member(_main, "softwareReleaseScheduleHid", json_mkstring(rs->schedule_hid));
-  json_append_member(_main, "toSoftwareReleaseHid", json_mkstring(rs->release_hid));
-  return json_encode(_main);
+  software_trans_t st = { hid, rs };
+  return json_write_alloc(_software_trans_write, &st);
 }
 
 typedef struct _gateway_software_sched_ {
@@ -175,7 +187,6 @@ int ev_DeviceSoftwareRelease(void *_ev, JsonNode *_parameters) {
   if ( !tmp || tmp->tag != JSON_STRING ) return -1;
   char *trans_hid = tmp->string_;
   wdt_feed();
-  http_session_close_set(current_client(), false);
   int retry = 0;
   while( arrow_software_releases_trans_received(trans_hid) < 0) {
     RETRY_UP(retry, {return -2;});
@@ -208,8 +219,6 @@ int ev_DeviceSoftwareRelease(void *_ev, JsonNode *_parameters) {
   wdt_feed();
   SSP_PARAMETER_NOT_USED(_to);
 software_release_done:
-  // close session after next request
-  http_session_close_set(current_client(), true);
   if ( ret < 0 ) {
       int retry = 0;
       wdt_feed();
@@ -2,6 +2,7 @@
 #include <time/time.h>
 #include <http/client.h>
 #include <json/json.h>
+#include <json/writer.h>
 #include <sys/mem.h>
 #include <http/routine.h>
 #include <arrow/events.h>
@@ -61,9 +62,16 @@ typedef struct _post_dev_ {
   int post;
 } post_dev_t;
 
+static int _state_write(json_writer_t *w, void *arg) {
+  const char *ts = (const char *)arg;
+  json_write_begin_object(w);
+  json_write_member(w, "states", node, state_tree);
+  json_write_member(w, "timestamp", string, ts);
+  return json_write_end_object(w);
+}
+
 static void _state_post_init(http_request_t *request, void *arg) {
   post_dev_t *pd = (post_dev_t *)arg;
-  JsonNode *_state = NULL;
   CREATE_CHUNK(uri, sizeof(ARROW_API_DEVICE_ENDPOINT) + P_SIZE(pd->device->hid) + 20);
   strcpy(uri, ARROW_API_DEVICE_ENDPOINT);
   strcat(uri, "/");
@@ -82,18 +90,9 @@ static void _state_post_init(http_request_t *request, void *arg) {
   }
   FREE_CHUNK(uri);
   http_request_init(request, POST, uri);
-  {
-    _state = json_mkobject();
-    json_append_member(_state, "states", state_tree);
-    char ts[30];
-    get_time(ts);
-    json_append_member(_state, "timestamp", json_mkstring(ts));
-  }
-  http_request_set_payload(request, p_heap(json_encode(_state)));
-  if (_state) {
-    json_remove_from(_state, state_tree);
-    json_delete(_state);
-  }
+  char ts[30];
+  get_time(ts);
+  http_request_set_payload(request, p_heap(json_write_alloc(_state_write, ts)));
 }
 
 static int _arrow_post_state(arrow_device_t *device, _st_post_api post_type) {
@@ -160,11 +159,6 @@ static void _state_put_init(http_request_t *request, void *arg) {
   }
 }
 
-static int _arrow_put_state(const char *device_hid, _st_put_api put_type, const char *trans_hid) {
-    put_dev_t pd = {device_hid, trans_hid, put_type};
-    STD_ROUTINE(_state_put_init, &pd, NULL, NULL, "State put failed...");
-}
-
 int state_handler(char *str) {
   SSP_PARAMETER_NOT_USED(str);
   DBG("weak state handler [%s]", str);
@@ -195,23 +189,28 @@ int ev_DeviceStateRequest(void *_ev, JsonNode *_parameters) {
   }
   int retry = 0;
 
-  while ( _arrow_put_state(_device_hid, st_received, trans_hid->string_) < 0 ) {
+  put_dev_t pd[2] = {
+    { _device_hid, trans_hid->string_, st_received },
+    { _device_hid, trans_hid->string_, st_complete }
+  };
+  http_routine_t r[2] = {
+    { _state_put_init, pd, NULL, NULL, 0 },
+    { _state_put_init, pd + 1, NULL, NULL, 0 }
+  };
+  int done = 0;
+#if !defined(HTTP_PIPELINE_EVENT_ANS)
+  while ( ( done = __http_routine_pipeline(r, 1) ) < 1 ) {
       RETRY_UP(retry, {return -2;});
       msleep(ARROW_RETRY_DELAY);
   }
+  RETRY_CR(retry);
+#endif
+  // otherwise the received answer goes together with the result
+  if ( state_handler(payload->string_) < 0 ) pd[1].put_type = st_error;
 
-  int ret = state_handler(payload->string_);
-
-  if ( ret < 0 ) {
-    while ( _arrow_put_state(_device_hid, st_error, trans_hid->string_) < 0 ) {
-        RETRY_UP(retry, {return -2;});
-        msleep(ARROW_RETRY_DELAY);
-    }
-  } else {
-    while ( _arrow_put_state(_device_hid, st_complete, trans_hid->string_) < 0 ) {
-        RETRY_UP(retry, {return -2;});
-        msleep(ARROW_RETRY_DELAY);
-    }
+  while ( ( done += __http_routine_pipeline(r + done, 2 - done) ) < 2 ) {
+      RETRY_UP(retry, {return -2;});
+      msleep(ARROW_RETRY_DELAY);
   }
   return 0;
 }
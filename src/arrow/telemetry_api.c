@@ -1,6 +1,7 @@
 #include "arrow/telemetry_api.h"
 #include <data/find_by.h>
 #include <json/telemetry.h>
+#include <json/sax.h>
 #include <http/routine.h>
 #include <debug.h>
 #include <data/chunk.h>
@@ -48,6 +49,12 @@ typedef struct _device_telemetry {
   arrow_device_t *device;
   void *data;
   int count;
+  int stride;
+  // the batch producer state
+  int next;
+  char *item;
+  int item_len;
+  int item_pos;
 } device_telemetry_t;
 
 static void _telemetry_init(http_request_t *request, void *arg) {
@@ -58,39 +65,105 @@ static void _telemetry_init(http_request_t *request, void *arg) {
 }
 
 int arrow_send_telemetry(arrow_device_t *device, void *d) {
-  device_telemetry_t dt = {device, d, 1};
+  device_telemetry_t dt = {device, d, 1, 0, 0, NULL, 0, 0};
   STD_ROUTINE(_telemetry_init, &dt,
               NULL, NULL,
               "Arrow Telemetry send failed...");
 }
 
+// the batch is serialized by one telemetry item at a time:
+// [item,item,...]
+static int _telemetry_batch_produce(void *arg, uint8_t *buf, int len) {
+  device_telemetry_t *dt = (device_telemetry_t *)arg;
+  int n = 0;
+  if ( !buf ) {
+    if ( dt->item ) free(dt->item);
+    dt->item = NULL;
+    dt->next = 0;
+    return 0;
+  }
+  while ( n < len ) {
+    if ( dt->item ) {
+      int part = dt->item_len - dt->item_pos;
+      if ( part > len - n ) part = len - n;
+      memcpy(buf + n, dt->item + dt->item_pos, (size_t)part);
+      n += part;
+      dt->item_pos += part;
+      if ( dt->item_pos == dt->item_len ) {
+        free(dt->item);
+        dt->item = NULL;
+      }
+      continue;
+    }
+    if ( dt->next > dt->count ) break;
+    if ( dt->next == dt->count ) {
+      buf[n++] = ']';
+      dt->next++;
+      continue;
+    }
+    buf[n++] = dt->next ? ',' : '[';
+    dt->item = telemetry_serialize(dt->device, telemetry_record(dt->data, dt->next, dt->stride));
+    if ( !dt->item ) return -1;
+    dt->item_len = (int)strlen(dt->item);
+    dt->item_pos = 0;
+    dt->next++;
+  }
+  return n;
+}
+
 static void _telemetry_batch_init(http_request_t *request, void *arg) {
   device_telemetry_t *dt = (device_telemetry_t *)arg;
   CREATE_CHUNK(uri, URI_LEN);
   snprintf(uri, URI_LEN, "%s/batch", ARROW_API_TELEMETRY_ENDPOINT);
   http_request_init(request, POST, uri);
   FREE_CHUNK(uri);
-  request->is_chunked = 1;
-  int i = 0;
-  char *_main = NULL;
-  for( i = 0; i < dt->count; i++ ) {
-    char *tmp = telemetry_serialize(dt->device, (int*)dt->data + i);
-    if ( !_main ) {
-      _main = (char*)malloc(strlen(tmp) * ( dt->count + 1 ));
-      strcpy(_main, "[");
-    }
-    strcat(_main, tmp);
-    if ( i != dt->count - 1 ) strcat(_main, ",");
-    else strcat(_main, "]");
-    free(tmp);
-  }
-  DBG("main: %s", _main);
-  http_request_set_payload(request, p_heap(_main));
+#if defined(TELEMETRY_BATCH_GZIP)
+  request->is_gzip = 1;
+#endif
+  http_request_set_payload_producer(request, _telemetry_batch_produce, dt);
 }
 
 int arrow_telemetry_batch_create(arrow_device_t *device, void *data, int size) {
-  device_telemetry_t dt = {device, data, size};
-  STD_ROUTINE(_telemetry_batch_init, &dt,
+  return arrow_telemetry_batch_create_stride(device, data, size, (int)sizeof(int));
+}
+
+int arrow_telemetry_batch_create_stride(arrow_device_t *device, void *data, int count, int stride) {
+  if ( count <= 0 ) return -1;
+  device_telemetry_t dt = {device, data, count, stride, 0, NULL, 0, 0};
+  int ret = __http_routine(_telemetry_batch_init, &dt, NULL, NULL);
+  // the producer may be stopped in the middle of the batch
+  if ( dt.item ) free(dt.item);
+  if ( ret < 0 ) {
+    DBG("Error:Arrow Telemetry send failed...");
+  }
+  return ret;
+}
+
+typedef struct _telemetry_payload_ {
+  const char *payload;
+  int batch;
+} telemetry_payload_t;
+
+static void _telemetry_payload_init(http_request_t *request, void *arg) {
+  telemetry_payload_t *tp = (telemetry_payload_t *)arg;
+  if ( tp->batch ) {
+    CREATE_CHUNK(uri, URI_LEN);
+    snprintf(uri, URI_LEN, "%s/batch", ARROW_API_TELEMETRY_ENDPOINT);
+    http_request_init(request, POST, uri);
+    FREE_CHUNK(uri);
+#if defined(TELEMETRY_BATCH_GZIP)
+    request->is_gzip = 1;
+#endif
+  } else {
+    http_request_init(request, POST, ARROW_API_TELEMETRY_ENDPOINT);
+  }
+  request->is_chunked = 1;
+  http_request_set_payload(request, p_const(tp->payload));
+}
+
+int arrow_send_telemetry_payload(const char *payload, int batch) {
+  telemetry_payload_t tp = { payload, batch };
+  STD_ROUTINE(_telemetry_payload_init, &tp,
               NULL, NULL,
               "Arrow Telemetry send failed...");
 }
@@ -124,65 +197,128 @@ int arrow_telemetry_find_by_application_hid(const char *hid, int n, ...) {
               "Arrow Telemetry find by failed...");
 }
 
+// the list is parsed while the response is received
+typedef struct {
+  telemetry_hid_t app;
+  telemetry_response_data_list_t *list;
+  telemetry_data_info_t *item;
+  int in_data;
+  int list_mask;
+  int item_mask;
+  json_sax_t sax;
+} telemetry_find_t;
+
+#define FIND_LIST_FIELDS  0x0f
+#define FIND_ITEM_FIELDS  0x1f
+
+static void _telemetry_find_item_free(telemetry_find_t *f) {
+  if ( !f->item ) return;
+  if ( f->item->deviceHid ) free(f->item->deviceHid);
+  if ( f->item->name ) free(f->item->name);
+  if ( f->item->type ) free(f->item->type);
+  free(f->item);
+  f->item = NULL;
+}
+
+static int _telemetry_find_item_string(telemetry_find_t *f, json_sax_t *p) {
+  char **field = NULL;
+  int bit = 0;
+  if ( strcmp(p->key, "deviceHid") == 0 ) { field = &f->item->deviceHid; bit = 0x01; }
+  else if ( strcmp(p->key, "name") == 0 ) { field = &f->item->name; bit = 0x02; }
+  else if ( strcmp(p->key, "type") == 0 ) { field = &f->item->type; bit = 0x04; }
+  if ( !field ) return 0;
+  if ( p->truncated ) return -1;
+  if ( *field ) free(*field);
+  *field = strdup(p->value);
+  if ( !*field ) return -1;
+  f->item_mask |= bit;
+  return 0;
+}
+
+static int _telemetry_find_sax(json_sax_t *p, json_sax_event_t ev, void *arg) {
+  telemetry_find_t *f = (telemetry_find_t *)arg;
+  telemetry_response_data_list_t *t = f->list;
+  if ( p->depth == 1 ) {
+    if ( ev == json_sax_number ) {
+      if ( strcmp(p->key, "size") == 0 ) { t->size = (int)p->number; f->list_mask |= 0x01; }
+      else if ( strcmp(p->key, "page") == 0 ) { t->page = (int)p->number; f->list_mask |= 0x02; }
+      else if ( strcmp(p->key, "totalSize") == 0 ) { t->totalSize = (int)p->number; f->list_mask |= 0x04; }
+      else if ( strcmp(p->key, "totalPages") == 0 ) { t->totalPages = (int)p->number; f->list_mask |= 0x08; }
+    } else if ( ev == json_sax_array_start ) {
+      f->in_data = ( strcmp(p->key, "data") == 0 );
+    } else if ( ev == json_sax_array_end ) {
+      f->in_data = 0;
+    }
+    return 0;
+  }
+  if ( !f->in_data ) return 0;
+  if ( p->depth == 2 ) {
+    // the data elements should be objects
+    if ( ev == json_sax_object_start ) {
+      f->item = (telemetry_data_info_t *)calloc(1, sizeof(telemetry_data_info_t));
+      if ( !f->item ) return -1;
+      f->item_mask = 0;
+      return 0;
+    }
+    if ( ev != json_sax_object_end ) return -1;
+    if ( f->item_mask != FIND_ITEM_FIELDS ) return -1;
+    linked_list_add_node_last(t->data, telemetry_data_info_t, f->item);
+    f->item = NULL;
+    return 0;
+  }
+  if ( p->depth == 3 ) {
+    if ( ev == json_sax_string ) return _telemetry_find_item_string(f, p);
+    if ( ev == json_sax_number ) {
+      if ( strcmp(p->key, "timestamp") == 0 ) {
+        f->item->timestamp = (time_t)p->number;
+        f->item_mask |= 0x08;
+      } else if ( strcmp(p->key, "floatValue") == 0 ) {
+        f->item->floatValue = (int)p->number;
+        f->item_mask |= 0x10;
+      }
+    }
+  }
+  return 0;
+}
+
+static int _telemetry_find_payload_handler(void *r, property_t payload, int size) {
+  http_response_t *res = (http_response_t *)r;
+  telemetry_find_t *f = (telemetry_find_t *)res->_p_meth.arg;
+  if ( !res->processed_payload_chunk ) {
+    // the response may be received again after a failure
+    _telemetry_find_item_free(f);
+    telemetry_response_data_list_free(f->list);
+    telemetry_response_data_list_init(f->list, 0, 0, 0, 0);
+    f->in_data = 0;
+    f->list_mask = 0;
+    json_sax_init(&f->sax, _telemetry_find_sax, f);
+  }
+  // a syntax error is kept by the parser until the proc
+  json_sax_feed(&f->sax, payload.value, size);
+  return 0;
+}
+
 static void _telemetry_find_by_device_hid_init(http_request_t *request, void *arg) {
-  telemetry_hid_t *appl = (telemetry_hid_t *)arg;
+  telemetry_find_t *f = (telemetry_find_t *)arg;
   CREATE_CHUNK(uri, URI_LEN);
-  snprintf(uri, URI_LEN, "%s/devices/%s", ARROW_API_TELEMETRY_ENDPOINT, appl->hid);
+  snprintf(uri, URI_LEN, "%s/devices/%s", ARROW_API_TELEMETRY_ENDPOINT, f->app.hid);
   http_request_init(request, GET, uri);
   FREE_CHUNK(uri);
-  http_request_set_findby(request, appl->params);
+  http_request_set_findby(request, f->app.params);
+  request->_response_payload_meth._p_add_handler = _telemetry_find_payload_handler;
+  request->_response_payload_meth.arg = f;
+  json_sax_init(&f->sax, _telemetry_find_sax, f);
 }
 
 static int _telemetry_find_by_device_hid_proc(http_response_t *response, void *arg) {
-  telemetry_response_data_list_t* t = (telemetry_response_data_list_t*)arg;
+  telemetry_find_t *f = (telemetry_find_t *)arg;
   if ( response->m_httpResponseCode != 200 ) return -1;
-  DBG("telem appl: %s", P_VALUE(response->payload.buf));
-  JsonNode *_main = json_decode(P_VALUE(response->payload.buf));
-  JsonNode *size  = json_find_member(_main, "size");
-  if ( !size ) return -1;
-  JsonNode *page  = json_find_member(_main, "page");
-  if ( !page ) return -1;
-  JsonNode *totalSize  = json_find_member(_main, "totalSize");
-  if ( !totalSize ) return -1;
-  JsonNode *totalPages  = json_find_member(_main, "totalPages");
-  if ( !totalPages ) return -1;
-  telemetry_response_data_list_init(t, json_number(size),
-                                    json_number(page),
-                                    json_number(totalSize),
-                                    json_number(totalPages));
-  JsonNode *data  = json_find_member(_main, "data");
-  if ( !data ) return 0;
-  int i = 0;
-  for ( i = 0; i < t->size; i++ ) {
-    JsonNode *info = json_find_element(data, i);
-    if ( !info ) goto parse_error;
-
-    JsonNode *deviceHid = json_find_member(info, "deviceHid");
-    if ( !deviceHid ) goto parse_error;
-    JsonNode *name = json_find_member(info, "name");
-    if ( !name ) goto parse_error;
-    JsonNode *type = json_find_member(info, "type");
-    if ( !type ) goto parse_error;
-    JsonNode *timestamp = json_find_member(info, "timestamp");
-    if ( !timestamp ) goto parse_error;
-    JsonNode *floatValue = json_find_member(info, "floatValue");
-    if ( !floatValue ) goto parse_error;
-
-    add_telemetry_data_info(t,
-                            deviceHid->string_,
-                            name->string_,
-                            type->string_,
-                            json_number(timestamp),
-                            json_number(floatValue));
+  if ( json_sax_finish(&f->sax) < 0 || f->item ||
+       f->list_mask != FIND_LIST_FIELDS ) {
+    DBG("parse error");
+    return -1;
   }
-  json_delete(_main);
   return 0;
-
-parse_error:
-  DBG("parse error");
-  json_delete(_main);
-  telemetry_response_data_list_free(t);
-  return -1;
 }
 
 int arrow_telemetry_find_by_device_hid(const char *hid,
@@ -190,10 +326,21 @@ int arrow_telemetry_find_by_device_hid(const char *hid,
                                        int n, ...) {
   find_by_t *params = NULL;
   find_by_collect(params, n);
-  telemetry_hid_t app = {params, hid};
-  STD_ROUTINE(_telemetry_find_by_device_hid_init, &app,
-              _telemetry_find_by_device_hid_proc, data,
-              "Arrow Telemetry find by failed...");
+  telemetry_find_t f;
+  memset(&f, 0x0, sizeof(telemetry_find_t));
+  f.app.params = params;
+  f.app.hid = hid;
+  f.list = data;
+  telemetry_response_data_list_init(data, 0, 0, 0, 0);
+  int ret = __http_routine(_telemetry_find_by_device_hid_init, &f,
+                           _telemetry_find_by_device_hid_proc, &f);
+  if ( ret < 0 ) {
+    _telemetry_find_item_free(&f);
+    telemetry_response_data_list_free(data);
+    telemetry_response_data_list_init(data, 0, 0, 0, 0);
+    DBG("Error: Arrow Telemetry find by failed...");
+  }
+  return ret;
 }
 
 static void _telemetry_find_by_node_hid_init(http_request_t *request, void *arg) {
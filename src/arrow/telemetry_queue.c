@@ -0,0 +1,404 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "arrow/telemetry_queue.h"
+#include <sys/mem.h>
+#include <debug.h>
+
+#define SEG_MAGIC     0x54515347
+#define SEG_HDR       8
+#define REC_HDR       3
+#define REC_FREE      0xFF
+#define REC_STORED    0xFE
+#define REC_SENT      0x00
+#define REC_MAX       ( TELEMETRY_QUEUE_SEGMENT_SIZE - SEG_HDR - REC_HDR )
+
+#if defined(__linux__)
+# include <stdio.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+static uint8_t *seg_map[TELEMETRY_QUEUE_SEGMENTS];
+
+// the file is created by the first write only,
+// the missing one reads as erased
+static uint8_t *seg_mem(int seg, int create) {
+  char path[sizeof(TELEMETRY_QUEUE_PATH) + 16];
+  struct stat st;
+  void *mem;
+  int fresh;
+  int fd;
+  if ( seg < 0 || seg >= TELEMETRY_QUEUE_SEGMENTS ) {
+    errno = EINVAL;
+    return NULL;
+  }
+  if ( seg_map[seg] ) return seg_map[seg];
+  snprintf(path, sizeof(path), "%s%d.seg", TELEMETRY_QUEUE_PATH, seg);
+  fd = open(path, create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+  if ( fd < 0 ) return NULL;
+  fresh = fstat(fd, &st) < 0 || st.st_size != TELEMETRY_QUEUE_SEGMENT_SIZE;
+  if ( fresh && ftruncate(fd, TELEMETRY_QUEUE_SEGMENT_SIZE) < 0 ) {
+    close(fd);
+    return NULL;
+  }
+  mem = mmap(NULL, TELEMETRY_QUEUE_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( mem == MAP_FAILED ) return NULL;
+  seg_map[seg] = (uint8_t *)mem;
+  if ( fresh ) memset(mem, 0xFF, TELEMETRY_QUEUE_SEGMENT_SIZE);
+  return seg_map[seg];
+}
+
+static void seg_unmap(void) {
+  int i;
+  for ( i = 0; i < TELEMETRY_QUEUE_SEGMENTS; i++ ) {
+    if ( !seg_map[i] ) continue;
+    munmap(seg_map[i], TELEMETRY_QUEUE_SEGMENT_SIZE);
+    seg_map[i] = NULL;
+  }
+}
+
+int __attribute__((weak)) telemetry_queue_seg_read(int seg, int offset, void *buf, int len) {
+  uint8_t *mem = seg_mem(seg, 0);
+  if ( !mem ) {
+    if ( errno != ENOENT ) return -1;
+    memset(buf, 0xFF, (size_t)len);
+    return len;
+  }
+  memcpy(buf, mem + offset, (size_t)len);
+  return len;
+}
+
+int __attribute__((weak)) telemetry_queue_seg_write(int seg, int offset, const void *buf, int len) {
+  uint8_t *mem = seg_mem(seg, 1);
+  if ( !mem ) return -1;
+  memcpy(mem + offset, buf, (size_t)len);
+  return len;
+}
+
+int __attribute__((weak)) telemetry_queue_seg_erase(int seg) {
+  uint8_t *mem = seg_mem(seg, 0);
+  if ( !mem ) return errno == ENOENT ? 0 : -1;
+  memset(mem, 0xFF, TELEMETRY_QUEUE_SEGMENT_SIZE);
+  return 0;
+}
+#else
+# define seg_unmap()
+
+int __attribute__((weak)) telemetry_queue_seg_read(int seg, int offset, void *buf, int len) {
+  SSP_PARAMETER_NOT_USED(seg);
+  SSP_PARAMETER_NOT_USED(offset);
+  SSP_PARAMETER_NOT_USED(buf);
+  SSP_PARAMETER_NOT_USED(len);
+  return -1;
+}
+
+int __attribute__((weak)) telemetry_queue_seg_write(int seg, int offset, const void *buf, int len) {
+  SSP_PARAMETER_NOT_USED(seg);
+  SSP_PARAMETER_NOT_USED(offset);
+  SSP_PARAMETER_NOT_USED(buf);
+  SSP_PARAMETER_NOT_USED(len);
+  return -1;
+}
+
+int __attribute__((weak)) telemetry_queue_seg_erase(int seg) {
+  SSP_PARAMETER_NOT_USED(seg);
+  return -1;
+}
+#endif
+
+typedef struct {
+  int ready;
+  // the oldest stored record
+  int head_seg;
+  int head_off;
+  // the append point
+  int tail_seg;
+  int tail_off;
+  uint32_t seq;
+  int count;
+  int dropped;
+} telemetry_queue_t;
+
+static telemetry_queue_t _queue = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+typedef struct {
+  uint8_t state;
+  int len;
+} record_t;
+
+// return: 0 or -1 if there is no valid record at off
+static int record_read(int seg, int off, record_t *rec) {
+  uint8_t hdr[REC_HDR];
+  if ( off + REC_HDR > TELEMETRY_QUEUE_SEGMENT_SIZE ) return -1;
+  if ( telemetry_queue_seg_read(seg, off, hdr, REC_HDR) < 0 ) return -1;
+  rec->state = hdr[0];
+  rec->len = hdr[1] | ( hdr[2] << 8 );
+  // the free space or the length was cut by the power loss
+  if ( rec->len > REC_MAX || off + REC_HDR + rec->len > TELEMETRY_QUEUE_SEGMENT_SIZE ) return -1;
+  return 0;
+}
+
+static int seg_header(int seg, uint32_t *seq) {
+  uint32_t hdr[2];
+  if ( telemetry_queue_seg_read(seg, 0, hdr, SEG_HDR) < 0 ) return -1;
+  if ( hdr[0] != SEG_MAGIC ) return -1;
+  *seq = hdr[1];
+  return 0;
+}
+
+static int seg_start(int seg, uint32_t seq) {
+  uint32_t hdr[2] = { SEG_MAGIC, seq };
+  if ( telemetry_queue_seg_erase(seg) < 0 ) return -1;
+  if ( telemetry_queue_seg_write(seg, 0, hdr, SEG_HDR) < 0 ) return -1;
+  return 0;
+}
+
+// walk through the sent and broken records up to the stored one
+// or the append point
+static void seek_stored(int *seg, int *off) {
+  record_t rec;
+  while ( *seg != _queue.tail_seg || *off < _queue.tail_off ) {
+    if ( record_read(*seg, *off, &rec) < 0 ) {
+      *seg = ( *seg + 1 ) % TELEMETRY_QUEUE_SEGMENTS;
+      *off = SEG_HDR;
+      continue;
+    }
+    if ( rec.state == REC_STORED ) return;
+    *off += REC_HDR + rec.len;
+  }
+}
+
+// scan the segment: the stored records and the append point
+static int seg_scan(int seg, int from, int *stored) {
+  record_t rec;
+  int off = SEG_HDR;
+  *stored = 0;
+  while ( record_read(seg, off, &rec) == 0 ) {
+    if ( off >= from && rec.state == REC_STORED ) ( *stored )++;
+    off += REC_HDR + rec.len;
+  }
+  // nothing can be appended after the broken length
+  if ( off + REC_HDR <= TELEMETRY_QUEUE_SEGMENT_SIZE ) {
+    uint8_t hdr[REC_HDR];
+    if ( telemetry_queue_seg_read(seg, off, hdr, REC_HDR) < 0 ) return -1;
+    if ( hdr[1] != 0xFF || hdr[2] != 0xFF ) off = TELEMETRY_QUEUE_SEGMENT_SIZE;
+  }
+  return off;
+}
+
+int telemetry_queue_init(void) {
+  uint32_t seq = 0;
+  int found = 0;
+  int stored;
+  int i;
+  if ( _queue.ready ) return _queue.ready > 0 ? 0 : -1;
+  memset(&_queue, 0, sizeof(_queue));
+  _queue.ready = -1;
+  for ( i = 0; i < TELEMETRY_QUEUE_SEGMENTS; i++ ) {
+    uint32_t s;
+    if ( seg_header(i, &s) < 0 ) continue;
+    if ( !found || s > seq ) {
+      seq = s;
+      _queue.tail_seg = i;
+    }
+    found = 1;
+  }
+  if ( !found ) {
+    // nothing is written until the first push starts the segment 0
+    _queue.tail_seg = TELEMETRY_QUEUE_SEGMENTS - 1;
+    _queue.tail_off = TELEMETRY_QUEUE_SEGMENT_SIZE;
+  } else {
+    _queue.tail_off = seg_scan(_queue.tail_seg, 0, &stored);
+    if ( _queue.tail_off < 0 ) return -1;
+  }
+  _queue.seq = seq;
+  _queue.head_seg = _queue.tail_seg;
+  _queue.head_off = _queue.tail_off;
+  // the segments before the last one, the oldest first
+  for ( i = TELEMETRY_QUEUE_SEGMENTS - 1; found && i >= 0; i-- ) {
+    int seg = ( _queue.tail_seg + TELEMETRY_QUEUE_SEGMENTS - i ) % TELEMETRY_QUEUE_SEGMENTS;
+    uint32_t s;
+    if ( (uint32_t)i > seq ) continue;
+    if ( seg_header(seg, &s) < 0 || s != seq - (uint32_t)i ) continue;
+    if ( seg_scan(seg, 0, &stored) < 0 ) return -1;
+    if ( !stored ) continue;
+    if ( !_queue.count ) {
+      _queue.head_seg = seg;
+      _queue.head_off = SEG_HDR;
+    }
+    _queue.count += stored;
+  }
+  seek_stored(&_queue.head_seg, &_queue.head_off);
+  _queue.ready = 1;
+  DBG("telemetry queue: %d stored", _queue.count);
+  return 0;
+}
+
+void telemetry_queue_close(void) {
+  memset(&_queue, 0, sizeof(_queue));
+  seg_unmap();
+}
+
+int telemetry_queue_clear(void) {
+  int i;
+  telemetry_queue_close();
+  for ( i = 0; i < TELEMETRY_QUEUE_SEGMENTS; i++ ) {
+    if ( telemetry_queue_seg_erase(i) < 0 ) return -1;
+  }
+  return telemetry_queue_init();
+}
+
+// the next segment of the ring, the oldest one is dropped if it's still stored
+static int next_segment(void) {
+  int seg = ( _queue.tail_seg + 1 ) % TELEMETRY_QUEUE_SEGMENTS;
+  int drop = 0;
+  if ( _queue.count && _queue.head_seg == seg ) {
+    if ( seg_scan(seg, _queue.head_off, &drop) < 0 ) return -1;
+    DBG("telemetry queue: %d dropped", drop);
+  }
+  if ( seg_start(seg, _queue.seq + 1) < 0 ) return -1;
+  _queue.seq++;
+  _queue.tail_seg = seg;
+  _queue.tail_off = SEG_HDR;
+  _queue.dropped += drop;
+  _queue.count -= drop;
+  if ( !_queue.count ) {
+    _queue.head_seg = seg;
+    _queue.head_off = SEG_HDR;
+  } else if ( drop ) {
+    _queue.head_seg = ( seg + 1 ) % TELEMETRY_QUEUE_SEGMENTS;
+    _queue.head_off = SEG_HDR;
+    seek_stored(&_queue.head_seg, &_queue.head_off);
+  }
+  return 0;
+}
+
+int telemetry_queue_push(const char *payload, int len) {
+  uint8_t state = REC_STORED;
+  uint8_t hdr[2];
+  int off;
+  if ( telemetry_queue_init() < 0 ) return -1;
+  if ( len < 0 || len > REC_MAX ) return -1;
+  if ( _queue.tail_off + REC_HDR + len > TELEMETRY_QUEUE_SEGMENT_SIZE ) {
+    if ( next_segment() < 0 ) return -1;
+  }
+  off = _queue.tail_off;
+  hdr[0] = (uint8_t)( len & 0xFF );
+  hdr[1] = (uint8_t)( len >> 8 );
+  // the record is valid after the state byte only
+  if ( telemetry_queue_seg_write(_queue.tail_seg, off + 1, hdr, 2) < 0 ||
+       telemetry_queue_seg_write(_queue.tail_seg, off + REC_HDR, payload, len) < 0 ||
+       telemetry_queue_seg_write(_queue.tail_seg, off, &state, 1) < 0 ) {
+    return -1;
+  }
+  if ( !_queue.count ) {
+    _queue.head_seg = _queue.tail_seg;
+    _queue.head_off = off;
+  }
+  _queue.tail_off = off + REC_HDR + len;
+  _queue.count++;
+  return 0;
+}
+
+int telemetry_queue_count(void) {
+  if ( telemetry_queue_init() < 0 ) return 0;
+  return _queue.count;
+}
+
+int telemetry_queue_dropped(void) {
+  return _queue.dropped;
+}
+
+static int mark_sent(int *seg, int *off) {
+  uint8_t state = REC_SENT;
+  record_t rec;
+  if ( record_read(*seg, *off, &rec) < 0 ) return -1;
+  if ( telemetry_queue_seg_write(*seg, *off, &state, 1) < 0 ) return -1;
+  *off += REC_HDR + rec.len;
+  seek_stored(seg, off);
+  _queue.count--;
+  return 0;
+}
+
+// read the records from (seg, off) one after another into buf,
+// sep is put between them; without buf only the length is counted
+// return: the number of the read records
+static int collect(char *buf, int size, int max, char sep, int *used) {
+  int seg = _queue.head_seg;
+  int off = _queue.head_off;
+  int n = 0;
+  record_t rec;
+  *used = 0;
+  while ( n < max && n < _queue.count ) {
+    int need;
+    if ( record_read(seg, off, &rec) < 0 ) break;
+    need = rec.len + ( n ? 1 : 0 );
+    if ( *used + need > size ) break;
+    if ( buf ) {
+      if ( n ) buf[*used] = sep;
+      if ( telemetry_queue_seg_read(seg, off + REC_HDR, buf + *used + need - rec.len, rec.len) < 0 ) break;
+    }
+    *used += need;
+    off += REC_HDR + rec.len;
+    seek_stored(&seg, &off);
+    n++;
+  }
+  return n;
+}
+
+int telemetry_queue_drain(int max, telemetry_queue_send_f send, void *arg) {
+  char *buf;
+  int sent = 0;
+  if ( telemetry_queue_init() < 0 ) return 0;
+  if ( !_queue.count ) return 0;
+  buf = (char *)malloc(REC_MAX + 1);
+  if ( !buf ) return 0;
+  while ( sent < max && _queue.count ) {
+    int len;
+    if ( collect(buf, REC_MAX, 1, 0, &len) != 1 ) break;
+    buf[len] = 0;
+    if ( send(buf, len, arg) < 0 ) break;
+    if ( mark_sent(&_queue.head_seg, &_queue.head_off) < 0 ) break;
+    sent++;
+  }
+  free(buf);
+  return sent;
+}
+
+int telemetry_queue_drain_batch(int max, telemetry_queue_send_f send, void *arg) {
+  char *buf;
+  int size;
+  int len;
+  int n;
+  int i;
+  if ( telemetry_queue_init() < 0 ) return 0;
+  if ( !_queue.count || max <= 0 ) return 0;
+  // walk the record headers first to size the buffer:
+  // the records with the separators, the brackets and the null
+  max = collect(NULL, TELEMETRY_QUEUE_SEGMENTS * TELEMETRY_QUEUE_SEGMENT_SIZE, max, ',', &size);
+  if ( max <= 0 ) return 0;
+  buf = (char *)malloc((size_t)size + 3);
+  if ( !buf ) return 0;
+  buf[0] = '[';
+  n = collect(buf + 1, size, max, ',', &len);
+  buf[len + 1] = ']';
+  buf[len + 2] = 0;
+  if ( n <= 0 || send(buf, len + 2, arg) < 0 ) {
+    free(buf);
+    return 0;
+  }
+  free(buf);
+  for ( i = 0; i < n; i++ ) {
+    if ( mark_sent(&_queue.head_seg, &_queue.head_off) < 0 ) return i;
+  }
+  return n;
+}
@@ -8,9 +8,10 @@
 
 #include "arrow/utf8.h"
 #include <sys/mem.h>
+#include <json/scan.h>
 
 static int utf8_validate_cz(const char *s) {
-  unsigned char c = (unsigned char) *s;
+  unsigned char c = (unsigned char) *s++;
 
   if ( c > 0x1F && c <= 0x7F) {        /* 1F..7F */
     return 1;
@@ -64,10 +65,14 @@ static int utf8_validate_cz(const char *s) {
 
 int utf8check(const char *s) {
   int len;
-  for (; *s != 0; s += len) {
+  for (;;) {
+    // the printable ASCII runs are checked a block at a time
+    s += json_scan_ascii(s);
+    if ( *s == 0 ) break;
     len = utf8_validate_cz(s);
     if (len == 0)
       return 0;
+    s += len;
   }
   return 1;
 }
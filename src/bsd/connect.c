@@ -0,0 +1,141 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#define MODULE_NAME "BSD_Connect"
+
+#include "bsd/connect.h"
+#include <sys/mem.h>
+#include <time/time.h>
+#include <debug.h>
+
+#if defined(ARCH_SOCK) && defined(__linux__)
+# include <fcntl.h>
+# include <poll.h>
+# include <errno.h>
+
+static void set_blocking(int sock, int on) {
+  int flags = fcntl(sock, F_GETFL, 0);
+  if ( flags < 0 ) return;
+  fcntl(sock, F_SETFL, on ? ( flags & ~O_NONBLOCK ) : ( flags | O_NONBLOCK ));
+}
+
+int __attribute__((weak)) soc_connect_start(int sock, struct sockaddr_in *addr, uint32_t timeout_ms) {
+  SSP_PARAMETER_NOT_USED(timeout_ms);
+  set_blocking(sock, 0);
+  if ( connect(sock, (struct sockaddr*)addr, sizeof(struct sockaddr_in)) == 0 ) {
+    set_blocking(sock, 1);
+    return 0;
+  }
+  return errno == EINPROGRESS ? 1 : -1;
+}
+
+int __attribute__((weak)) soc_connect_wait(int *sock, int count, uint32_t timeout_ms) {
+  struct pollfd fds[SOCK_CONNECT_ADDRESSES];
+  int i;
+  for ( i = 0; i < count; i++ ) {
+    fds[i].fd = sock[i];
+    fds[i].events = POLLOUT;
+    fds[i].revents = 0;
+  }
+  if ( poll(fds, (nfds_t)count, (int)timeout_ms) <= 0 ) return -1;
+  for ( i = 0; i < count; i++ ) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if ( sock[i] < 0 || !fds[i].revents ) continue;
+    if ( getsockopt(sock[i], SOL_SOCKET, SO_ERROR, &err, &len) == 0 && !err ) {
+      set_blocking(sock[i], 1);
+      return i;
+    }
+    soc_close(sock[i]);
+    sock[i] = -1;
+  }
+  return -1;
+}
+#else
+int __attribute__((weak)) soc_connect_start(int sock, struct sockaddr_in *addr, uint32_t timeout_ms) {
+  SSP_PARAMETER_NOT_USED(timeout_ms);
+  if ( connect(sock, (struct sockaddr*)addr, sizeof(struct sockaddr_in)) < 0 ) return -1;
+  return 0;
+}
+
+int __attribute__((weak)) soc_connect_wait(int *sock, int count, uint32_t timeout_ms) {
+  // the blocking connect is never in progress
+  SSP_PARAMETER_NOT_USED(sock);
+  SSP_PARAMETER_NOT_USED(count);
+  SSP_PARAMETER_NOT_USED(timeout_ms);
+  return -1;
+}
+#endif
+
+static uint32_t elapsed_ms(const struct timeval *start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  long ms = (long)( now.tv_sec - start->tv_sec ) * 1000 +
+            (long)( now.tv_usec - start->tv_usec ) / 1000;
+  return ms > 0 ? (uint32_t)ms : 0;
+}
+
+int soc_connect_host(const char *host, uint16_t port, uint32_t timeout_ms) {
+  struct sockaddr_in addr[SOCK_CONNECT_ADDRESSES];
+  int sock[SOCK_CONNECT_ADDRESSES];
+  int count = 0;
+  int started = 0;
+  int done = -1;
+  int i;
+  soc_addr_list_t list;
+  if ( soc_resolve(host, &list) < 0 ) return -1;
+  for ( count = 0; count < list.count; count++ ) {
+    memset(addr + count, 0x0, sizeof(struct sockaddr_in));
+    addr[count].sin_family = PF_INET;
+    addr[count].sin_addr.s_addr = list.addr[count];
+    addr[count].sin_port = htons(port);
+  }
+
+  while ( done < 0 ) {
+    int pending = 0;
+    if ( started < count ) {
+      int s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+      int ret = -1;
+      if ( s >= 0 ) ret = soc_connect_start(s, addr + started, timeout_ms);
+      if ( ret == 0 ) done = started;
+      if ( ret < 0 && s >= 0 ) {
+        DBG("connect fail %d", started);
+        soc_close(s);
+        s = -1;
+      }
+      sock[started++] = s;
+      if ( done >= 0 ) break;
+    }
+    for ( i = 0; i < started; i++ ) if ( sock[i] >= 0 ) pending++;
+    if ( !pending ) {
+      if ( started < count ) continue;
+      break;
+    }
+    // wait for the started ones a bit before the next address
+    uint32_t wait = timeout_ms;
+    if ( started < count && wait > SOCK_CONNECT_DELAY ) wait = SOCK_CONNECT_DELAY;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    done = soc_connect_wait(sock, started, wait);
+    if ( done < 0 ) {
+      // the wait ends early when an attempt fails
+      uint32_t spent = elapsed_ms(&start);
+      if ( spent >= timeout_ms ) break;
+      timeout_ms -= spent;
+    }
+  }
+  for ( i = 0; i < started; i++ ) {
+    if ( i != done && sock[i] >= 0 ) soc_close(sock[i]);
+  }
+  if ( done < 0 ) {
+    // the addresses may be changed
+    soc_resolve_flush(host);
+    return -1;
+  }
+  return sock[done];
+}
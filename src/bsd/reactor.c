@@ -0,0 +1,109 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#define MODULE_NAME "BSD_Reactor"
+
+#include "bsd/reactor.h"
+#include <sys/mem.h>
+#include <time/time.h>
+#include <debug.h>
+
+#if defined(ARCH_SOCK) && defined(__linux__)
+# include <sys/epoll.h>
+# define REACTOR_EPOLL
+#endif
+
+typedef struct {
+  int sock;
+  reactor_cb_f cb;
+  void *arg;
+} reactor_slot_t;
+
+static reactor_slot_t _slots[REACTOR_SIZE];
+static int _count = 0;
+#if defined(REACTOR_EPOLL)
+static int _epfd = -1;
+#endif
+
+static reactor_slot_t *slot_find(int sock) {
+  int i;
+  for ( i = 0; i < _count; i++ ) {
+    if ( _slots[i].sock == sock ) return _slots + i;
+  }
+  return NULL;
+}
+
+int reactor_add(int sock, reactor_cb_f cb, void *arg) {
+  reactor_slot_t *s = slot_find(sock);
+  if ( !s ) {
+    if ( _count == REACTOR_SIZE ) {
+      DBG("reactor is full");
+      return -1;
+    }
+#if defined(REACTOR_EPOLL)
+    struct epoll_event ev;
+    if ( _epfd < 0 ) _epfd = epoll_create1(0);
+    if ( _epfd < 0 ) return -1;
+    memset(&ev, 0x0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = sock;
+    if ( epoll_ctl(_epfd, EPOLL_CTL_ADD, sock, &ev) < 0 ) return -1;
+#endif
+    s = _slots + _count++;
+    s->sock = sock;
+  }
+  s->cb = cb;
+  s->arg = arg;
+  return 0;
+}
+
+void reactor_del(int sock) {
+  reactor_slot_t *s = slot_find(sock);
+  if ( !s ) return;
+#if defined(REACTOR_EPOLL)
+  epoll_ctl(_epfd, EPOLL_CTL_DEL, sock, NULL);
+#endif
+  *s = _slots[--_count];
+}
+
+#if defined(REACTOR_EPOLL)
+int reactor_poll(uint32_t timeout_ms) {
+  struct epoll_event ev[REACTOR_SIZE];
+  int i, n, handled = 0;
+  if ( !_count ) {
+    msleep((int)timeout_ms);
+    return 0;
+  }
+  n = epoll_wait(_epfd, ev, REACTOR_SIZE, (int)timeout_ms);
+  if ( n < 0 ) return -1;
+  for ( i = 0; i < n; i++ ) {
+    // a handler may remove the other sockets
+    reactor_slot_t *s = slot_find(ev[i].data.fd);
+    if ( !s ) continue;
+    s->cb(s->sock, s->arg);
+    handled++;
+  }
+  return handled;
+}
+#else
+int reactor_poll(uint32_t timeout_ms) {
+  reactor_slot_t ready[REACTOR_SIZE];
+  int i, n = _count;
+  if ( !n ) {
+    msleep((int)timeout_ms);
+    return 0;
+  }
+  // the handlers may change the list
+  memcpy(ready, _slots, sizeof(reactor_slot_t) * (size_t)n);
+  for ( i = 0; i < n; i++ ) {
+    if ( !slot_find(ready[i].sock) ) continue;
+    ready[i].cb(ready[i].sock, ready[i].arg);
+  }
+  return n;
+}
+#endif
@@ -0,0 +1,117 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#define MODULE_NAME "BSD_Resolve"
+
+#include "bsd/resolve.h"
+#include <bsd/socket.h>
+#include <sys/mem.h>
+#include <time/time.h>
+#include <debug.h>
+
+void __attribute__((weak)) soc_resolve_lock(void) {}
+void __attribute__((weak)) soc_resolve_unlock(void) {}
+
+static int lookup(const char *host, soc_addr_list_t *list) {
+  struct hostent *serv_resolve = gethostbyname(host);
+  list->count = 0;
+  if ( !serv_resolve || serv_resolve->h_addrtype != AF_INET ) return -1;
+  while ( list->count < SOCK_CONNECT_ADDRESSES ) {
+    char *a = serv_resolve->h_addr_list ? serv_resolve->h_addr_list[list->count] :
+              ( list->count ? NULL : serv_resolve->h_addr );
+    if ( !a ) break;
+    list->addr[list->count] = 0;
+    memcpy(list->addr + list->count, a,
+           serv_resolve->h_length < 4 ? (size_t)serv_resolve->h_length : 4);
+    list->count++;
+  }
+  return list->count ? 0 : -1;
+}
+
+#if SOCK_DNS_CACHE_SIZE > 0
+typedef struct {
+  char host[SOCK_DNS_HOST_LEN];
+  soc_addr_list_t list;
+  time_t expire;
+} dns_entry_t;
+
+static dns_entry_t _cache[SOCK_DNS_CACHE_SIZE];
+
+static dns_entry_t *cache_find(const char *host, time_t now) {
+  int i;
+  for ( i = 0; i < SOCK_DNS_CACHE_SIZE; i++ ) {
+    dns_entry_t *e = _cache + i;
+    if ( !e->host[0] ) continue;
+    if ( now >= e->expire || now + SOCK_DNS_TTL < e->expire ) {
+      // expired or the clock was set back
+      e->host[0] = 0x0;
+      continue;
+    }
+    if ( !strcmp(e->host, host) ) return e;
+  }
+  return NULL;
+}
+
+static void cache_put(const char *host, soc_addr_list_t *list, time_t expire) {
+  int i;
+  dns_entry_t *e = _cache;
+  // a free entry or the one expiring first
+  for ( i = 0; i < SOCK_DNS_CACHE_SIZE; i++ ) {
+    if ( !_cache[i].host[0] ) { e = _cache + i; break; }
+    if ( _cache[i].expire < e->expire ) e = _cache + i;
+  }
+  strcpy(e->host, host);
+  e->list = *list;
+  e->expire = expire;
+}
+#endif
+
+int soc_resolve(const char *host, soc_addr_list_t *list) {
+  int ret;
+  soc_resolve_lock();
+#if SOCK_DNS_CACHE_SIZE > 0
+  time_t now = time(NULL);
+  dns_entry_t *e = NULL;
+  if ( strlen(host) < SOCK_DNS_HOST_LEN ) {
+    e = cache_find(host, now);
+    if ( e ) {
+      *list = e->list;
+      soc_resolve_unlock();
+      return list->count ? 0 : -1;
+    }
+  }
+  ret = lookup(host, list);
+  if ( strlen(host) < SOCK_DNS_HOST_LEN ) {
+    // the failed name is kept too but for the short time
+    cache_put(host, list, now + ( ret < 0 ? SOCK_DNS_NEG_TTL : SOCK_DNS_TTL ));
+  }
+#else
+  ret = lookup(host, list);
+#endif
+  soc_resolve_unlock();
+  if ( ret < 0 ) DBG("ERROR, no such host %s", host);
+  return ret;
+}
+
+int soc_resolve_prefetch(const char *host) {
+  soc_addr_list_t list;
+  return soc_resolve(host, &list);
+}
+
+void soc_resolve_flush(const char *host) {
+#if SOCK_DNS_CACHE_SIZE > 0
+  int i;
+  soc_resolve_lock();
+  for ( i = 0; i < SOCK_DNS_CACHE_SIZE; i++ ) {
+    if ( !host || !strcmp(_cache[i].host, host) ) _cache[i].host[0] = 0x0;
+  }
+  soc_resolve_unlock();
+#else
+  SSP_PARAMETER_NOT_USED(host);
+#endif
+}
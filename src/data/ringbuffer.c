@@ -74,3 +74,50 @@ int ringbuf_pop(ring_buffer_t *buf, uint8_t *s, int len) {
     buf->size -= len;
     return 0;
 }
+
+uint8_t *ringbuf_write_span(ring_buffer_t *buf, uint16_t *len) {
+    // an empty buffer: start from the beginning to get the longest span
+    if ( !buf->size ) buf->shift = 0;
+    int wr = ( buf->shift + buf->size ) % buf->total;
+    int till_border = buf->total - wr;
+    int cap = ringbuf_capacity(buf);
+    *len = (uint16_t)( cap < till_border ? cap : till_border );
+    return buf->buffer + wr;
+}
+
+int ringbuf_commit(ring_buffer_t *buf, uint16_t len) {
+    if ( ringbuf_capacity(buf) < len ) return -1;
+    buf->size += len;
+    return 0;
+}
+
+uint8_t *ringbuf_read_span(ring_buffer_t *buf, uint16_t *len) {
+    int till_border = buf->total - buf->shift;
+    *len = (uint16_t)( buf->size < till_border ? buf->size : till_border );
+    return buf->buffer + buf->shift;
+}
+
+int ringbuf_consume(ring_buffer_t *buf, uint16_t len) {
+    if ( ringbuf_size(buf) < len ) return -1;
+    buf->shift = ( buf->shift + len ) % buf->total;
+    buf->size -= len;
+    return 0;
+}
+
+static void ringbuf_reverse(uint8_t *b, int len) {
+    uint8_t *e = b + len - 1;
+    while ( b < e ) {
+        uint8_t t = *b;
+        *b++ = *e;
+        *e-- = t;
+    }
+}
+
+void ringbuf_linearize(ring_buffer_t *buf) {
+    if ( !buf->shift ) return;
+    // rotate in place: no additional memory
+    ringbuf_reverse(buf->buffer, buf->shift);
+    ringbuf_reverse(buf->buffer + buf->shift, buf->total - buf->shift);
+    ringbuf_reverse(buf->buffer, buf->total);
+    buf->shift = 0;
+}
@@ -0,0 +1,91 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#define MODULE_NAME "HTTP_Async"
+
+#include "http/async.h"
+#include <http/pool.h>
+#include <bsd/reactor.h>
+#include <debug.h>
+
+typedef struct {
+  http_client_t *cli;
+  http_request_t *req;
+  http_complete_f done;
+  void *arg;
+  int reused;
+} http_async_t;
+
+static http_async_t _async[HTTP_POOL_SIZE];
+
+static void async_ready(int sock, void *arg) {
+  http_async_t a = *(http_async_t *)arg;
+  http_response_t res;
+  reactor_del(sock);
+  // the slot may be used by the callback already
+  ((http_async_t *)arg)->cli = NULL;
+  int ret = http_client_receive(a.cli, a.req, &res);
+  // a kept alive connection was closed by the server before any
+  // byte of the answer: repeat the request on a new one
+  // (a timeout or a partial answer is not repeated,
+  // http_client_close keeps the flag and the queue)
+  int stale = a.cli->peer_closed && !ringbuf_size(a.cli->queue);
+  if ( ret < 0 && a.reused && stale ) {
+    http_response_free(&res);
+    ret = http_client_do(a.cli, a.req, &res);
+  }
+  http_pool_release(a.cli);
+  a.done(a.req, &res, ret, a.arg);
+  http_response_free(&res);
+}
+
+int http_client_do_async(http_request_t *req, http_complete_f on_complete, void *arg) {
+  int i;
+  http_async_t *a = NULL;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( !_async[i].cli ) {
+      a = _async + i;
+      break;
+    }
+  }
+  if ( !a ) {
+    DBG("too many requests in flight");
+    return -1;
+  }
+  http_client_t *cli = http_pool_acquire(req);
+  if ( !cli ) return -1;
+  int reused = ( cli->sock >= 0 );
+  int ret = http_client_send(cli, req);
+  if ( ret < 0 && reused ) {
+    // the failed connection is closed, try a new one
+    reused = 0;
+    ret = http_client_send(cli, req);
+  }
+  if ( ret < 0 ) {
+    http_pool_release(cli);
+    return -1;
+  }
+  a->reused = reused;
+  a->cli = cli;
+  a->req = req;
+  a->done = on_complete;
+  a->arg = arg;
+  if ( reactor_add(cli->sock, async_ready, a) < 0 ) {
+    // no room to wait: receive right now
+    async_ready(cli->sock, a);
+  }
+  return 0;
+}
+
+int http_async_pending(void) {
+  int i, n = 0;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( _async[i].cli ) n++;
+  }
+  return n;
+}
@@ -15,9 +15,19 @@
 
 #include <debug.h>
 #include <bsd/socket.h>
+#include <bsd/connect.h>
 #include <time/time.h>
 
 #include <ssl/ssl.h>
+#include <http/encoding.h>
+#include <http/parser.h>
+
+#if defined(ARCH_SOCK) && defined(__linux__)
+# include <errno.h>
+# define peer_reset(ret) ( (ret) < 0 && errno == ECONNRESET )
+#else
+# define peer_reset(ret) 0
+#endif
 
 #if !defined(MAX_BUFFER_SIZE)
 #define MAX_BUFFER_SIZE 1024
@@ -55,21 +65,17 @@ bool http_session_close(http_client_t *cli) {
 #define client_send_direct(cli, buf, size)  (*(cli->_w_func))((cli), (uint8_t*)(buf), (size))
 #define client_recv(cli, size)              (*(cli->_r_func))((cli), NULL, (size))
 
+// receive right into the free space of the queue
 static int simple_read(void *c, uint8_t *buf, uint16_t len) {
     SSP_PARAMETER_NOT_USED(buf);
-    CREATE_CHUNK(tmp, MAX_TMP_BUF_SIZE);
     http_client_t *cli = (http_client_t *)c;
-    if ( len > ringbuf_capacity(cli->queue) )
-        len = ringbuf_capacity(cli->queue);
-    int ret = recv(cli->sock, tmp, len, 0);
-    if ( ret > 0 ) {
-        if ( ringbuf_push(cli->queue, (uint8_t*)tmp, ret) < 0 ) {
-            FREE_CHUNK(tmp);
-            return -1;
-        }
-    }
-    HTTP_DBG("%d|%s|", ret, tmp);
-    FREE_CHUNK(tmp);
+    uint16_t span = 0;
+    uint8_t *ptr = ringbuf_write_span(cli->queue, &span);
+    if ( len > span ) len = span;
+    if ( !len ) return -1;
+    int ret = recv(cli->sock, ptr, len, 0);
+    if ( ret > 0 ) ringbuf_commit(cli->queue, (uint16_t)ret);
+    HTTP_DBG("%d|%.*s|", ret, ret > 0 ? ret : 0, ptr);
     return ret;
 }
 
@@ -92,19 +98,14 @@ static int simple_write(void *c, uint8_t *buf, uint16_t len) {
 
 static int ssl_read(void *c, uint8_t *buf, uint16_t len) {
     SSP_PARAMETER_NOT_USED(buf);
-    CREATE_CHUNK(tmp, MAX_TMP_BUF_SIZE);
     http_client_t *cli = (http_client_t *)c;
-    if ( len > ringbuf_capacity(cli->queue) )
-        len = ringbuf_capacity(cli->queue);
-    int ret = ssl_recv(cli->sock, tmp, (int)len);
-    if ( ret > 0 ) {
-        if ( ringbuf_push(cli->queue, (uint8_t*)tmp, ret) < 0 ) {
-            FREE_CHUNK(tmp);
-            return -1;
-        }
-    }
-    HTTP_DBG("[%d]{%s}", ret, tmp);
-    FREE_CHUNK(tmp);
+    uint16_t span = 0;
+    uint8_t *ptr = ringbuf_write_span(cli->queue, &span);
+    if ( len > span ) len = span;
+    if ( !len ) return -1;
+    int ret = ssl_recv(cli->sock, (char*)ptr, (int)len);
+    if ( ret > 0 ) ringbuf_commit(cli->queue, (uint16_t)ret);
+    HTTP_DBG("[%d]{%.*s}", ret, ret > 0 ? ret : 0, ptr);
     return ret;
 }
 
@@ -147,14 +148,18 @@ void http_client_init(http_client_t *cli) {
     }
 }
 
+void http_client_close(http_client_t *cli) {
+  if ( cli->sock >= 0 ) {
+    if ( cli->is_cipher ) ssl_close(cli->sock);
+    soc_close(cli->sock);
+  }
+  cli->sock = -1;
+  property_free(&cli->host);
+}
+
 void http_client_free(http_client_t *cli) {
   if ( cli->flags._close ) {
-    if ( cli->sock >= 0 ) {
-#if defined(HTTP_CIPHER)
-      ssl_close(cli->sock);
-#endif
-      soc_close(cli->sock);
-    }
+    http_client_close(cli);
     ringbuf_free(cli->queue);
     free(cli->queue);
     cli->queue = NULL;
@@ -165,359 +170,582 @@ void http_client_free(http_client_t *cli) {
   }
 }
 
+// the request head (start line, headers and the first part of the body)
+// is assembled here and leaves the client in as few writes as possible
+typedef struct {
+    http_client_t *cli;
+    int len;
+    int err;
+} http_head_t;
+
+static uint8_t headbuffer[MAX_BUFFER_SIZE];
+
+static void head_init(http_head_t *h, http_client_t *cli) {
+    h->cli = cli;
+    h->len = 0;
+    h->err = 0;
+}
+
+static int head_flush(http_head_t *h) {
+    if ( h->err ) return h->err;
+    int sent = 0;
+    while ( sent < h->len ) {
+        int ret = client_send_direct(h->cli, headbuffer + sent, h->len - sent);
+        if ( ret <= 0 ) {
+            h->err = ret < 0 ? ret : -1;
+            return h->err;
+        }
+        sent += ret;
+    }
+    h->len = 0;
+    return 0;
+}
+
+static int head_add(http_head_t *h, const char *data, int len) {
+    if ( h->err ) return h->err;
+    if ( len < 0 ) len = (int)strlen(data);
+    while ( len > 0 ) {
+        int room = (int)sizeof(headbuffer) - h->len;
+        if ( !room ) {
+            if ( head_flush(h) < 0 ) return h->err;
+            room = (int)sizeof(headbuffer);
+        }
+        if ( !h->len && len >= room ) {
+            // too big for the buffer anyway: send it as is
+            int ret = client_send_direct(h->cli, data, len > 0xffff ? 0xffff : len);
+            if ( ret <= 0 ) {
+                h->err = ret < 0 ? ret : -1;
+                return h->err;
+            }
+            data += ret;
+            len -= ret;
+            continue;
+        }
+        int part = len < room ? len : room;
+        memcpy(headbuffer + h->len, data, (size_t)part);
+        h->len += part;
+        data += part;
+        len -= part;
+    }
+    return 0;
+}
+
+static int head_add_field(http_head_t *h, const char *key, const char *value) {
+    head_add(h, key, -1);
+    head_add(h, ": ", 2);
+    head_add(h, value, -1);
+    return head_add(h, "\r\n", 2);
+}
+
 #define HTTP_VERS " HTTP/1.1\r\n"
-static int send_start(http_client_t *cli, http_request_t *req, ring_buffer_t *buf) {
-    ringbuf_clear(buf);
-    int ret = snprintf((char*)tmpbuffer, MAX_TMP_BUF_SIZE,
-                       "%s %s",
-                       P_VALUE(req->meth), P_VALUE(req->uri));
-    if ( ret < 0 ) return ret;
-    if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 ) return -1;
+static int send_start(http_head_t *h, http_request_t *req) {
+    head_add(h, P_VALUE(req->meth), -1);
+    head_add(h, " ", 1);
+    head_add(h, P_VALUE(req->uri), -1);
     if ( req->query ) {
-        char *queryString = (char*)tmpbuffer;
-        strcpy(queryString, "?");
+        char sep = '?';
         property_map_t *query = NULL;
         for_each_node(query, req->query, property_map_t) {
-          if ( (int)strlen(P_VALUE(query->key)) +
-               (int)strlen(P_VALUE(query->value)) + 3 >
-               (int)ringbuf_capacity(cli->queue) ) break;
-            strcat(queryString, P_VALUE(query->key));
-            strcat(queryString, "=");
-            strcat(queryString, P_VALUE(query->value));
-            if ( ringbuf_capacity(buf) - sizeof(HTTP_VERS)-1 < strlen(queryString) ) break;
-            if ( ringbuf_push(buf, (uint8_t*)queryString, 0) < 0 )
-                break;
-            strcpy(queryString, "&");
+            head_add(h, &sep, 1);
+            head_add(h, P_VALUE(query->key), -1);
+            head_add(h, "=", 1);
+            head_add(h, P_VALUE(query->value), -1);
+            sep = '&';
         }
     }
-    ret = ringbuf_push(buf, (uint8_t*)HTTP_VERS, 0);
-    if ( ret < 0 ) return ret;
-    if ( (ret = client_send(cli)) < 0 ) {
-        return ret;
-    }
-    ret = snprintf((char*)tmpbuffer, MAX_TMP_BUF_SIZE, "Host: %s:%d\r\n", P_VALUE(req->host), req->port);
+    head_add(h, HTTP_VERS, sizeof(HTTP_VERS) - 1);
+    char port[8];
+    int ret = snprintf(port, sizeof(port), ":%d\r\n", req->port);
     if ( ret < 0 ) return ret;
-    if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0) return -1;
-    if ( (ret = client_send(cli)) < 0 ) {
-        return ret;
-    }
-    return 0;
+    head_add(h, "Host: ", 6);
+    head_add(h, P_VALUE(req->host), -1);
+    return head_add(h, port, ret);
 }
 
-static int send_header(http_client_t *cli, http_request_t *req, ring_buffer_t *buf) {
-    int ret;
-    ringbuf_clear(buf);
-    if ( !IS_EMPTY(req->payload.buf) && req->payload.size > 0 ) {
-        if ( req->is_chunked ) {
-            ret = client_send_direct(cli, "Transfer-Encoding: chunked\r\n", 0);
+#if !defined(NO_HTTP_DEFLATE)
+# define is_gzip_request(req) ( (req)->is_gzip )
+#else
+# define is_gzip_request(req) ( 0 )
+#endif
+
+#define has_payload(req) ( (req)->payload_producer || \
+    ( !IS_EMPTY((req)->payload.buf) && (req)->payload.size > 0 ) )
+
+static int send_header(http_head_t *h, http_request_t *req) {
+    if ( has_payload(req) ) {
+        if ( req->is_chunked || is_gzip_request(req) || req->payload_producer ) {
+            head_add_field(h, "Transfer-Encoding", "chunked");
         } else {
-            ret = snprintf((char*)tmpbuffer,
-                           ringbuf_capacity(cli->queue),
-                           "Content-Length: %lu\r\n", (long unsigned int)req->payload.size);
-            if ( ret < 0 ) return ret;
-            if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 )
+            char len[12];
+            if ( snprintf(len, sizeof(len), "%lu", (long unsigned int)req->payload.size) < 0 )
                 return -1;
-            ret = client_send(cli);
+            head_add_field(h, "Content-Length", len);
         }
-        ringbuf_clear(buf);
-        if ( ret < 0 ) return ret;
-        ret = snprintf((char*)tmpbuffer,
-                       ringbuf_capacity(cli->queue),
-                       "Content-Type: %s\r\n", P_VALUE(req->content_type.value));
-        if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 ) return -1;
-        if ( ret < 0 ) return ret;
-        if ( (ret = client_send(cli)) < 0 ) return ret;
+        if ( is_gzip_request(req) ) {
+            head_add_field(h, "Content-Encoding", "gzip");
+        }
+        head_add_field(h, "Content-Type", P_VALUE(req->content_type.value));
     }
     property_map_t *head = NULL;
     for_each_node(head, req->header, property_map_t) {
-        ringbuf_clear(buf);
-        ret = snprintf((char*)tmpbuffer,
-                           ringbuf_capacity(cli->queue),
-                           "%s: %s\r\n", P_VALUE(head->key), P_VALUE(head->value));
-    	if ( ret < 0 ) return ret;
-        if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 ) return -1;
-        if ( (ret = client_send(cli)) < 0 ) return ret;
+        head_add_field(h, P_VALUE(head->key), P_VALUE(head->value));
+    }
+    return head_add(h, "\r\n", 2);
+}
+
+static int send_chunk(void *head, uint8_t *data, int len) {
+    http_head_t *h = (http_head_t *)head;
+    char buf[12];
+    int ret = sprintf(buf, "%02X\r\n", len);
+    head_add(h, buf, ret);
+    if ( len ) head_add(h, (char*)data, len);
+    return head_add(h, "\r\n", 2);
+}
+
+// pull the payload from the producer part by part, no more than
+// CHUNK_SIZE bytes of it are in the memory at once
+static int send_produced(http_head_t *h, http_request_t *req) {
+    int len = 0;
+    int err = 0;
+#if !defined(NO_HTTP_DEFLATE)
+    http_deflate_t *d = NULL;
+    if ( req->is_gzip ) {
+        d = http_deflate_init(send_chunk, h);
+        if ( !d ) return -1;
+    }
+#endif
+    // the request may be sent again (retry on a new connection)
+    req->payload_producer(req->payload_arg, NULL, 0);
+    while ( !err && ( len = req->payload_producer(req->payload_arg, tmpbuffer, CHUNK_SIZE) ) > 0 ) {
+#if !defined(NO_HTTP_DEFLATE)
+        if ( d ) {
+            err = http_deflate_write(d, tmpbuffer, len);
+            continue;
+        }
+#endif
+        err = send_chunk(h, tmpbuffer, len);
+    }
+    if ( len < 0 ) err = len;
+#if !defined(NO_HTTP_DEFLATE)
+    if ( d ) {
+        // the compressor is released in any case
+        int ret = http_deflate_finish(d);
+        if ( !err ) err = ret;
+    }
+#endif
+    if ( err < 0 ) {
+        DBG("payload producer fail %d", err);
+        return -1;
     }
-    return client_send_direct(cli, "\r\n", 2);
+    send_chunk(h, NULL, 0);
+    return h->err;
 }
 
-static int send_payload(http_client_t *cli, http_request_t *req) {
+static int send_payload(http_head_t *h, http_request_t *req) {
+    if ( req->payload_producer ) return send_produced(h, req);
     if ( !IS_EMPTY(req->payload.buf) && req->payload.size > 0 ) {
+        uint8_t *data = (uint8_t *)P_VALUE(req->payload.buf);
+        int len = (int)req->payload.size;
+#if !defined(NO_HTTP_DEFLATE)
+        if ( req->is_gzip ) {
+            // the compressed parts go out as chunks
+            http_deflate_t *d = http_deflate_init(send_chunk, h);
+            if ( !d ) return -1;
+            http_deflate_write(d, data, len);
+            if ( http_deflate_finish(d) < 0 ) return -1;
+            send_chunk(h, NULL, 0);
+            return h->err;
+        }
+#endif
         if ( req->is_chunked ) {
-            char *data = P_VALUE(req->payload.buf);
-            int len = (int)req->payload.size;
-            int trData = 0;
-            while ( len >= 0 ) {
-                char buf[6];
+            while ( len > 0 ) {
                 int chunk = len > CHUNK_SIZE ? CHUNK_SIZE : len;
-                int ret = sprintf(buf, "%02X\r\n", chunk);
-                client_send_direct(cli, buf, ret);
-                if ( chunk ) client_send_direct(cli, data + trData, chunk);
-                trData += chunk;
+                send_chunk(h, data, chunk);
+                data += chunk;
                 len -= chunk;
-                client_send_direct(cli, "\r\n", 2);
-                if ( !chunk ) break;
             }
-            return 0;
+            send_chunk(h, NULL, 0);
         } else {
-          int ret = client_send_direct(cli, P_VALUE(req->payload.buf), req->payload.size);
-          return ret;
+            head_add(h, (char*)data, len);
         }
+        return h->err;
     }
     return -1;
 }
 
-static uint8_t *wait_line(http_client_t *cli, uint8_t *buf, size_t maxsize) {
-  int size = 0;
-  while ( size < 2 || strncmp((char*)buf + size - 2, "\r\n", 2) != 0 ) {
-      // pop from buffer by one symbol
-      if ( ringbuf_pop(cli->queue, buf + size, 1) == 0 ) {
-          size ++;
-          buf[size] = 0x0;
-          if ( (size_t)size == maxsize ) return NULL;
-      } else {
-          // empty buffer
-          if( ringbuf_capacity(cli->queue) > LINE_CHUNK ) {
-              int ret = client_recv( cli, LINE_CHUNK );
-              if ( ret < 0 ) return NULL;
-          } else {
-              return NULL;
-          }
-      }
-  }
-  return buf + size - 2;
+// a line right in the queue memory
+typedef struct {
+    char *ptr;
+    int len;    // without the line end
+    int size;   // with the line end
+} http_line_t;
+
+// make more data available in the read span of the queue
+static int wait_more(http_client_t *cli) {
+    ring_buffer_t *q = cli->queue;
+    uint16_t len = 0;
+    ringbuf_read_span(q, &len);
+    if ( len < ringbuf_size(q) ) {
+        // the data is split by the buffer border
+        ringbuf_linearize(q);
+        return 0;
+    }
+    if ( !ringbuf_capacity(q) ) {
+        DBG("too long line");
+        return -1;
+    }
+    int ret = client_recv(cli, ringbuf_capacity(q));
+    // the server has closed the connection
+    if ( ret == 0 || peer_reset(ret) ) cli->peer_closed = 1;
+    if ( ret <= 0 ) return -1;
+    return 0;
 }
 
-static int receive_response(http_client_t *cli, http_response_t *res) {
-    ringbuf_clear(cli->queue);
-    CREATE_CHUNK(tmp, RINGBUFFER_SIZE);
-    uint8_t *crlf = NULL;
-    do {
-        crlf = wait_line(cli, (uint8_t*)tmp, RINGBUFFER_SIZE);
-        if ( !crlf ) {
-            DBG("couldn't wait end of a line");
-            FREE_CHUNK(tmp);
-            return -1;
+static int wait_line(http_client_t *cli, http_line_t *line) {
+    int scanned = 0;
+    for (;;) {
+        uint16_t len = 0;
+        uint8_t *p = ringbuf_read_span(cli->queue, &len);
+        uint8_t *lf = NULL;
+        if ( (int)len > scanned ) {
+            lf = (uint8_t *)memchr(p + scanned, '\n', (size_t)(len - scanned));
         }
-        if( (crlf - (uint8_t *)tmp) < 10 ) {
-            // too short line: sizeof(HTTP/1.1)
-            *crlf = 0x0;
-            crlf = NULL;
+        if ( lf ) {
+            line->ptr = (char *)p;
+            line->size = (int)(lf - p) + 1;
+            line->len = line->size - 1;
+            if ( line->len && p[line->len - 1] == '\r' ) line->len--;
+            // the line end is not needed anymore
+            p[line->len] = 0x0;
+            return 0;
         }
-    } while ( !crlf );
-    *crlf = 0x0;
-    DBG("resp: {%s}", tmp);
-    if( sscanf((char*)tmp, "HTTP/1.1 %4d", &res->m_httpResponseCode) != 1 ) {
-        DBG("Not a correct HTTP answer : %s", tmp);
-        FREE_CHUNK(tmp);
-        return -1;
+        scanned = len;
+        if ( wait_more(cli) < 0 ) return -1;
+    }
+}
+
+static void line_consume(http_client_t *cli, http_line_t *line) {
+    ringbuf_consume(cli->queue, (uint16_t)line->size);
+}
+
+// parse the next head element right in the queue memory
+// the parsed element should be consumed by the returned size
+static int wait_head(http_client_t *cli, http_parser_t *p) {
+    for (;;) {
+        uint16_t len = 0;
+        uint8_t *ptr = ringbuf_read_span(cli->queue, &len);
+        int ret = http_parser_execute(p, (char *)ptr, len);
+        if ( ret ) return ret;
+        if ( wait_more(cli) < 0 ) return -1;
     }
+}
 
+// the spans are in the queue memory and the line end follows
+// the value so it can be terminated in place
+static char *span_str(http_span_t *s) {
+    s->ptr[s->len] = 0x0;
+    return s->ptr;
+}
+
+static int receive_response(http_client_t *cli, http_response_t *res, http_parser_t *p) {
+    http_parser_init(p);
+    int size = wait_head(cli, p);
+    if ( size < 0 ) {
+        DBG("Not a correct HTTP answer");
+        return -1;
+    }
+    ringbuf_consume(cli->queue, (uint16_t)size);
+    res->m_httpResponseCode = p->status;
     DBG("Response code %d", res->m_httpResponseCode);
     cli->response_code = res->m_httpResponseCode;
-    FREE_CHUNK(tmp);
     return 0;
 }
 
-static int receive_headers(http_client_t *cli, http_response_t *res) {
-    uint8_t *crlf = NULL;
-    CREATE_CHUNK(tmp, RINGBUFFER_SIZE);
-    CREATE_CHUNK(key, CHUNK_SIZE>>2);
-    CREATE_CHUNK(value, CHUNK_SIZE);
-    int ret = 0;
-    while( ( crlf = wait_line(cli, (uint8_t*)tmp, RINGBUFFER_SIZE) ) ) {
-        if ( crlf == (uint8_t*)tmp ) {
+static int receive_headers(http_client_t *cli, http_response_t *res, http_parser_t *p) {
+    // HTTP/1.0 closes the connection by default
+    int keep_alive = ( p->minor > 0 );
+    int has_length = 0;
+    int size;
+    while ( ( size = wait_head(cli, p) ) > 0 ) {
+        if ( p->event == http_parse_done ) {
+            ringbuf_consume(cli->queue, (uint16_t)size);
             HTTP_DBG("Headers read done");
-            ret = 0;
-            break;
+            // without framing the body lasts until the server closes
+            // the connection, so it can't be used for the next request
+            if ( !has_length && !res->is_chunked &&
+                 res->m_httpResponseCode != 204 &&
+                 res->m_httpResponseCode != 304 ) {
+                keep_alive = 0;
+            }
+            if ( !keep_alive ) cli->flags._close = 1;
+            return 0;
         }
-
-        int n = sscanf((char*)tmp, "%256[^:]: %256[^\r\n]", key, value);
-        if ( n == 2 ) {
-            HTTP_DBG("Read header : %s: %s", key, value);
-            if( !strcmp(key, "Content-Length") ) {
-                sscanf(value, "%8d", (int *)&res->recvContentLength);
-            } else if( !strcmp(key, "Transfer-Encoding") ) {
-                if( !strcmp(value, "Chunked") || !strcmp(value, "chunked") )
-                    res->is_chunked = 1;
-            } else if( !strcmp(key, "Content-Type") ) {
-                http_response_set_content_type(res, property(value, is_stack));
-            } else {
+        switch ( p->id ) {
+        case http_hdr_content_length:
+            if ( http_span_to_uint(&p->value, &res->recvContentLength) == 0 )
+                has_length = 1;
+            break;
+        case http_hdr_transfer_encoding:
+            if ( http_span_has_token(&p->value, "chunked") ) res->is_chunked = 1;
+            break;
+        case http_hdr_content_type:
+            http_response_set_content_type(res, property(span_str(&p->value), is_stack));
+            break;
+        case http_hdr_content_encoding:
+            res->content_encoding = http_encoding_parse(span_str(&p->value));
+            break;
+        case http_hdr_connection:
+            if ( http_span_has_token(&p->value, "close") ) keep_alive = 0;
+            else if ( http_span_has_token(&p->value, "keep-alive") ) keep_alive = 1;
+            break;
+        default:
 #if defined(HTTP_PARSE_HEADER)
+            if ( p->name.len ) {
+                span_str(&p->value);
                 http_response_add_header(res,
-                                         p_stack(key),
-                                         p_stack(value));
-#endif
+                                         p_stack(span_str(&p->name)),
+                                         p_stack(p->value.ptr));
             }
-        } else {
-            DBG("Could not parse header");
-            ret = -1;
-            goto recv_header_end;
+#endif
+            break;
         }
+        ringbuf_consume(cli->queue, (uint16_t)size);
     }
-recv_header_end:
-    FREE_CHUNK(tmp);
-    FREE_CHUNK(key);
-    FREE_CHUNK(value);
-    return ret;
+    DBG("Could not parse header");
+    return -1;
 }
 
 static int get_chunked_payload_size(http_client_t *cli, http_response_t *res) {
     // find the \r\n in the payload
     // next string shoud start at HEX chunk size
     SSP_PARAMETER_NOT_USED(res);
-    CREATE_CHUNK(tmp, RINGBUFFER_SIZE);
-    int chunk_len = 0;
-    uint8_t *crlf = wait_line(cli, (uint8_t*)tmp, RINGBUFFER_SIZE);
-    if ( !crlf ) return -1; // no \r\n - wrong string
-    int ret = sscanf((char*)tmp, "%8x\r\n", (unsigned int*)&chunk_len);
+    http_line_t line;
+    unsigned int chunk_len = 0;
+    if ( wait_line(cli, &line) < 0 ) return -1; // no \r\n - wrong string
+    line_consume(cli, &line);
+    int ret = sscanf(line.ptr, "%8x", &chunk_len);
     if ( ret != 1 ) {
         // couldn't read a chunk size - fail
-        chunk_len = 0;
-        FREE_CHUNK(tmp);
         return -1;
     }
     HTTP_DBG("detect chunk %d", chunk_len);
-    FREE_CHUNK(tmp);
-    return chunk_len;
+    return (int)chunk_len;
 }
 
-static int receive_payload(http_client_t *cli, http_response_t *res) {
-    int chunk_len = 0;
-    int no_data_error = 0;
-    do {
-        if ( res->is_chunked ) {
-            chunk_len = get_chunked_payload_size(cli, res);
-        } else {
-            chunk_len = res->recvContentLength;
-            DBG("Con-Len %d", res->recvContentLength);
+// the message body without the transfer framing
+typedef struct {
+    http_client_t *cli;
+    http_response_t *res;
+    int left;
+    int started;
+    int done;
+    int no_data_error;
+} http_body_t;
+
+// get the size of the current part of the body: 0 - end of the body
+static int body_next(http_body_t *body) {
+    http_client_t *cli = body->cli;
+    if ( body->done ) return 0;
+    if ( body->left ) return body->left;
+    if ( !body->res->is_chunked ) {
+        if ( !body->started ) {
+            body->left = (int)body->res->recvContentLength;
+            DBG("Con-Len %d", body->left);
         }
-        if ( !chunk_len || chunk_len < 0 ) break;
-        while ( chunk_len ) {
-            uint32_t need_to_read = (chunk_len < CHUNK_SIZE-10) ? chunk_len : CHUNK_SIZE-10;
-            HTTP_DBG("need to read %d", need_to_read);
-            while ( (int)ringbuf_size(cli->queue) < (int)need_to_read ) {
-                HTTP_DBG("get chunk add %d", need_to_read-ringbuf_size(cli->queue));
-                int ret = client_recv(cli, need_to_read-ringbuf_size(cli->queue));
-                if ( ret < 0 ) {
-                    // ret < 0 - error
-                    DBG("No data");
-                    if ( no_data_error ++ > 2) return -1;
-                }
+    } else {
+        if ( body->started ) {
+            // the end of the previous chunk
+            http_line_t line;
+            if ( wait_line(cli, &line) < 0 ) {
+                DBG("No new line");
+            } else {
+                line_consume(cli, &line);
             }
-            HTTP_DBG("add payload{%d:s}", need_to_read);//, buf);
-            if ( ringbuf_pop(cli->queue, tmpbuffer, need_to_read) < 0 ) return -1;
-            if ( http_response_add_payload(res, p_stack(tmpbuffer), need_to_read) < 0 ) {
-                ringbuf_clear(cli->queue);
-                DBG("Payload is failed");
-                return -1;
+        }
+        body->left = get_chunked_payload_size(cli, body->res);
+        if ( body->left < 0 ) {
+            // treat as the end of the body as before
+            // but the stream is out of sync now
+            cli->flags._close = 1;
+            body->left = 0;
+        } else if ( !body->left ) {
+            // skip the trailer up to the empty line
+            // so the next response starts right after it
+            http_line_t line;
+            while ( wait_line(cli, &line) == 0 ) {
+                line_consume(cli, &line);
+                if ( !line.len ) break;
             }
-            chunk_len -= need_to_read;
-            HTTP_DBG("%d %d", chunk_len, need_to_read);
         }
-        if ( !res->is_chunked ) break;
-        else {
-          uint8_t *crlf = wait_line(cli, tmpbuffer, CHUNK_SIZE);
-          if ( !crlf ) {
-              DBG("No new line");
-          }
+    }
+    body->started = 1;
+    if ( !body->left ) body->done = 1;
+    return body->left;
+}
+
+// the received part of the body right in the queue memory
+static int body_span(http_body_t *body, uint8_t **data) {
+    http_client_t *cli = body->cli;
+    int ret = body_next(body);
+    if ( ret <= 0 ) return ret;
+    ring_buffer_t *q = cli->queue;
+    // wait for as much data as fit in the queue without wrapping
+    int want = body->left;
+    if ( !ringbuf_size(q) ) q->shift = 0;
+    if ( want > q->total - q->shift ) want = q->total - q->shift;
+    if ( want > q->total - 1 ) want = q->total - 1;
+    uint16_t len = 0;
+    *data = ringbuf_read_span(q, &len);
+    while ( (int)len < want ) {
+        HTTP_DBG("get chunk add %d", want - len);
+        ret = client_recv(cli, (uint16_t)(want - len));
+        if ( ret <= 0 ) {
+            // ret < 0 - error
+            DBG("No data");
+            if ( body->no_data_error ++ > 2) return -1;
         }
-    } while(1);
+        *data = ringbuf_read_span(q, &len);
+    }
+    return want;
+}
+
+static void body_consume(http_body_t *body, int len) {
+    ringbuf_consume(body->cli->queue, (uint16_t)len);
+    body->left -= len;
+}
 
+#if !defined(NO_HTTP_INFLATE)
+static int body_read(void *b, uint8_t *buf, int len) {
+    http_body_t *body = (http_body_t *)b;
+    uint8_t *data = NULL;
+    int ret = body_span(body, &data);
+    if ( ret <= 0 ) return ret;
+    if ( len > ret ) len = ret;
+    memcpy(buf, data, (size_t)len);
+    body_consume(body, len);
+    return len;
+}
+#endif
+
+static int body_add_payload(void *r, uint8_t *buf, int len) {
+    http_response_t *res = (http_response_t *)r;
+    HTTP_DBG("add payload{%d:s}", len);
+    return http_response_add_payload(res, p_stack(buf), (uint32_t)len);
+}
+
+static int receive_payload(http_client_t *cli, http_response_t *res) {
+    int ret;
+    http_body_t body;
+    memset(&body, 0x0, sizeof(body));
+    body.cli = cli;
+    body.res = res;
+#if !defined(NO_HTTP_INFLATE)
+    if ( res->content_encoding != http_identity ) {
+        ret = http_inflate((http_encoding_t)res->content_encoding,
+                           body_read, &body,
+                           body_add_payload, res);
+        if ( ret < 0 ) {
+            ringbuf_clear(cli->queue);
+            DBG("Payload is failed");
+            return -1;
+        }
+        // skip the rest of the body (zlib trailer)
+        uint8_t *rest = NULL;
+        while ( ( ret = body_span(&body, &rest) ) > 0 )
+            body_consume(&body, ret);
+        return ret;
+    }
+#endif
+    uint8_t *data = NULL;
+    while ( ( ret = body_span(&body, &data) ) > 0 ) {
+        if ( body_add_payload(res, data, ret) < 0 ) {
+            ringbuf_clear(cli->queue);
+            DBG("Payload is failed");
+            return -1;
+        }
+        body_consume(&body, ret);
+    }
     HTTP_DBG("body{%s}", P_VALUE(res->payload.buf));
+    return ret;
+}
+
+static int client_connect(http_client_t *cli, http_request_t *req) {
+    DBG("new TCP connection");
+    ringbuf_clear(cli->queue);
+    int ret = soc_connect_host(P_VALUE(req->host), req->port, cli->timeout);
+    if ( ret < 0 ) {
+        DBG("connect fail");
+        return -1;
+    }
+    cli->sock = ret;
+
+    // set timeout
+    struct timeval tv;
+    tv.tv_sec =     (time_t)        ( cli->timeout / 1000 );
+    tv.tv_usec =    (suseconds_t)   (( cli->timeout % 1000 ) * 1000);
+    setsockopt(cli->sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(struct timeval));
+
+    HTTP_DBG("connect done");
+    cli->is_cipher = req->is_cipher;
+    if ( req->is_cipher ) {
+        if ( ssl_connect(cli->sock) < 0 ) {
+            HTTP_DBG("SSL connect fail");
+            http_client_close(cli);
+            return -1;
+        }
+        cli->_r_func = ssl_read;
+        cli->_w_func = ssl_write;
+    } else {
+        cli->_r_func = simple_read;
+        cli->_w_func = simple_write;
+    }
+    property_n_copy(&cli->host, P_VALUE(req->host), (int)strlen(P_VALUE(req->host)));
+    cli->port = req->port;
     return 0;
 }
 
-int http_client_do(http_client_t *cli, http_request_t *req, http_response_t *res) {
-    int ret;
-    http_response_init(res, &req->_response_payload_meth);
-    if ( cli->sock < 0 ) {
-        DBG("new TCP connection");
-        ret = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if ( ret < 0 ) return ret;
-        ringbuf_clear(cli->queue);
-        cli->sock = ret;
-        // resolve the host
-    	struct sockaddr_in serv;
-    	struct hostent *serv_resolve;
-        serv_resolve = gethostbyname(P_VALUE(req->host));
-    	if (serv_resolve == NULL) {
-    		DBG("ERROR, no such host");
-    		return -1;
-    	}
-    	memset(&serv, 0, sizeof(serv));
-    	serv.sin_family = PF_INET;
-    	bcopy((char *)serv_resolve->h_addr,
-    			(char *)&serv.sin_addr.s_addr,
-				(uint32_t)serv_resolve->h_length);
-    	serv.sin_port = htons(req->port);
-
-        // set timeout
-    	struct timeval tv;
-    	tv.tv_sec =     (time_t)        ( cli->timeout / 1000 );
-    	tv.tv_usec =    (suseconds_t)   (( cli->timeout % 1000 ) * 1000);
-    	setsockopt(cli->sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(struct timeval));
-
-    	ret = connect(cli->sock, (struct sockaddr*)&serv, sizeof(serv));
-    	if ( ret < 0 ) {
-    		DBG("connect fail");
-    		soc_close(cli->sock);
-    		cli->sock = -1;
-    		return -1;
-    	}
-    	HTTP_DBG("connect done");
-    	if ( req->is_cipher ) {
-    		if ( ssl_connect(cli->sock) < 0 ) {
-    			HTTP_DBG("SSL connect fail");
-    			ssl_close(cli->sock);
-    			soc_close(cli->sock);
-    			cli->sock = -1;
-    			return -1;
-    		}
-    		cli->_r_func = ssl_read;
-    		cli->_w_func = ssl_write;
-    	} else {
-    		cli->_r_func = simple_read;
-    		cli->_w_func = simple_write;
-    	}
-    }
-
-    if ( send_start(cli, req, cli->queue) < 0 ) {
+static int send_request(http_client_t *cli, http_request_t *req) {
+    http_head_t head;
+    head_init(&head, cli);
+    ringbuf_clear(cli->queue);
+
+    if ( send_start(&head, req) < 0 ) {
         DBG("send start fail");
         return -1;
     }
 
-    if ( send_header(cli, req, cli->queue) < 0 ) {
+    if ( send_header(&head, req) < 0 ) {
         DBG("send header fail");
         return -1;
     }
 
-    if ( !IS_EMPTY(req->payload.buf) ) {
-        if ( send_payload(cli, req) < 0 ) {
+    if ( has_payload(req) ) {
+        if ( send_payload(&head, req) < 0 ) {
             DBG("send payload fail");
             return -1;
         }
     }
 
-    HTTP_DBG("Receiving response");
-
-    ringbuf_clear(cli->queue);
-
-    ret = receive_response(cli, res);
-    if ( ret < 0 ) {
-        DBG("Receiving error (%d)", ret);
+    if ( head_flush(&head) < 0 ) {
+        DBG("send request fail");
         return -1;
     }
+    return 0;
+}
 
+// the rest of the response after the status line
+static int receive_message(http_client_t *cli, http_response_t *res, http_parser_t *p) {
+    int ret;
     HTTP_DBG("Reading headers");
     res->header = NULL;
     memset(&res->content_type, 0x0, sizeof(property_map_t));
     memset(&res->payload, 0x0, sizeof(http_payload_t));
     res->is_chunked = 0;
     res->processed_payload_chunk = 0;
+    res->content_encoding = http_identity;
 
     //Now let's get a headers
-    ret = receive_headers(cli, res);
+    ret = receive_headers(cli, res, p);
     if ( ret < 0 ) {
         DBG("Receiving headers error (%d)", ret);
         return -1;
@@ -530,3 +758,75 @@ int http_client_do(http_client_t *cli, http_request_t *req, http_response_t *res
     }
     return 0;
 }
+
+int http_client_do(http_client_t *cli, http_request_t *req, http_response_t *res) {
+    int ret;
+    http_parser_t parser;
+    http_response_init(res, &req->_response_payload_meth);
+    int reused = ( cli->sock >= 0 );
+    if ( !reused ) {
+        if ( client_connect(cli, req) < 0 ) return -1;
+    }
+
+    cli->peer_closed = 0;
+    int sent = send_request(cli, req);
+    ret = sent;
+    if ( ret == 0 ) {
+        HTTP_DBG("Receiving response");
+        ringbuf_clear(cli->queue);
+        ret = receive_response(cli, res, &parser);
+    }
+    // a kept alive connection was closed by the server before
+    // the request or before any byte of the answer: the request
+    // isn't processed and it's safe to repeat it on a new one
+    // (a timeout or a partial answer is not repeated)
+    if ( ret < 0 && reused &&
+         ( sent < 0 || ( cli->peer_closed && !ringbuf_size(cli->queue) ) ) ) {
+        DBG("reconnect");
+        http_client_close(cli);
+        _payload_meth_t meth = req->_response_payload_meth;
+        http_response_free(res);
+        http_response_init(res, &meth);
+        if ( client_connect(cli, req) < 0 ) return -1;
+        ret = send_request(cli, req);
+        if ( ret == 0 ) {
+            ringbuf_clear(cli->queue);
+            ret = receive_response(cli, res, &parser);
+        }
+    }
+    if ( ret < 0 ) {
+        DBG("Receiving error (%d)", ret);
+        goto client_do_error;
+    }
+
+    if ( receive_message(cli, res, &parser) < 0 ) goto client_do_error;
+    return 0;
+
+client_do_error:
+    // the stream state is unknown, don't reuse it
+    http_client_close(cli);
+    return -1;
+}
+
+int http_client_send(http_client_t *cli, http_request_t *req) {
+    if ( cli->sock < 0 && client_connect(cli, req) < 0 ) return -1;
+    cli->peer_closed = 0;
+    if ( send_request(cli, req) < 0 ) {
+        http_client_close(cli);
+        return -1;
+    }
+    return 0;
+}
+
+int http_client_receive(http_client_t *cli, http_request_t *req, http_response_t *res) {
+    http_parser_t parser;
+    _payload_meth_t meth = req->_response_payload_meth;
+    http_response_init(res, &meth);
+    if ( receive_response(cli, res, &parser) < 0 ||
+         receive_message(cli, res, &parser) < 0 ) {
+        DBG("Receiving error");
+        http_client_close(cli);
+        return -1;
+    }
+    return 0;
+}
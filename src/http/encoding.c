@@ -0,0 +1,597 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#define MODULE_NAME "HTTP_Encoding"
+
+#include "http/encoding.h"
+#include <sys/mem.h>
+#include <debug.h>
+
+#if HTTP_INFLATE_WINDOW & (HTTP_INFLATE_WINDOW - 1)
+# error "HTTP_INFLATE_WINDOW should be a power of two"
+#endif
+
+#if !defined(HTTP_INFLATE_INPUT)
+# define HTTP_INFLATE_INPUT 128
+#endif
+
+#define MAXBITS   15
+#define MAXLCODES 286
+#define MAXDCODES 30
+#define FIXLCODES 288
+
+// length and distance codes (RFC 1951)
+static const short lbase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const short lext[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const short dbase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+  8193, 12289, 16385, 24577 };
+static const short dext[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static const uint32_t crc_nibble[16] = {
+  0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+  0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+  0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+  0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+uint32_t http_crc32(uint32_t crc, const uint8_t *buf, int len) {
+  crc = ~crc;
+  while ( len-- > 0 ) {
+    crc ^= *buf++;
+    crc = crc_nibble[crc & 0x0f] ^ (crc >> 4);
+    crc = crc_nibble[crc & 0x0f] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+http_encoding_t http_encoding_parse(const char *name) {
+  if ( !strcasecmp(name, "gzip") || !strcasecmp(name, "x-gzip") ) return http_gzip;
+  if ( !strcasecmp(name, "deflate") ) return http_deflate;
+  return http_identity;
+}
+
+typedef struct {
+  short *count;
+  short *symbol;
+} huffman_t;
+
+typedef struct {
+  http_enc_read_f   read;
+  void             *rarg;
+  http_enc_write_f  write;
+  void             *warg;
+  uint8_t  in[HTTP_INFLATE_INPUT];
+  int      in_pos;
+  int      in_len;
+  uint32_t bitbuf;
+  int      bitcnt;
+  uint8_t *window;
+  uint32_t wpos;
+  uint32_t wflushed;
+  uint32_t total;
+  uint32_t crc;
+  int      err;
+  short    lencnt[MAXBITS+1];
+  short    lensym[FIXLCODES];
+  short    distcnt[MAXBITS+1];
+  short    distsym[MAXDCODES];
+  short    lengths[MAXLCODES+MAXDCODES];
+} inflate_t;
+
+static int out_flush(inflate_t *s) {
+  int size = (int)(s->wpos - s->wflushed);
+  if ( size > 0 ) {
+    s->crc = http_crc32(s->crc, s->window + s->wflushed, size);
+    if ( s->write(s->warg, s->window + s->wflushed, size) < 0 ) {
+      s->err = -1;
+      return -1;
+    }
+  }
+  if ( s->wpos == HTTP_INFLATE_WINDOW ) s->wpos = 0;
+  s->wflushed = s->wpos;
+  return 0;
+}
+
+static void out_byte(inflate_t *s, uint8_t b) {
+  s->window[s->wpos++] = b;
+  s->total++;
+  if ( s->wpos == HTTP_INFLATE_WINDOW ) out_flush(s);
+}
+
+static int in_byte(inflate_t *s) {
+  if ( s->in_pos == s->in_len ) {
+    if ( s->err ) return -1;
+    int ret = s->read(s->rarg, s->in, sizeof(s->in));
+    if ( ret <= 0 ) {
+      DBG("inflate: unexpected end of data");
+      s->err = -1;
+      return -1;
+    }
+    s->in_len = ret;
+    s->in_pos = 0;
+  }
+  return s->in[s->in_pos++];
+}
+
+static int bits(inflate_t *s, int need) {
+  uint32_t val = s->bitbuf;
+  while ( s->bitcnt < need ) {
+    int b = in_byte(s);
+    if ( b < 0 ) return 0;
+    val |= (uint32_t)b << s->bitcnt;
+    s->bitcnt += 8;
+  }
+  s->bitbuf = val >> need;
+  s->bitcnt -= need;
+  return (int)(val & ((1UL << need) - 1));
+}
+
+// canonical huffman code: walk the code lengths bit by bit
+static int decode(inflate_t *s, const huffman_t *h) {
+  int code = 0, first = 0, index = 0;
+  int len = 1;
+  int count;
+  uint32_t bitbuf = s->bitbuf;
+  int left = s->bitcnt;
+  const short *next = h->count + 1;
+  for (;;) {
+    while ( left-- ) {
+      code |= bitbuf & 1;
+      bitbuf >>= 1;
+      count = *next++;
+      if ( code - count < first ) {
+        s->bitbuf = bitbuf;
+        s->bitcnt = (s->bitcnt - len) & 7;
+        return h->symbol[index + (code - first)];
+      }
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
+      len++;
+    }
+    left = (MAXBITS + 1) - len;
+    if ( left == 0 ) break;
+    int b = in_byte(s);
+    if ( b < 0 ) return -1;
+    bitbuf = (uint32_t)b;
+    if ( left > 8 ) left = 8;
+  }
+  return -10;
+}
+
+static int construct(huffman_t *h, const short *length, int n) {
+  int symbol, len, left;
+  short offs[MAXBITS+1];
+  for ( len = 0; len <= MAXBITS; len++ ) h->count[len] = 0;
+  for ( symbol = 0; symbol < n; symbol++ ) h->count[length[symbol]]++;
+  if ( h->count[0] == n ) return 0;
+  left = 1;
+  for ( len = 1; len <= MAXBITS; len++ ) {
+    left <<= 1;
+    left -= h->count[len];
+    if ( left < 0 ) return left;
+  }
+  offs[1] = 0;
+  for ( len = 1; len < MAXBITS; len++ ) offs[len + 1] = offs[len] + h->count[len];
+  for ( symbol = 0; symbol < n; symbol++ )
+    if ( length[symbol] != 0 ) h->symbol[offs[length[symbol]]++] = (short)symbol;
+  return left;
+}
+
+static int read_le16(inflate_t *s) {
+  int lo = in_byte(s);
+  int hi = in_byte(s);
+  if ( lo < 0 || hi < 0 ) return 0;
+  return lo | hi << 8;
+}
+
+static int stored(inflate_t *s) {
+  s->bitbuf = 0;
+  s->bitcnt = 0;
+  int len = read_le16(s);
+  int nlen = read_le16(s);
+  if ( s->err ) return s->err;
+  if ( len != (~nlen & 0xffff) ) return -2;
+  while ( len-- ) {
+    int b = in_byte(s);
+    if ( b < 0 ) return -1;
+    out_byte(s, (uint8_t)b);
+  }
+  return s->err;
+}
+
+static int codes(inflate_t *s, const huffman_t *lencode, const huffman_t *distcode) {
+  int symbol;
+  do {
+    symbol = decode(s, lencode);
+    if ( symbol < 0 || s->err ) return symbol < 0 ? symbol : s->err;
+    if ( symbol < 256 ) {
+      out_byte(s, (uint8_t)symbol);
+    } else if ( symbol > 256 ) {
+      symbol -= 257;
+      if ( symbol >= 29 ) return -10;
+      int len = lbase[symbol] + bits(s, lext[symbol]);
+      symbol = decode(s, distcode);
+      if ( symbol < 0 ) return symbol;
+      uint32_t dist = (uint32_t)(dbase[symbol] + bits(s, dext[symbol]));
+      if ( s->err ) return s->err;
+      if ( dist > HTTP_INFLATE_WINDOW || dist > s->total ) {
+        DBG("inflate: distance too far back %u", dist);
+        return -11;
+      }
+      while ( len-- ) {
+        out_byte(s, s->window[(s->wpos - dist) & (HTTP_INFLATE_WINDOW - 1)]);
+      }
+    }
+  } while ( symbol != 256 );
+  return s->err;
+}
+
+static int fixed(inflate_t *s) {
+  huffman_t lencode = { s->lencnt, s->lensym };
+  huffman_t distcode = { s->distcnt, s->distsym };
+  int symbol;
+  for ( symbol = 0; symbol < 144; symbol++ ) s->lengths[symbol] = 8;
+  for ( ; symbol < 256; symbol++ ) s->lengths[symbol] = 9;
+  for ( ; symbol < 280; symbol++ ) s->lengths[symbol] = 7;
+  for ( ; symbol < FIXLCODES; symbol++ ) s->lengths[symbol] = 8;
+  construct(&lencode, s->lengths, FIXLCODES);
+  for ( symbol = 0; symbol < MAXDCODES; symbol++ ) s->lengths[symbol] = 5;
+  construct(&distcode, s->lengths, MAXDCODES);
+  return codes(s, &lencode, &distcode);
+}
+
+static int dynamic(inflate_t *s) {
+  static const short order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+  huffman_t lencode = { s->lencnt, s->lensym };
+  huffman_t distcode = { s->distcnt, s->distsym };
+  short *lengths = s->lengths;
+  int nlen = bits(s, 5) + 257;
+  int ndist = bits(s, 5) + 1;
+  int ncode = bits(s, 4) + 4;
+  int index, err;
+  if ( s->err ) return s->err;
+  if ( nlen > MAXLCODES || ndist > MAXDCODES ) return -3;
+  for ( index = 0; index < ncode; index++ ) lengths[order[index]] = (short)bits(s, 3);
+  for ( ; index < 19; index++ ) lengths[order[index]] = 0;
+  if ( construct(&lencode, lengths, 19) != 0 ) return -4;
+  index = 0;
+  while ( index < nlen + ndist ) {
+    int symbol = decode(s, &lencode);
+    if ( symbol < 0 ) return symbol;
+    if ( s->err ) return s->err;
+    if ( symbol < 16 ) {
+      lengths[index++] = (short)symbol;
+    } else {
+      short len = 0;
+      if ( symbol == 16 ) {
+        if ( index == 0 ) return -5;
+        len = lengths[index - 1];
+        symbol = 3 + bits(s, 2);
+      } else if ( symbol == 17 ) {
+        symbol = 3 + bits(s, 3);
+      } else {
+        symbol = 11 + bits(s, 7);
+      }
+      if ( index + symbol > nlen + ndist ) return -6;
+      while ( symbol-- ) lengths[index++] = len;
+    }
+  }
+  if ( lengths[256] == 0 ) return -9;
+  err = construct(&lencode, lengths, nlen);
+  if ( err && ( err < 0 || nlen != lencode.count[0] + lencode.count[1] ) ) return -7;
+  err = construct(&distcode, lengths + nlen, ndist);
+  if ( err && ( err < 0 || ndist != distcode.count[0] + distcode.count[1] ) ) return -8;
+  return codes(s, &lencode, &distcode);
+}
+
+static int gzip_header(inflate_t *s) {
+  int id1 = in_byte(s);
+  int id2 = in_byte(s);
+  int cm = in_byte(s);
+  int flg = in_byte(s);
+  int i;
+  if ( s->err ) return s->err;
+  if ( id1 != 0x1f || id2 != 0x8b || cm != 8 ) return -20;
+  // mtime, xfl, os
+  for ( i = 0; i < 6; i++ ) in_byte(s);
+  if ( flg & 0x04 ) {
+    int xlen = read_le16(s);
+    while ( xlen-- > 0 && !s->err ) in_byte(s);
+  }
+  if ( flg & 0x08 ) while ( in_byte(s) > 0 );
+  if ( flg & 0x10 ) while ( in_byte(s) > 0 );
+  if ( flg & 0x02 ) {
+    in_byte(s);
+    in_byte(s);
+  }
+  return s->err;
+}
+
+static int zlib_header(inflate_t *s) {
+  int cmf = in_byte(s);
+  int flg = in_byte(s);
+  if ( s->err ) return s->err;
+  if ( (cmf & 0x0f) == 8 && !((cmf << 8 | flg) % 31) ) {
+    if ( flg & 0x20 ) return -21; // preset dictionary
+    return 0;
+  }
+  // raw deflate stream without the zlib wrapper: put the bytes back
+  if ( s->in_pos >= 2 ) {
+    s->in_pos -= 2;
+  } else {
+    s->bitbuf = (uint32_t)cmf;
+    s->bitcnt = 8;
+    s->in_pos--;
+  }
+  return 0;
+}
+
+static uint32_t read_le32(inflate_t *s) {
+  uint32_t lo = (uint32_t)read_le16(s);
+  uint32_t hi = (uint32_t)read_le16(s);
+  return lo | hi << 16;
+}
+
+int http_inflate(http_encoding_t enc,
+                 http_enc_read_f in, void *in_arg,
+                 http_enc_write_f out, void *out_arg) {
+  int ret;
+  int last;
+  inflate_t *s = (inflate_t *)malloc(sizeof(inflate_t));
+  if ( !s ) return -1;
+  memset(s, 0x0, sizeof(inflate_t));
+  s->window = (uint8_t *)malloc(HTTP_INFLATE_WINDOW);
+  if ( !s->window ) {
+    free(s);
+    return -1;
+  }
+  s->read = in;
+  s->rarg = in_arg;
+  s->write = out;
+  s->warg = out_arg;
+  if ( enc == http_gzip ) ret = gzip_header(s);
+  else ret = zlib_header(s);
+  if ( ret < 0 ) goto inflate_end;
+  do {
+    last = bits(s, 1);
+    int type = bits(s, 2);
+    if ( s->err ) {
+      ret = s->err;
+      break;
+    }
+    switch ( type ) {
+      case 0: ret = stored(s); break;
+      case 1: ret = fixed(s); break;
+      case 2: ret = dynamic(s); break;
+      default: ret = -1;
+    }
+    if ( ret < 0 ) break;
+  } while ( !last );
+  if ( ret < 0 ) goto inflate_end;
+  ret = out_flush(s);
+  if ( ret < 0 ) goto inflate_end;
+  if ( enc == http_gzip ) {
+    // the rest of the last byte is padding
+    s->bitbuf = 0;
+    s->bitcnt = 0;
+    uint32_t crc = read_le32(s);
+    uint32_t size = read_le32(s);
+    if ( s->err || crc != s->crc || size != s->total ) {
+      DBG("inflate: wrong gzip trailer");
+      ret = -1;
+    }
+  }
+inflate_end:
+  if ( ret < 0 ) {
+    DBG("inflate fail %d", ret);
+  } else {
+    ret = (int)s->total;
+  }
+  free(s->window);
+  free(s);
+  return ret;
+}
+
+#if !defined(NO_HTTP_DEFLATE)
+
+#define DEFLATE_WSIZE     HTTP_DEFLATE_WINDOW
+#define DEFLATE_HASH_SIZE (1 << HTTP_DEFLATE_HASH_BITS)
+#define MIN_MATCH         3
+#define MAX_MATCH         258
+#define MIN_LOOKAHEAD     (MAX_MATCH + MIN_MATCH)
+
+#if DEFLATE_WSIZE < MIN_LOOKAHEAD || DEFLATE_WSIZE > 0x7fff
+# error "HTTP_DEFLATE_WINDOW is out of range"
+#endif
+
+struct http_deflate {
+  http_enc_write_f write;
+  void            *warg;
+  uint8_t  window[2 * DEFLATE_WSIZE];
+  // position + 1 of the last string with this hash, 0 - none
+  uint16_t head[DEFLATE_HASH_SIZE];
+  int      wlen;
+  int      pos;
+  uint32_t bitbuf;
+  int      bitcnt;
+  uint8_t  out[HTTP_DEFLATE_OUTPUT];
+  int      outlen;
+  uint32_t crc;
+  uint32_t total;
+  int      err;
+};
+
+static void def_flush(http_deflate_t *d) {
+  if ( d->outlen && !d->err ) {
+    if ( d->write(d->warg, d->out, d->outlen) < 0 ) d->err = -1;
+  }
+  d->outlen = 0;
+}
+
+static void def_byte(http_deflate_t *d, uint8_t b) {
+  d->out[d->outlen++] = b;
+  if ( d->outlen == (int)sizeof(d->out) ) def_flush(d);
+}
+
+static void def_bits(http_deflate_t *d, uint32_t val, int n) {
+  d->bitbuf |= val << d->bitcnt;
+  d->bitcnt += n;
+  while ( d->bitcnt >= 8 ) {
+    def_byte(d, (uint8_t)d->bitbuf);
+    d->bitbuf >>= 8;
+    d->bitcnt -= 8;
+  }
+}
+
+// huffman codes are stored starting from the most significant bit
+static void def_code(http_deflate_t *d, uint32_t code, int n) {
+  uint32_t rev = 0;
+  int i;
+  for ( i = 0; i < n; i++ ) {
+    rev = (rev << 1) | (code & 1);
+    code >>= 1;
+  }
+  def_bits(d, rev, n);
+}
+
+// fixed huffman literal/length code
+static void def_symbol(http_deflate_t *d, int sym) {
+  if ( sym < 144 )      def_code(d, 0x30 + sym, 8);
+  else if ( sym < 256 ) def_code(d, 0x190 + sym - 144, 9);
+  else if ( sym < 280 ) def_code(d, sym - 256, 7);
+  else                  def_code(d, 0xc0 + sym - 280, 8);
+}
+
+static void def_match(http_deflate_t *d, int len, int dist) {
+  int i = 28;
+  while ( lbase[i] > len ) i--;
+  def_symbol(d, 257 + i);
+  if ( lext[i] ) def_bits(d, (uint32_t)(len - lbase[i]), lext[i]);
+  i = 29;
+  while ( dbase[i] > dist ) i--;
+  def_code(d, (uint32_t)i, 5);
+  if ( dext[i] ) def_bits(d, (uint32_t)(dist - dbase[i]), dext[i]);
+}
+
+static uint32_t def_hash(const uint8_t *p) {
+  uint32_t v = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+  return (v * 2654435761U) >> (32 - HTTP_DEFLATE_HASH_BITS);
+}
+
+static void def_insert(http_deflate_t *d, int pos) {
+  d->head[def_hash(d->window + pos)] = (uint16_t)(pos + 1);
+}
+
+static void def_compress(http_deflate_t *d, int flush) {
+  uint8_t *w = d->window;
+  while ( d->pos < d->wlen ) {
+    int avail = d->wlen - d->pos;
+    if ( !flush && avail < MIN_LOOKAHEAD ) break;
+    int len = 0;
+    int dist = 0;
+    if ( avail >= MIN_MATCH ) {
+      uint32_t h = def_hash(w + d->pos);
+      int cand = (int)d->head[h] - 1;
+      d->head[h] = (uint16_t)(d->pos + 1);
+      if ( cand >= 0 && d->pos - cand <= DEFLATE_WSIZE ) {
+        int max = avail < MAX_MATCH ? avail : MAX_MATCH;
+        while ( len < max && w[cand + len] == w[d->pos + len] ) len++;
+        dist = d->pos - cand;
+      }
+    }
+    if ( len >= MIN_MATCH ) {
+      def_match(d, len, dist);
+      int end = d->pos + len;
+      // keep the hash chain for the covered strings
+      for ( d->pos++; d->pos < end; d->pos++ ) {
+        if ( d->wlen - d->pos >= MIN_MATCH ) def_insert(d, d->pos);
+      }
+    } else {
+      def_symbol(d, w[d->pos]);
+      d->pos++;
+    }
+  }
+}
+
+static void def_slide(http_deflate_t *d) {
+  int i;
+  memmove(d->window, d->window + DEFLATE_WSIZE, (size_t)(d->wlen - DEFLATE_WSIZE));
+  d->wlen -= DEFLATE_WSIZE;
+  d->pos -= DEFLATE_WSIZE;
+  for ( i = 0; i < DEFLATE_HASH_SIZE; i++ ) {
+    d->head[i] = d->head[i] > DEFLATE_WSIZE ? (uint16_t)(d->head[i] - DEFLATE_WSIZE) : 0;
+  }
+}
+
+http_deflate_t *http_deflate_init(http_enc_write_f out, void *out_arg) {
+  static const uint8_t gzip_head[10] = { 0x1f, 0x8b, 0x08, 0, 0, 0, 0, 0, 0, 0xff };
+  int i;
+  http_deflate_t *d = (http_deflate_t *)malloc(sizeof(http_deflate_t));
+  if ( !d ) return NULL;
+  memset(d->head, 0x0, sizeof(d->head));
+  d->write = out;
+  d->warg = out_arg;
+  d->wlen = 0;
+  d->pos = 0;
+  d->bitbuf = 0;
+  d->bitcnt = 0;
+  d->outlen = 0;
+  d->crc = 0;
+  d->total = 0;
+  d->err = 0;
+  for ( i = 0; i < (int)sizeof(gzip_head); i++ ) def_byte(d, gzip_head[i]);
+  // not final, fixed huffman codes
+  def_bits(d, 0x2, 3);
+  return d;
+}
+
+int http_deflate_write(http_deflate_t *d, const uint8_t *buf, int len) {
+  d->crc = http_crc32(d->crc, buf, len);
+  d->total += (uint32_t)len;
+  while ( len > 0 && !d->err ) {
+    if ( d->wlen == (int)sizeof(d->window) ) def_slide(d);
+    int part = (int)sizeof(d->window) - d->wlen;
+    if ( part > len ) part = len;
+    memcpy(d->window + d->wlen, buf, (size_t)part);
+    d->wlen += part;
+    buf += part;
+    len -= part;
+    def_compress(d, 0);
+  }
+  return d->err;
+}
+
+int http_deflate_finish(http_deflate_t *d) {
+  int i;
+  int ret;
+  def_compress(d, 1);
+  def_symbol(d, 256);
+  // the last empty block
+  def_bits(d, 0x3, 3);
+  def_symbol(d, 256);
+  if ( d->bitcnt ) def_bits(d, 0, 8 - d->bitcnt);
+  for ( i = 0; i < 4; i++ ) def_byte(d, (uint8_t)(d->crc >> (8 * i)));
+  for ( i = 0; i < 4; i++ ) def_byte(d, (uint8_t)(d->total >> (8 * i)));
+  def_flush(d);
+  ret = d->err;
+  free(d);
+  return ret;
+}
+
+#endif
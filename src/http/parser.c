@@ -0,0 +1,189 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "http/parser.h"
+#include <sys/mem.h>
+
+enum {
+  st_status_start = 0,
+  st_proto,
+  st_minor,
+  st_space,
+  st_code,
+  st_reason,
+  st_header_start,
+  st_header_lf,
+  st_name,
+  st_ows,
+  st_value,
+  st_body
+};
+
+static const char proto[] = "HTTP/1.";
+
+#define MAX_KNOWN_LEN 17
+// the known names have the different lengths
+// so the length is a perfect hash for them
+static const struct {
+  const char *name;
+  uint8_t id;
+} known[MAX_KNOWN_LEN + 1] = {
+  [10] = { "connection", http_hdr_connection },
+  [12] = { "content-type", http_hdr_content_type },
+  [14] = { "content-length", http_hdr_content_length },
+  [16] = { "content-encoding", http_hdr_content_encoding },
+  [17] = { "transfer-encoding", http_hdr_transfer_encoding }
+};
+
+static int lower(int c) {
+  return ( c >= 'A' && c <= 'Z' ) ? c + ('a' - 'A') : c;
+}
+
+static int is_token(int c) {
+  if ( c <= 0x20 || c >= 0x7f ) return 0;
+  return !strchr("\"(),/:;<=>?@[\\]{}", c);
+}
+
+static uint8_t header_id(const char *name, int len) {
+  int i;
+  if ( len > MAX_KNOWN_LEN || !known[len].name ) return http_hdr_other;
+  for ( i = 0; i < len; i++ ) {
+    if ( lower(name[i]) != known[len].name[i] ) return http_hdr_other;
+  }
+  return known[len].id;
+}
+
+void http_parser_init(http_parser_t *p) {
+  memset(p, 0x0, sizeof(http_parser_t));
+  p->state = st_status_start;
+}
+
+static int element_end(http_parser_t *p, int event) {
+  int size = p->pos + 1;
+  p->event = (uint8_t)event;
+  p->pos = 0;
+  return size;
+}
+
+int http_parser_execute(http_parser_t *p, char *buf, int len) {
+  for ( ; p->pos < len; p->pos++ ) {
+    int c = (uint8_t)buf[p->pos];
+    switch ( p->state ) {
+    case st_status_start:
+      // skip the empty lines before the status
+      if ( c == '\r' || c == '\n' ) break;
+      p->match = 0;
+      p->state = st_proto;
+      // fall through
+    case st_proto:
+      if ( c != proto[p->match] ) return -1;
+      if ( ++p->match == sizeof(proto) - 1 ) p->state = st_minor;
+      break;
+    case st_minor:
+      if ( c < '0' || c > '9' ) return -1;
+      p->minor = (uint8_t)(c - '0');
+      p->state = st_space;
+      break;
+    case st_space:
+      if ( c != ' ' ) return -1;
+      p->status = 0;
+      p->match = 0;
+      p->state = st_code;
+      break;
+    case st_code:
+      if ( c == ' ' && !p->match ) break;
+      if ( c < '0' || c > '9' ) return -1;
+      p->status = (uint16_t)(p->status * 10 + (c - '0'));
+      if ( ++p->match == 3 ) p->state = st_reason;
+      break;
+    case st_reason:
+      if ( c != '\n' ) break;
+      p->state = st_header_start;
+      return element_end(p, http_parse_status);
+    case st_header_start:
+      if ( c == '\r' ) {
+        p->state = st_header_lf;
+      } else if ( c == '\n' ) {
+        p->state = st_body;
+        return element_end(p, http_parse_done);
+      } else if ( c == ' ' || c == '\t' ) {
+        // obsolete line folding: the value only
+        p->name_end = 0;
+        p->state = st_ows;
+      } else if ( is_token(c) ) {
+        p->state = st_name;
+      } else {
+        return -1;
+      }
+      break;
+    case st_header_lf:
+      if ( c != '\n' ) return -1;
+      p->state = st_body;
+      return element_end(p, http_parse_done);
+    case st_name:
+      if ( c == ':' ) {
+        p->name_end = p->pos;
+        p->state = st_ows;
+      } else if ( !is_token(c) ) {
+        return -1;
+      }
+      break;
+    case st_ows:
+      if ( c == ' ' || c == '\t' ) break;
+      p->value_start = p->pos;
+      p->value_end = p->pos;
+      p->state = st_value;
+      // fall through
+    case st_value:
+      if ( c == '\n' ) {
+        p->name.ptr = buf;
+        p->name.len = p->name_end;
+        p->value.ptr = buf + p->value_start;
+        p->value.len = (uint16_t)(p->value_end - p->value_start);
+        p->id = header_id(buf, p->name_end);
+        p->state = st_header_start;
+        return element_end(p, http_parse_header);
+      }
+      // the trailing whitespaces aren't a part of the value
+      if ( c != ' ' && c != '\t' && c != '\r' ) p->value_end = p->pos + 1;
+      break;
+    default:
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int http_span_has_token(http_span_t *s, const char *token) {
+  int i = 0;
+  while ( i < s->len ) {
+    int j = 0;
+    while ( i < s->len && ( s->ptr[i] == ' ' || s->ptr[i] == '\t' || s->ptr[i] == ',' ) ) i++;
+    while ( i < s->len && token[j] && lower(s->ptr[i]) == lower(token[j]) ) { i++; j++; }
+    if ( !token[j] ) {
+      while ( i < s->len && ( s->ptr[i] == ' ' || s->ptr[i] == '\t' ) ) i++;
+      if ( i == s->len || s->ptr[i] == ',' ) return 1;
+    }
+    // skip the rest of the element
+    while ( i < s->len && s->ptr[i] != ',' ) i++;
+  }
+  return 0;
+}
+
+int http_span_to_uint(http_span_t *s, uint32_t *val) {
+  uint32_t v = 0;
+  int i;
+  if ( !s->len ) return -1;
+  for ( i = 0; i < s->len; i++ ) {
+    if ( s->ptr[i] < '0' || s->ptr[i] > '9' ) return -1;
+    if ( v > ( 0xffffffffU - 9 ) / 10 ) return -1;
+    v = v * 10 + (uint32_t)(s->ptr[i] - '0');
+  }
+  *val = v;
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#define MODULE_NAME "HTTP_Pool"
+
+#include "http/pool.h"
+#include <bsd/socket.h>
+#include <debug.h>
+
+#if HTTP_POOL_SIZE < 1
+# error "HTTP_POOL_SIZE should be at least 1"
+#endif
+
+// the session flag value used after each request
+#if HTTP_POOL_IDLE_TIMEOUT > 0
+# define POOL_CLOSE 0
+#else
+# define POOL_CLOSE 1
+#endif
+
+static http_client_t _pool[HTTP_POOL_SIZE];
+static http_client_t *_last = NULL;
+
+int __attribute__((weak)) http_pool_sock_alive(int sock) {
+#if defined(MSG_PEEK) && defined(MSG_DONTWAIT)
+  char c;
+  // nothing should be pending on an idle connection:
+  // 0 - closed by the server, >0 - out of sync or a TLS alert
+  int ret = recv(sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return ret < 0 ? 1 : 0;
+#else
+  SSP_PARAMETER_NOT_USED(sock);
+  return 1;
+#endif
+}
+
+static void pool_init(void) {
+  int i;
+  if ( _last ) return;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    memset(_pool + i, 0x0, sizeof(http_client_t));
+    _pool[i].sock = -1;
+    _pool[i].flags._new = 1;
+    _pool[i].flags._close = POOL_CLOSE;
+  }
+  _last = _pool;
+}
+
+static void pool_drop(http_client_t *cli) {
+  if ( !cli->queue ) return;
+  int close = cli->flags._close;
+  cli->flags._close = 1;
+  http_client_free(cli);
+  cli->flags._close = close;
+}
+
+static int pool_match(http_client_t *cli, http_request_t *req) {
+  return cli->sock >= 0 &&
+         cli->port == req->port &&
+         cli->is_cipher == (uint8_t)req->is_cipher &&
+         !IS_EMPTY(cli->host) &&
+         strcmp(P_VALUE(cli->host), P_VALUE(req->host)) == 0;
+}
+
+http_client_t *http_pool_acquire(http_request_t *req) {
+  int i;
+  http_client_t *cli = NULL;
+  http_client_t *lru = NULL;
+  time_t now = time(NULL);
+  pool_init();
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    http_client_t *c = _pool + i;
+    if ( c->busy ) continue;
+    if ( c->sock >= 0 &&
+         ( now - c->last_used > HTTP_POOL_IDLE_TIMEOUT ||
+           now < c->last_used ) ) {
+      DBG("drop idle connection %d", c->sock);
+      pool_drop(c);
+    }
+    if ( !cli && pool_match(c, req) ) cli = c;
+    // a free slot at first, the least recently used connection then
+    if ( !lru || ( lru->sock >= 0 &&
+         ( c->sock < 0 || c->last_used < lru->last_used ) ) ) lru = c;
+  }
+  if ( cli ) {
+    if ( !http_pool_sock_alive(cli->sock) ) {
+      DBG("connection %d is closed", cli->sock);
+      http_client_close(cli);
+    }
+  } else {
+    if ( !lru ) {
+      DBG("no free connection");
+      return NULL;
+    }
+    cli = lru;
+    if ( cli->sock >= 0 ) pool_drop(cli);
+  }
+  http_client_init(cli);
+  cli->busy = 1;
+  _last = cli;
+  return cli;
+}
+
+void http_pool_release(http_client_t *cli) {
+  cli->last_used = time(NULL);
+  cli->busy = 0;
+  http_client_free(cli);
+  // http_session_close_set works for one request only
+  cli->flags._close = POOL_CLOSE;
+}
+
+http_client_t *http_pool_current(void) {
+  pool_init();
+  return _last;
+}
+
+void http_pool_close_all(void) {
+  int i;
+  pool_init();
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( !_pool[i].busy ) pool_drop(_pool + i);
+  }
+}
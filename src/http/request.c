@@ -85,10 +85,14 @@ void http_request_init(http_request_t *req, int meth, const char *url) {
   req->header = NULL;
   req->query = NULL;
   req->is_chunked = 0;
+  req->is_gzip = 0;
   memset(&req->payload, 0x0, sizeof(http_payload_t));
+  req->payload_producer = NULL;
+  req->payload_arg = NULL;
   property_map_init(&req->content_type);
   req->_response_payload_meth._p_set_handler = default_set_payload_handler;
   req->_response_payload_meth._p_add_handler = default_add_payload_handler;
+  req->_response_payload_meth.arg = NULL;
 }
 
 void http_request_close(http_request_t *req) {
@@ -129,6 +133,15 @@ void http_request_set_payload(http_request_t *req, property_t payload) {
   }
 }
 
+void http_request_set_payload_producer(http_request_t *req,
+                                       http_payload_producer_f producer,
+                                       void *arg) {
+  req->payload_producer = producer;
+  req->payload_arg = arg;
+  // the size is unknown beforehand
+  req->is_chunked = 1;
+}
+
 int http_request_set_findby(http_request_t *req, find_by_t *fb) {
     find_by_t *tmp = NULL;
     find_by_for_each(tmp, fb) {
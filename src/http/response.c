@@ -61,6 +61,7 @@ void http_response_init(http_response_t *res, _payload_meth_t *handler) {
   memset(res, 0x00, sizeof(http_response_t));
   res->_p_meth._p_set_handler = handler->_p_set_handler;
   res->_p_meth._p_add_handler = handler->_p_add_handler;
+  res->_p_meth.arg = handler->arg;
 }
 
 void http_response_free(http_response_t *res) {
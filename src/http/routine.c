@@ -10,36 +10,114 @@
 
 #include "http/routine.h"
 #include <http/client.h>
+#include <http/pool.h>
 #include <arrow/sign.h>
 #include <debug.h>
 
-static http_client_t _cli = { -1, -1, 0, {1, 1}, NULL, NULL, NULL };
-
 http_client_t *current_client(void) {
-  return &_cli;
+  return http_pool_current();
+}
+
+static int routine_response(response_proc_f resp_proc, void *arg_proc,
+                            http_response_t *response) {
+  int ret = 0;
+  if ( resp_proc ) {
+    ret = resp_proc(response, arg_proc);
+  } else if ( response->m_httpResponseCode != 200 ) {
+    ret = -1;
+  }
+  http_response_free(response);
+  return ret;
+}
+
+static int routine_do(http_request_t *request,
+                      response_proc_f resp_proc, void *arg_proc) {
+  int ret = 0;
+  http_response_t response;
+  http_client_t *cli = http_pool_acquire(request);
+  if ( !cli ) return -1;
+  ret = http_client_do(cli, request, &response);
+  http_pool_release(cli);
+  if ( ret < 0 ) {
+    http_response_free(&response);
+    return ret;
+  }
+  return routine_response(resp_proc, arg_proc, &response);
 }
 
 int __http_routine(response_init_f req_init, void *arg_init,
                    response_proc_f resp_proc, void *arg_proc) {
   int ret = 0;
   http_request_t request;
-  http_response_t response;
-  http_client_init(&_cli);
   req_init(&request, arg_init);
-  sign_request(&request);
-  ret = http_client_do(&_cli, &request, &response);
+  if ( sign_request(&request) < 0 ) ret = -1;
+  else ret = routine_do(&request, resp_proc, arg_proc);
   http_request_close(&request);
-  http_client_free(&_cli);
-  if ( ret < 0 ) goto http_error;
-  if ( resp_proc ) {
-    ret = resp_proc(&response, arg_proc);
-  } else {
-    if ( response.m_httpResponseCode != 200 ) {
-      ret = -1;
-      goto http_error;
+  return ret;
+}
+
+#if !defined(NO_HTTP_PIPELINE)
+static int same_endpoint(http_request_t *a, http_request_t *b) {
+  return a->port == b->port &&
+         a->is_cipher == b->is_cipher &&
+         strcmp(P_VALUE(a->host), P_VALUE(b->host)) == 0;
+}
+
+static void routine_batch(http_routine_t *r, int count) {
+  http_request_t request[HTTP_PIPELINE_SIZE];
+  int i;
+  int sent = 0;
+  int done = 0;
+  int inited = count;
+  for ( i = 0; i < count; i++ ) {
+    r[i].req_init(request + i, r[i].arg_init);
+    if ( sign_request(request + i) < 0 ) {
+      // the requests after this one wait for it
+      for ( inited = i + 1; i < count; i++ ) r[i].ret = -1;
+      count = inited - 1;
+      break;
     }
   }
-http_error:
-  http_response_free(&response);
-  return ret;
+  http_client_t *cli = count ? http_pool_acquire(request) : NULL;
+  if ( cli ) {
+    while ( sent < count && same_endpoint(request, request + sent) ) {
+      if ( http_client_send(cli, request + sent) < 0 ) break;
+      sent++;
+    }
+    while ( done < sent ) {
+      http_response_t response;
+      if ( http_client_receive(cli, request + done, &response) < 0 ) {
+        http_response_free(&response);
+        break;
+      }
+      r[done].ret = routine_response(r[done].resp_proc, r[done].arg_proc, &response);
+      done++;
+    }
+    http_pool_release(cli);
+  }
+  // the connection was closed before the answer
+  // or the endpoint is another: one by one
+  for ( i = done; i < count; i++ ) {
+    r[i].ret = routine_do(request + i, r[i].resp_proc, r[i].arg_proc);
+  }
+  for ( i = 0; i < inited; i++ ) http_request_close(request + i);
+}
+#endif
+
+int __http_routine_pipeline(http_routine_t *r, int count) {
+  int i;
+#if defined(NO_HTTP_PIPELINE)
+  for ( i = 0; i < count; i++ ) {
+    r[i].ret = __http_routine(r[i].req_init, r[i].arg_init,
+                              r[i].resp_proc, r[i].arg_proc);
+  }
+#else
+  for ( i = 0; i < count; i += HTTP_PIPELINE_SIZE ) {
+    int n = count - i;
+    if ( n > HTTP_PIPELINE_SIZE ) n = HTTP_PIPELINE_SIZE;
+    routine_batch(r + i, n);
+  }
+#endif
+  for ( i = 0; i < count && r[i].ret >= 0; i++ );
+  return i;
 }
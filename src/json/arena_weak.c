@@ -0,0 +1,59 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/json.h"
+#include <sys/mem.h>
+#include <stdlib.h>
+
+// The fallback for a platform json.c (CJSON=no) without the arena:
+// the trees are decoded on the heap and the arena keeps their roots
+// to delete them in json_arena_free.
+
+void __attribute__((weak)) json_arena_init(json_arena_t *arena, size_t block_size) {
+  arena->head = NULL;
+  arena->block_size = block_size;
+}
+
+void __attribute__((weak)) json_arena_free(json_arena_t *arena) {
+  json_arena_block_t *b, *next;
+  for ( b = arena->head; b; b = next ) {
+    next = b->next;
+    json_delete(*(JsonNode **)(b + 1));
+    free(b);
+  }
+  arena->head = NULL;
+}
+
+JsonNode __attribute__((weak)) *json_decode_arena(json_arena_t *arena, const char *json) {
+  json_arena_block_t *b;
+  JsonNode *root = json_decode(json);
+  if ( !root ) return NULL;
+  b = (json_arena_block_t *)malloc(sizeof(json_arena_block_t) + sizeof(JsonNode *));
+  if ( !b ) {
+    json_delete(root);
+    return NULL;
+  }
+  b->size = b->used = sizeof(JsonNode *);
+  *(JsonNode **)(b + 1) = root;
+  b->next = arena->head;
+  arena->head = b;
+  return root;
+}
+
+JsonNode __attribute__((weak)) *json_decode_insitu(json_arena_t *arena, char *json) {
+  return json_decode_arena(arena, json);
+}
+
+JsonNode __attribute__((weak)) *json_copy(const JsonNode *node) {
+  JsonNode *copy;
+  char *text = json_encode(node);
+  if ( !text ) return NULL;
+  copy = json_decode(text);
+  free(text);
+  return copy;
+}
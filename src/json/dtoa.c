@@ -0,0 +1,332 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/dtoa.h"
+#include <sys/mem.h>
+#include <stdio.h>
+#include <math.h>
+
+// Grisu2 by Florian Loitsch, "Printing Floating-Point Numbers Quickly
+// and Accurately with Integers", the shortest output in 99.9% of the cases
+// and always the correct one
+
+typedef struct {
+  uint64_t f;
+  int e;
+} diy_fp_t;
+
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_HIDDEN_BIT       0x0010000000000000ULL
+#define DP_EXPONENT_BIAS    1075
+
+// 10^k normalized, k = -348, -340, ..., 340
+static const uint64_t cached_f[] = {
+  0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+  0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+  0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+  0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+  0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+  0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+  0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+  0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+  0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+  0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+  0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+  0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+  0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+  0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+  0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+  0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+  0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+  0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+  0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+  0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+  0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+  0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+  0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+  0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+  0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+  0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+  0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+  0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+  0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const int16_t cached_e[] = {
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+  -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+  -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+  -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+  56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+  694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+  1013, 1039, 1066,
+};
+
+static const uint64_t pow10_u64[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+  100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+  1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+  1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+  1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static diy_fp_t fp_normalize(diy_fp_t x) {
+  while ( !( x.f & 0x8000000000000000ULL ) ) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+static diy_fp_t fp_mul(diy_fp_t x, diy_fp_t y) {
+  const uint64_t m32 = 0xFFFFFFFFULL;
+  uint64_t a = x.f >> 32, b = x.f & m32;
+  uint64_t c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = ( bd >> 32 ) + ( ad & m32 ) + ( bc & m32 );
+  diy_fp_t r;
+  tmp += 1ULL << 31;  // round
+  r.f = ac + ( ad >> 32 ) + ( bc >> 32 ) + ( tmp >> 32 );
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+static diy_fp_t cached_power(int e, int *k) {
+  double dk = ( -61 - e ) * 0.30102999566398114 + 347;
+  int ik = (int)dk;
+  int index;
+  diy_fp_t r;
+  if ( dk - ik > 0.0 ) ik++;
+  index = ( ik >> 3 ) + 1;
+  *k = -( -348 + index * 8 );
+  r.f = cached_f[index];
+  r.e = cached_e[index];
+  return r;
+}
+
+static void grisu_round(char *buf, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w) {
+  while ( rest < wp_w && delta - rest >= ten_kappa &&
+          ( rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w ) ) {
+    buf[len - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+static int count_digits(uint32_t n) {
+  int d = 1;
+  while ( n >= 10 && d < 10 ) {
+    n /= 10;
+    d++;
+  }
+  return d;
+}
+
+static int digit_gen(diy_fp_t w, diy_fp_t mp, uint64_t delta, char *buf, int *k) {
+  diy_fp_t one;
+  uint64_t wp_w = mp.f - w.f;
+  uint32_t p1;
+  uint64_t p2;
+  int kappa, len = 0;
+  one.f = 1ULL << -mp.e;
+  one.e = mp.e;
+  p1 = (uint32_t)( mp.f >> -one.e );
+  p2 = mp.f & ( one.f - 1 );
+  kappa = count_digits(p1);
+  while ( kappa > 0 ) {
+    uint32_t div = (uint32_t)pow10_u64[kappa - 1];
+    uint32_t d = p1 / div;
+    uint64_t tmp;
+    p1 %= div;
+    if ( d || len ) buf[len++] = (char)( '0' + d );
+    kappa--;
+    tmp = ( (uint64_t)p1 << -one.e ) + p2;
+    if ( tmp <= delta ) {
+      *k += kappa;
+      grisu_round(buf, len, delta, tmp, pow10_u64[kappa] << -one.e, wp_w);
+      return len;
+    }
+  }
+  for ( ;; ) {
+    char d;
+    p2 *= 10;
+    delta *= 10;
+    d = (char)( p2 >> -one.e );
+    if ( d || len ) buf[len++] = (char)( '0' + d );
+    p2 &= one.f - 1;
+    kappa--;
+    if ( p2 < delta ) {
+      *k += kappa;
+      grisu_round(buf, len, delta, p2, one.f, -kappa < 20 ? wp_w * pow10_u64[-kappa] : 0);
+      return len;
+    }
+  }
+}
+
+// the digits and the decimal exponent: v = digits * 10^k
+static int grisu2(double v, char *buf, int *k) {
+  union { double d; uint64_t u; } bits;
+  diy_fp_t w, pl, mi, c_mk, W, Wp, Wm;
+  int be;
+  bits.d = v;
+  be = (int)( ( bits.u >> 52 ) & 0x7FF );
+  w.f = bits.u & DP_SIGNIFICAND_MASK;
+  if ( be ) {
+    w.f += DP_HIDDEN_BIT;
+    w.e = be - DP_EXPONENT_BIAS;
+  } else {
+    w.e = 1 - DP_EXPONENT_BIAS;
+  }
+  // the boundaries m- and m+
+  pl.f = ( w.f << 1 ) + 1;
+  pl.e = w.e - 1;
+  pl = fp_normalize(pl);
+  if ( w.f == DP_HIDDEN_BIT ) {
+    mi.f = ( w.f << 2 ) - 1;
+    mi.e = w.e - 2;
+  } else {
+    mi.f = ( w.f << 1 ) - 1;
+    mi.e = w.e - 1;
+  }
+  mi.f <<= mi.e - pl.e;
+  mi.e = pl.e;
+
+  c_mk = cached_power(pl.e, k);
+  W = fp_mul(fp_normalize(w), c_mk);
+  Wp = fp_mul(pl, c_mk);
+  Wm = fp_mul(mi, c_mk);
+  Wm.f++;
+  Wp.f--;
+  return digit_gen(W, Wp, Wp.f - Wm.f, buf, k);
+}
+
+static int write_exponent(int e, char *buf) {
+  int len = 0;
+  if ( e < 0 ) {
+    buf[len++] = '-';
+    e = -e;
+  }
+  if ( e >= 100 ) {
+    buf[len++] = (char)( '0' + e / 100 );
+    e %= 100;
+    buf[len++] = (char)( '0' + e / 10 );
+  } else if ( e >= 10 ) {
+    buf[len++] = (char)( '0' + e / 10 );
+  }
+  buf[len++] = (char)( '0' + e % 10 );
+  return len;
+}
+
+// digits * 10^k in the plain or the exponent notation
+static int prettify(char *buf, int len, int k) {
+  int kk = len + k;  // 10^(kk-1) <= v < 10^kk
+  int i;
+  if ( k >= 0 && kk <= 21 ) {
+    // 1234e3 -> 1234000
+    for ( i = len; i < kk; i++ ) buf[i] = '0';
+    return kk;
+  }
+  if ( kk > 0 && kk <= 21 ) {
+    // 1234e-2 -> 12.34
+    memmove(buf + kk + 1, buf + kk, (size_t)( len - kk ));
+    buf[kk] = '.';
+    return len + 1;
+  }
+  if ( kk > -6 && kk <= 0 ) {
+    // 1234e-6 -> 0.001234
+    int offset = 2 - kk;
+    memmove(buf + offset, buf, (size_t)len);
+    buf[0] = '0';
+    buf[1] = '.';
+    for ( i = 2; i < offset; i++ ) buf[i] = '0';
+    return len + offset;
+  }
+  if ( len == 1 ) {
+    // 1e30
+    buf[1] = 'e';
+    return 2 + write_exponent(kk - 1, buf + 2);
+  }
+  // 1234e30 -> 1.234e33
+  memmove(buf + 2, buf + 1, (size_t)( len - 1 ));
+  buf[1] = '.';
+  buf[len + 1] = 'e';
+  return len + 2 + write_exponent(kk - 1, buf + len + 2);
+}
+
+static int write_u64(uint64_t v, char *buf) {
+  char tmp[20];
+  int n = 0, len = 0;
+  do {
+    tmp[n++] = (char)( '0' + v % 10 );
+    v /= 10;
+  } while ( v );
+  while ( n ) buf[len++] = tmp[--n];
+  return len;
+}
+
+int json_itoa(int64_t v, char *buf) {
+  int len = 0;
+  uint64_t u = (uint64_t)v;
+  if ( v < 0 ) {
+    buf[len++] = '-';
+    u = ~u + 1;
+  }
+  len += write_u64(u, buf + len);
+  buf[len] = '\0';
+  return len;
+}
+
+int json_dtoa(double v, char *buf) {
+  int len = 0, k = 0, n;
+  if ( isnan(v) || isinf(v) ) return -1;
+  // the integers are the most of the numbers
+  if ( fabs(v) < 9007199254740992.0 && (double)(int64_t)v == v )
+    return json_itoa((int64_t)v, buf);
+  if ( v < 0 ) {
+    buf[len++] = '-';
+    v = -v;
+  }
+  n = grisu2(v, buf + len, &k);
+  len += prettify(buf + len, n, k);
+  buf[len] = '\0';
+  return len;
+}
+
+int json_dtoa_fixed(double v, int prec, char *buf, int size) {
+  double scaled, frac;
+  uint64_t n, p;
+  int len = 0;
+  if ( prec < 0 || prec > 9 ) goto exact;
+  scaled = fabs(v) * (double)pow10_u64[prec];
+  // keep a few fraction bits to see the rounding
+  if ( isnan(scaled) || scaled >= 1125899906842624.0 ) goto exact;
+  frac = scaled - (double)(uint64_t)scaled;
+  // a tie may be on the either side of the real value
+  if ( fabs(frac - 0.5) <= scaled * 4.5e-16 ) goto exact;
+  n = (uint64_t)( scaled + 0.5 );
+  p = pow10_u64[prec];
+  if ( size < 24 + prec ) goto exact;
+  if ( signbit(v) ) buf[len++] = '-';
+  len += write_u64(n / p, buf + len);
+  if ( prec ) {
+    uint64_t f = n % p;
+    int i;
+    buf[len++] = '.';
+    for ( i = prec - 1; i >= 0; i-- ) {
+      buf[len + i] = (char)( '0' + f % 10 );
+      f /= 10;
+    }
+    len += prec;
+  }
+  buf[len] = '\0';
+  return len;
+exact:
+  len = snprintf(buf, (size_t)size, "%.*f", prec, v);
+  return ( len < 0 || len >= size ) ? -1 : len;
+}
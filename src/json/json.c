@@ -22,6 +22,8 @@
 */
 
 #include "json/json.h"
+#include "json/dtoa.h"
+#include "json/scan.h"
 
 #include <sys/mem.h>
 #if defined(__USE_STD__)
@@ -46,6 +48,72 @@ static char *json_strdup(const char *str)
 	return ret;
 }
 
+/* Arena */
+
+#define arena_align(n) (((n) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+#define arena_data(b) ((char*)(b) + arena_align(sizeof(json_arena_block_t)))
+
+void json_arena_init(json_arena_t *arena, size_t block_size)
+{
+	arena->head = NULL;
+	arena->block_size = block_size ? block_size : JSON_ARENA_BLOCK;
+}
+
+void json_arena_free(json_arena_t *arena)
+{
+	json_arena_block_t *b, *next;
+	for (b = arena->head; b != NULL; b = next) {
+		next = b->next;
+		free(b);
+	}
+	arena->head = NULL;
+}
+
+/* Make sure the current block has @size free bytes. */
+static bool arena_reserve(json_arena_t *arena, size_t size)
+{
+	json_arena_block_t *b = arena->head;
+	
+	if (b != NULL && b->size - b->used >= size)
+		return true;
+	if (size < arena->block_size)
+		size = arena->block_size;
+	b = (json_arena_block_t*) malloc(arena_align(sizeof(json_arena_block_t)) + size);
+	if (b == NULL) {
+		out_of_memory();
+		return false;
+	}
+	b->size = size;
+	b->used = 0;
+	b->next = arena->head;
+	arena->head = b;
+	return true;
+}
+
+static void *arena_alloc(json_arena_t *arena, size_t size)
+{
+	void *ret;
+	
+	size = arena_align(size);
+	if (!arena_reserve(arena, size))
+		return NULL;
+	ret = arena_data(arena->head) + arena->head->used;
+	arena->head->used += size;
+	return ret;
+}
+
+static char *arena_strdup(json_arena_t *arena, const char *str)
+{
+	char *ret;
+	
+	if (arena == NULL)
+		return json_strdup(str);
+	ret = (char*) arena_alloc(arena, strlen(str) + 1);
+	if (ret != NULL)
+		strcpy(ret, str);
+	return ret;
+}
+
 /* String buffer */
 
 typedef struct
@@ -53,15 +121,26 @@ typedef struct
 	char *cur;
 	char *end;
 	char *start;
+	char *fixed; /* the caller buffer, never reallocated */
 } SB;
 
-static void sb_init(SB *sb)
+static void sb_init_size(SB *sb, size_t size)
 {
-	sb->start = (char*) malloc(17);
+	sb->start = (char*) malloc(size + 1);
 	if (sb->start == NULL)
 		out_of_memory();
 	sb->cur = sb->start;
-	sb->end = sb->start + 16;
+	sb->end = sb->start + size;
+	sb->fixed = NULL;
+}
+
+/* @cap includes the null terminator, it's at least 1. */
+static void sb_init_fixed(SB *sb, char *buf, int cap)
+{
+	sb->start = buf;
+	sb->cur = buf;
+	sb->end = buf + cap - 1;
+	sb->fixed = buf;
 }
 
 /* sb and need may be evaluated multiple times. */
@@ -75,13 +154,27 @@ static void sb_grow(SB *sb, int need)
 	size_t length = (size_t)(sb->cur - sb->start);
 	size_t alloc = (size_t)(sb->end - sb->start);
 	
+	if (alloc < 16)
+		alloc = 16;
 	do {
 		alloc *= 2;
 	} while (alloc < length + (size_t)need);
 	
-	sb->start = (char*) realloc(sb->start, alloc + 1);
-	if (sb->start == NULL)
-		out_of_memory();
+	if (sb->start == sb->fixed) {
+		/*
+		 * The caller buffer is full (or lacks the slack emit_string asks for):
+		 * go on in the heap, json_encode_into sorts it out.
+		 */
+		char *heap = (char*) malloc(alloc + 1);
+		if (heap == NULL)
+			out_of_memory();
+		memcpy(heap, sb->start, length);
+		sb->start = heap;
+	} else {
+		sb->start = (char*) realloc(sb->start, alloc + 1);
+		if (sb->start == NULL)
+			out_of_memory();
+	}
 	sb->cur = sb->start + length;
 	sb->end = sb->start + alloc;
 }
@@ -111,12 +204,6 @@ static char *sb_finish(SB *sb)
 	return sb->start;
 }
 
-static void sb_free(SB *sb)
-{
-    if ( sb && sb->start )
-        free(sb->start);
-}
-
 /*
  * Unicode helper functions
  *
@@ -210,10 +297,15 @@ static bool utf8_validate(const char *s)
 {
 	int len;
 	
-	for (; *s != 0; s += len) {
+	for (;;) {
+		/* Skip the plain ASCII runs at once. */
+		s += json_scan_ascii(s);
+		if (*s == 0)
+			break;
 		len = utf8_validate_cz(s);
 		if (len == 0)
 			return false;
+		s += len;
 	}
 	
 	return true;
@@ -331,11 +423,18 @@ static void to_surrogate_pair(uchar_t unicode, uint16_t *uc, uint16_t *lc)
 #define is_space(c) ((c) == '\t' || (c) == '\n' || (c) == '\r' || (c) == ' ')
 #define is_digit(c) ((c) >= '0' && (c) <= '9')
 
-static bool parse_value     (const char **sp, JsonNode        **out);
-static bool parse_string    (const char **sp, char            **out);
+/* Decoding mode */
+typedef struct
+{
+	json_arena_t *arena;  /* NULL - the heap */
+	bool insitu;          /* the strings are unescaped right in the text */
+} ParseCtx;
+
+static bool parse_value     (ParseCtx *ctx, const char **sp, JsonNode **out);
+static bool parse_string    (ParseCtx *ctx, const char **sp, char     **out);
 static bool parse_number    (const char **sp, double           *out);
-static bool parse_array     (const char **sp, JsonNode        **out);
-static bool parse_object    (const char **sp, JsonNode        **out);
+static bool parse_array     (ParseCtx *ctx, const char **sp, JsonNode **out);
+static bool parse_object    (ParseCtx *ctx, const char **sp, JsonNode **out);
 static bool parse_hex16     (const char **sp, uint16_t         *out);
 
 static bool expect_literal  (const char **sp, const char *str);
@@ -352,22 +451,27 @@ static void emit_object_indented    (SB *out, const JsonNode *object, const char
 
 static int write_hex16(char *out, uint16_t val);
 
-static JsonNode *mknode(JsonTag tag);
+static JsonNode *mknode(json_arena_t *arena, JsonTag tag);
+static void drop_index(JsonNode *object);
 static void append_node(JsonNode *parent, JsonNode *child);
 static void prepend_node(JsonNode *parent, JsonNode *child);
 static void append_member(JsonNode *object, char *key, JsonNode *value);
 
 /* Assertion-friendly validity checks */
 static bool tag_is_valid(unsigned int tag);
-static bool number_is_valid(const char *num);
 
 JsonNode *json_decode(const char *json)
+{
+	return json_decode_arena(NULL, json);
+}
+
+static JsonNode *decode(ParseCtx *ctx, const char *json)
 {
 	const char *s = json;
 	JsonNode *ret;
 	
 	skip_space(&s);
-	if (!parse_value(&s, &ret))
+	if (!parse_value(ctx, &s, &ret))
 		return NULL;
 	
 	skip_space(&s);
@@ -379,15 +483,92 @@ JsonNode *json_decode(const char *json)
 	return ret;
 }
 
+JsonNode *json_decode_arena(json_arena_t *arena, const char *json)
+{
+	ParseCtx ctx = { arena, false };
+	
+	/* The tree takes about three times the text: one block is enough. */
+	if (arena != NULL && arena->head == NULL)
+		arena_reserve(arena, strlen(json) * 3);
+	return decode(&ctx, json);
+}
+
+JsonNode *json_decode_insitu(json_arena_t *arena, char *json)
+{
+	ParseCtx ctx = { arena, true };
+	
+	/* Only the nodes are allocated: about twice the text. */
+	if (arena->head == NULL)
+		arena_reserve(arena, strlen(json) * 2);
+	return decode(&ctx, json);
+}
+
+/*
+ * Upper guess of the compact text size, so that the encoder
+ * gets the whole buffer at once. Only the escapes go beyond it.
+ */
+static size_t encoded_size_hint(const JsonNode *node)
+{
+	size_t size = 2;
+	const JsonNode *child;
+	
+	switch (node->tag) {
+		case JSON_NULL:
+			return 4;
+		case JSON_BOOL:
+			return 5;
+		case JSON_STRING:
+			return strlen(node->string_) + 2;
+		case JSON_NUMBER:
+			return JSON_DTOA_SIZE;
+		case JSON_ARRAY:
+		case JSON_OBJECT:
+			json_foreach(child, node) {
+				size += encoded_size_hint(child) + 1;
+				if (node->tag == JSON_OBJECT)
+					size += strlen(child->key) + 3;
+			}
+			return size;
+		default:
+			return 16;
+	}
+}
+
 char *json_encode(const JsonNode *node)
 {
 	return json_stringify(node, NULL);
 }
 
+int json_encode_into(const JsonNode *node, char *buf, int cap)
+{
+	SB sb;
+	int length;
+	
+	if (buf == NULL || cap <= 0)
+		return -1;
+	
+	sb_init_fixed(&sb, buf, cap);
+	emit_value(&sb, node);
+	length = (int)(sb.cur - sb.start);
+	
+	if (sb.start != buf) {
+		/* It went to the heap: the text may still fit without the slack. */
+		if (length < cap)
+			memcpy(buf, sb.start, (size_t)length);
+		free(sb.start);
+		if (length >= cap)
+			return -1;
+		buf[length] = 0;
+		return length;
+	}
+	sb_finish(&sb);
+	return length;
+}
+
 char *json_encode_string(const char *str)
 {
 	SB sb;
-	sb_init(&sb);
+	sb_init_size(&sb, strlen(str) + 2);
 	
 	emit_string(&sb, str);
 	
@@ -397,7 +578,7 @@ char *json_encode_string(const char *str)
 char *json_stringify(const JsonNode *node, const char *space)
 {
 	SB sb;
-	sb_init(&sb);
+	sb_init_size(&sb, encoded_size_hint(node));
 	
 	if (space != NULL)
 		emit_value_indented(&sb, node, space, 0);
@@ -412,12 +593,18 @@ void json_delete(JsonNode *node)
 	if (node != NULL) {
 		json_remove_from_parent(node);
 		
+		/* The arena keeps the rest. */
+		if (node->arena_)
+			return;
+		
 		switch (node->tag) {
 			case JSON_STRING:
 				free(node->string_);
 				break;
-			case JSON_ARRAY:
 			case JSON_OBJECT:
+				drop_index(node);
+				/* fallthrough */
+			case JSON_ARRAY:
 			{
 				JsonNode *child, *next;
 				for (child = node->children.head; child != NULL; child = next) {
@@ -436,9 +623,10 @@ void json_delete(JsonNode *node)
 bool json_validate(const char *json)
 {
 	const char *s = json;
+	ParseCtx ctx = { NULL, false };
 	
 	skip_space(&s);
-	if (!parse_value(&s, NULL))
+	if (!parse_value(&ctx, &s, NULL))
 		return false;
 	
 	skip_space(&s);
@@ -465,6 +653,73 @@ JsonNode *json_find_element(JsonNode *array, int index)
 	return NULL;
 }
 
+#if !defined(NO_JSON_INDEX)
+struct JsonIndex
+{
+	unsigned int mask;  /* the number of slots - 1 */
+	JsonNode *slot[1];
+};
+
+/* FNV-1a */
+static unsigned int key_hash(const char *key)
+{
+	unsigned int h = 2166136261u;
+	while (*key)
+		h = (h ^ (unsigned char) *key++) * 16777619u;
+	return h;
+}
+
+/*
+ * Hash the members of @object, at least a half of the slots stay empty.
+ * The index memory is taken from the arena if there is one.
+ * Returns NULL for the small objects and on the allocation failure,
+ * the lookup scans the members then.
+ */
+static JsonIndex *build_index(json_arena_t *arena, JsonNode *object)
+{
+	JsonIndex *index;
+	JsonNode *member;
+	unsigned int count = 0, size = 4, h;
+	size_t bytes;
+	
+	json_foreach(member, object)
+		count++;
+	if (count < JSON_INDEX_MIN)
+		return NULL;
+	while (size < count * 2)
+		size *= 2;
+	
+	bytes = sizeof(JsonIndex) + (size - 1) * sizeof(JsonNode*);
+	index = (JsonIndex*) (arena != NULL ? arena_alloc(arena, bytes) : malloc(bytes));
+	if (index == NULL)
+		return NULL;
+	memset(index, 0, bytes);
+	index->mask = size - 1;
+	
+	json_foreach(member, object) {
+		h = key_hash(member->key) & index->mask;
+		while (index->slot[h] != NULL && strcmp(index->slot[h]->key, member->key) != 0)
+			h = (h + 1) & index->mask;
+		/* the first one of the same keys is found, like by the scan */
+		if (index->slot[h] == NULL)
+			index->slot[h] = member;
+	}
+	return index;
+}
+
+static void drop_index(JsonNode *object)
+{
+	if (object->children.index != NULL && !object->arena_)
+		free(object->children.index);
+	object->children.index = NULL;
+}
+#else
+static void drop_index(JsonNode *object)
+{
+	(void) object;
+}
+#endif
+
 JsonNode *json_find_member(JsonNode *object, const char *name)
 {
 	JsonNode *member;
@@ -472,6 +727,23 @@ JsonNode *json_find_member(JsonNode *object, const char *name)
 	if (object == NULL || object->tag != JSON_OBJECT)
 		return NULL;
 	
+#if !defined(NO_JSON_INDEX)
+	/* the arena objects are indexed by the decoder */
+	if (object->children.index == NULL && !object->arena_)
+		object->children.index = build_index(NULL, object);
+	if (object->children.index != NULL) {
+		JsonIndex *index = object->children.index;
+		unsigned int h = key_hash(name) & index->mask;
+		
+		while ((member = index->slot[h]) != NULL) {
+			if (strcmp(member->key, name) == 0)
+				return member;
+			h = (h + 1) & index->mask;
+		}
+		return NULL;
+	}
+#endif
+	
 	json_foreach(member, object)
 		if (strcmp(member->key, name) == 0)
 			return member;
@@ -486,58 +758,107 @@ JsonNode *json_first_child(const JsonNode *node)
 	return NULL;
 }
 
-static JsonNode *mknode(JsonTag tag)
+static JsonNode *mknode(json_arena_t *arena, JsonTag tag)
 {
-	JsonNode *ret = (JsonNode*) calloc(1, sizeof(JsonNode));
-	if (ret == NULL)
-		out_of_memory();
+	JsonNode *ret;
+	
+	if (arena != NULL) {
+		ret = (JsonNode*) arena_alloc(arena, sizeof(JsonNode));
+		if (ret == NULL)
+			return NULL;
+		memset(ret, 0, sizeof(JsonNode));
+		ret->arena_ = true;
+	} else {
+		ret = (JsonNode*) calloc(1, sizeof(JsonNode));
+		if (ret == NULL)
+			out_of_memory();
+	}
 	ret->tag = tag;
 	return ret;
 }
 
 JsonNode *json_mknull(void)
 {
-	return mknode(JSON_NULL);
+	return mknode(NULL, JSON_NULL);
+}
+
+JsonNode *json_arena_mknull(json_arena_t *arena)
+{
+	return mknode(arena, JSON_NULL);
 }
 
 JsonNode *json_mkbool(bool b)
 {
-	JsonNode *ret = mknode(JSON_BOOL);
-	ret->bool_ = b;
+	return json_arena_mkbool(NULL, b);
+}
+
+JsonNode *json_arena_mkbool(json_arena_t *arena, bool b)
+{
+	JsonNode *ret = mknode(arena, JSON_BOOL);
+	if (ret != NULL)
+		ret->bool_ = b;
 	return ret;
 }
 
-static JsonNode *mkstring(char *s)
+static JsonNode *mkstring(json_arena_t *arena, char *s)
 {
-	JsonNode *ret = mknode(JSON_STRING);
-	ret->string_ = s;
+	JsonNode *ret;
+	
+	if (s == NULL)
+		return NULL;
+	ret = mknode(arena, JSON_STRING);
+	if (ret != NULL)
+		ret->string_ = s;
 	return ret;
 }
 
 JsonNode *json_mkstring(const char *s)
 {
-	return mkstring(json_strdup(s));
+	return mkstring(NULL, json_strdup(s));
+}
+
+JsonNode *json_arena_mkstring(json_arena_t *arena, const char *s)
+{
+	return mkstring(arena, arena_strdup(arena, s));
 }
 
 JsonNode *json_mknumber(double n)
 {
-	JsonNode *node = mknode(JSON_NUMBER);
-	node->number_ = n;
+	return json_arena_mknumber(NULL, n);
+}
+
+JsonNode *json_arena_mknumber(json_arena_t *arena, double n)
+{
+	JsonNode *node = mknode(arena, JSON_NUMBER);
+	if (node != NULL)
+		node->number_ = n;
 	return node;
 }
 
 JsonNode *json_mkarray(void)
 {
-	return mknode(JSON_ARRAY);
+	return mknode(NULL, JSON_ARRAY);
+}
+
+JsonNode *json_arena_mkarray(json_arena_t *arena)
+{
+	return mknode(arena, JSON_ARRAY);
 }
 
 JsonNode *json_mkobject(void)
 {
-	return mknode(JSON_OBJECT);
+	return mknode(NULL, JSON_OBJECT);
+}
+
+JsonNode *json_arena_mkobject(json_arena_t *arena)
+{
+	return mknode(arena, JSON_OBJECT);
 }
 
 static void append_node(JsonNode *parent, JsonNode *child)
 {
+	if (parent->tag == JSON_OBJECT)
+		drop_index(parent);
 	child->parent = parent;
 	child->prev = parent->children.tail;
 	child->next = NULL;
@@ -551,6 +872,8 @@ static void append_node(JsonNode *parent, JsonNode *child)
 
 static void prepend_node(JsonNode *parent, JsonNode *child)
 {
+	if (parent->tag == JSON_OBJECT)
+		drop_index(parent);
 	child->parent = parent;
 	child->prev = NULL;
 	child->next = parent->children.head;
@@ -592,6 +915,14 @@ void json_append_member(JsonNode *object, const char *key, JsonNode *value)
 	append_member(object, json_strdup(key), value);
 }
 
+void json_arena_append_member(json_arena_t *arena, JsonNode *object, const char *key, JsonNode *value)
+{
+	assert(object->tag == JSON_OBJECT);
+	assert(value->parent == NULL);
+	
+	append_member(object, arena_strdup(arena, key), value);
+}
+
 void json_prepend_member(JsonNode *object, const char *key, JsonNode *value)
 {
 	assert(object->tag == JSON_OBJECT);
@@ -606,6 +937,8 @@ void json_remove_from_parent(JsonNode *node)
 	JsonNode *parent = node->parent;
 	
 	if (parent != NULL) {
+		if (parent->tag == JSON_OBJECT)
+			drop_index(parent);
 		if (node->prev != NULL)
 			node->prev->next = node->next;
 		else
@@ -615,7 +948,8 @@ void json_remove_from_parent(JsonNode *node)
 		else
 			parent->children.tail = node->prev;
 		
-		free(node->key);
+		if (!node->arena_)
+			free(node->key);
 		
 		node->parent = NULL;
 		node->prev = node->next = NULL;
@@ -623,15 +957,47 @@ void json_remove_from_parent(JsonNode *node)
 	}
 }
 
-static bool parse_value(const char **sp, JsonNode **out)
+JsonNode *json_copy(const JsonNode *node)
+{
+	const JsonNode *child;
+	JsonNode *ret;
+	
+	if (node == NULL)
+		return NULL;
+	
+	switch (node->tag) {
+		case JSON_BOOL:
+			return json_mkbool(node->bool_);
+		case JSON_STRING:
+			return json_mkstring(node->string_);
+		case JSON_NUMBER:
+			return json_mknumber(node->number_);
+		case JSON_ARRAY:
+		case JSON_OBJECT:
+			break;
+		default:
+			return json_mknull();
+	}
+	
+	ret = mknode(NULL, node->tag);
+	json_foreach(child, node) {
+		if (node->tag == JSON_OBJECT)
+			append_member(ret, json_strdup(child->key), json_copy(child));
+		else
+			append_node(ret, json_copy(child));
+	}
+	return ret;
+}
+
+static bool parse_value(ParseCtx *ctx, const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
 	
 	switch (*s) {
 		case 'n':
 			if (expect_literal(&s, "null")) {
-				if (out)
-					*out = json_mknull();
+				if (out && (*out = json_arena_mknull(ctx->arena)) == NULL)
+					return false;
 				*sp = s;
 				return true;
 			}
@@ -639,8 +1005,8 @@ static bool parse_value(const char **sp, JsonNode **out)
 		
 		case 'f':
 			if (expect_literal(&s, "false")) {
-				if (out)
-					*out = json_mkbool(false);
+				if (out && (*out = json_arena_mkbool(ctx->arena, false)) == NULL)
+					return false;
 				*sp = s;
 				return true;
 			}
@@ -648,8 +1014,8 @@ static bool parse_value(const char **sp, JsonNode **out)
 		
 		case 't':
 			if (expect_literal(&s, "true")) {
-				if (out)
-					*out = json_mkbool(true);
+				if (out && (*out = json_arena_mkbool(ctx->arena, true)) == NULL)
+					return false;
 				*sp = s;
 				return true;
 			}
@@ -657,9 +1023,9 @@ static bool parse_value(const char **sp, JsonNode **out)
 		
 		case '"': {
 			char *str;
-			if (parse_string(&s, out ? &str : NULL)) {
-				if (out)
-					*out = mkstring(str);
+			if (parse_string(ctx, &s, out ? &str : NULL)) {
+				if (out && (*out = mkstring(ctx->arena, str)) == NULL)
+					return false;
 				*sp = s;
 				return true;
 			}
@@ -667,14 +1033,14 @@ static bool parse_value(const char **sp, JsonNode **out)
 		}
 		
 		case '[':
-			if (parse_array(&s, out)) {
+			if (parse_array(ctx, &s, out)) {
 				*sp = s;
 				return true;
 			}
 			return false;
 		
 		case '{':
-			if (parse_object(&s, out)) {
+			if (parse_object(ctx, &s, out)) {
 				*sp = s;
 				return true;
 			}
@@ -683,8 +1049,8 @@ static bool parse_value(const char **sp, JsonNode **out)
 		default: {
 			double num;
 			if (parse_number(&s, out ? &num : NULL)) {
-				if (out)
-					*out = json_mknumber(num);
+				if (out && (*out = json_arena_mknumber(ctx->arena, num)) == NULL)
+					return false;
 				*sp = s;
 				return true;
 			}
@@ -693,12 +1059,14 @@ static bool parse_value(const char **sp, JsonNode **out)
 	}
 }
 
-static bool parse_array(const char **sp, JsonNode **out)
+static bool parse_array(ParseCtx *ctx, const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
-	JsonNode *ret = out ? json_mkarray() : NULL;
+	JsonNode *ret = out ? json_arena_mkarray(ctx->arena) : NULL;
 	JsonNode *element;
 	
+	if (out && ret == NULL)
+		return false;
 	if (*s++ != '[')
 		goto failure;
 	skip_space(&s);
@@ -709,7 +1077,7 @@ static bool parse_array(const char **sp, JsonNode **out)
 	}
 	
 	for (;;) {
-		if (!parse_value(&s, out ? &element : NULL))
+		if (!parse_value(ctx, &s, out ? &element : NULL))
 			goto failure;
 		skip_space(&s);
 		
@@ -737,13 +1105,15 @@ failure:
 	return false;
 }
 
-static bool parse_object(const char **sp, JsonNode **out)
+static bool parse_object(ParseCtx *ctx, const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
-	JsonNode *ret = out ? json_mkobject() : NULL;
+	JsonNode *ret = out ? json_arena_mkobject(ctx->arena) : NULL;
 	char *key;
 	JsonNode *value;
 	
+	if (out && ret == NULL)
+		return false;
 	if (*s++ != '{')
 		goto failure;
 	skip_space(&s);
@@ -754,7 +1124,7 @@ static bool parse_object(const char **sp, JsonNode **out)
 	}
 	
 	for (;;) {
-		if (!parse_string(&s, out ? &key : NULL))
+		if (!parse_string(ctx, &s, out ? &key : NULL))
 			goto failure;
 		skip_space(&s);
 		
@@ -762,7 +1132,7 @@ static bool parse_object(const char **sp, JsonNode **out)
 			goto failure_free_key;
 		skip_space(&s);
 		
-		if (!parse_value(&s, out ? &value : NULL))
+		if (!parse_value(ctx, &s, out ? &value : NULL))
 			goto failure_free_key;
 		skip_space(&s);
 		
@@ -781,39 +1151,97 @@ static bool parse_object(const char **sp, JsonNode **out)
 	
 success:
 	*sp = s;
-	if (out)
+	if (out) {
+#if !defined(NO_JSON_INDEX)
+		/* there is no way to the arena later */
+		if (ctx->arena != NULL)
+			ret->children.index = build_index(ctx->arena, ret);
+#endif
 		*out = ret;
+	}
 	return true;
 
 failure_free_key:
-	if (out)
+	if (out && ctx->arena == NULL)
 		free(key);
 failure:
 	json_delete(ret);
 	return false;
 }
 
-bool parse_string(const char **sp, char **out)
+/*
+ * Length of the string literal body starting at @s (after the quote),
+ * or -1 if there is no closing quote.
+ * The unescaped string is never longer than the literal.
+ */
+static int string_span(const char *s)
+{
+	const char *start = s;
+	
+	for (;;) {
+		s += json_scan_plain(s);
+		if (*s == '"')
+			break;
+		if (*s == 0)
+			return -1;
+		if (*s++ == '\\') {
+			if (*s == 0)
+				return -1;
+			s++;
+		}
+	}
+	return (int)(s - start);
+}
+
+static bool parse_string(ParseCtx *ctx, const char **sp, char **out)
 {
 	const char *s = *sp;
-    SB sb = {NULL, NULL, NULL};
 	char throwaway_buffer[4];
 		/* enough space for a UTF-8 character */
+	char *str = NULL;
 	char *b;
 	
 	if (*s++ != '"')
 		return false;
 	
-	if (out) {
-		sb_init(&sb);
-		sb_need(&sb, 4);
-		b = sb.cur;
+	if (out && ctx->insitu) {
+		/* Never longer than the literal: unescape it in place. */
+		str = (char*) s;
+		b = str;
+	} else if (out) {
+		/* The whole string is allocated at once. */
+		int span = string_span(s);
+		if (span < 0)
+			return false;
+		if (ctx->arena != NULL) {
+			str = (char*) arena_alloc(ctx->arena, (size_t)span + 1);
+		} else {
+			str = (char*) malloc((size_t)span + 1);
+			if (str == NULL)
+				out_of_memory();
+		}
+		if (str == NULL)
+			return false;
+		b = str;
 	} else {
 		b = throwaway_buffer;
 	}
 	
 	while (*s != '"') {
-		unsigned char c = (unsigned char) *s++;
+		unsigned char c;
+		int run = json_scan_plain(s);
+		
+		if (run > 0) {
+			/* Copy a run of plain ASCII at once. */
+			if (out) {
+				if (b != s)
+					memmove(b, s, (size_t)run);
+				b += run;
+			}
+			s += run;
+			continue;
+		}
+		c = (unsigned char) *s++;
 		
 		/* Parse next character, and write it to b. */
 		if (c == '\\') {
@@ -883,28 +1311,22 @@ bool parse_string(const char **sp, char **out)
 				*b++ = *s++;
 		}
 		
-		/*
-		 * Update sb to know about the new bytes,
-		 * and set up b to write another character.
-		 */
-		if (out) {
-			sb.cur = b;
-			sb_need(&sb, 4);
-			b = sb.cur;
-		} else {
+		/* Set up b to write another character. */
+		if (!out)
 			b = throwaway_buffer;
-		}
 	}
 	s++;
 	
-	if (out)
-		*out = sb_finish(&sb);
+	if (out) {
+		*b = 0;
+		*out = str;
+	}
 	*sp = s;
 	return true;
 
 failed:
-	if (out)
-		sb_free(&sb);
+	if (out && ctx->arena == NULL)
+		free(str);
 	return false;
 }
 
@@ -1123,7 +1545,20 @@ void emit_string(SB *out, const char *str)
 	
 	*b++ = '"';
 	while (*s != 0) {
-		unsigned char c = (unsigned char) *s++;
+		unsigned char c;
+		int run = json_scan_plain(s);
+		
+		if (run > 0) {
+			/* Write a run of plain ASCII at once. */
+			out->cur = b;
+			sb_need(out, run + 14);
+			b = out->cur;
+			memcpy(b, s, (size_t)run);
+			b += run;
+			s += run;
+			continue;
+		}
+		c = (unsigned char) *s++;
 		
 		/* Encode the next character, and write it to b. */
 		switch (c) {
@@ -1228,23 +1663,15 @@ void emit_string(SB *out, const char *str)
 static void emit_number(SB *out, double num)
 {
 	/*
-	 * This isn't exactly how JavaScript renders numbers,
-	 * but it should produce valid JSON for reasonable numbers
-	 * preserve precision well enough, and avoid some oddities
-	 * like 0.3 -> 0.299999999999999988898 .
+	 * The shortest text that reads back as the same number,
+	 * 0.3 stays 0.3 and 0.1 + 0.2 is 0.30000000000000004 .
 	 */
-	char buf[64];
-	double intg;
-	double fraction = modf(num, &intg);
-	if ( fraction > 0.0 || fraction < 0.0 )
-	    sprintf(buf, "%.16g", num);
-	else
-	    sprintf(buf, "%d", (int)num);
+	char buf[JSON_DTOA_SIZE];
 	
-	if (number_is_valid(buf))
-		sb_puts(out, buf);
-	else
+	if (json_dtoa(num, buf) < 0)
 		sb_puts(out, "null");
+	else
+		sb_puts(out, buf);
 }
 
 static bool tag_is_valid(unsigned int tag)
@@ -1252,11 +1679,6 @@ static bool tag_is_valid(unsigned int tag)
 	return (/* tag >= JSON_NULL && */ tag <= JSON_OBJECT);
 }
 
-static bool number_is_valid(const char *num)
-{
-	return (parse_number(&num, NULL) && *num == '\0');
-}
-
 static bool expect_literal(const char **sp, const char *str)
 {
 	const char *s = *sp;
@@ -0,0 +1,315 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/sax.h"
+#include <sys/mem.h>
+#include <stdlib.h>
+
+#if JSON_SAX_DEPTH > 32
+# error "JSON_SAX_DEPTH is limited by 32"
+#endif
+
+enum {
+  S_VALUE = 0,
+  S_ARRAY_FIRST,
+  S_OBJ_FIRST,
+  S_KEY,
+  S_COLON,
+  S_NEXT,
+  S_STRING,
+  S_ESC,
+  S_HEX,
+  S_NUMBER,
+  S_LITERAL,
+  S_DONE,
+  S_ERROR
+};
+
+#define is_space(c) ( (c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r' )
+#define is_digit(c) ( (c) >= '0' && (c) <= '9' )
+#define is_number_char(c) ( is_digit(c) || (c) == '-' || (c) == '+' || \
+                            (c) == '.' || (c) == 'e' || (c) == 'E' )
+#define top_is_object(p) ( ( (p)->stack >> ((p)->depth - 1) ) & 1 )
+
+void json_sax_init(json_sax_t *p, json_sax_cb_f cb, void *arg) {
+  memset(p, 0, sizeof(json_sax_t));
+  p->cb = cb;
+  p->arg = arg;
+  p->state = S_VALUE;
+}
+
+static int emit(json_sax_t *p, json_sax_event_t ev) {
+  int ret = p->cb(p, ev, p->arg);
+  p->truncated = 0;
+  if ( ret < 0 ) {
+    p->state = S_ERROR;
+    return -1;
+  }
+  return 0;
+}
+
+static int value_end(json_sax_t *p) {
+  p->state = p->depth ? S_NEXT : S_DONE;
+  return 0;
+}
+
+static int push(json_sax_t *p, int object) {
+  if ( p->depth >= JSON_SAX_DEPTH ) return -1;
+  if ( emit(p, object ? json_sax_object_start : json_sax_array_start) < 0 ) return -1;
+  if ( object ) p->stack |= ( 1u << p->depth );
+  else p->stack &= ~( 1u << p->depth );
+  p->depth++;
+  p->key[0] = '\0';
+  p->key_len = 0;
+  p->state = object ? S_OBJ_FIRST : S_ARRAY_FIRST;
+  return 0;
+}
+
+static int pop(json_sax_t *p, int object) {
+  if ( !p->depth || (int)top_is_object(p) != object ) return -1;
+  p->depth--;
+  if ( emit(p, object ? json_sax_object_end : json_sax_array_end) < 0 ) return -1;
+  return value_end(p);
+}
+
+static void put_bytes(json_sax_t *p, const char *s, int n) {
+  char *buf = p->is_key ? p->key : p->value;
+  uint16_t *len = p->is_key ? &p->key_len : &p->len;
+  int size = p->is_key ? JSON_SAX_KEY_SIZE : JSON_SAX_VALUE_SIZE;
+  // a multibyte char is not cut in the middle
+  if ( *len + n >= size ) {
+    p->truncated = 1;
+    return;
+  }
+  memcpy(buf + *len, s, (size_t)n);
+  *len += n;
+  buf[*len] = '\0';
+}
+
+static int put_code(json_sax_t *p, uint32_t cp) {
+  char b[4];
+  int n;
+  if ( !cp ) return -1;
+  if ( cp < 0x80 ) {
+    b[0] = (char)cp;
+    n = 1;
+  } else if ( cp < 0x800 ) {
+    b[0] = (char)( 0xC0 | ( cp >> 6 ) );
+    b[1] = (char)( 0x80 | ( cp & 0x3F ) );
+    n = 2;
+  } else if ( cp < 0x10000 ) {
+    b[0] = (char)( 0xE0 | ( cp >> 12 ) );
+    b[1] = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+    b[2] = (char)( 0x80 | ( cp & 0x3F ) );
+    n = 3;
+  } else {
+    b[0] = (char)( 0xF0 | ( cp >> 18 ) );
+    b[1] = (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+    b[2] = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+    b[3] = (char)( 0x80 | ( cp & 0x3F ) );
+    n = 4;
+  }
+  put_bytes(p, b, n);
+  return 0;
+}
+
+static int hex_end(json_sax_t *p) {
+  uint32_t cp = p->hex;
+  if ( p->high ) {
+    if ( cp < 0xDC00 || cp > 0xDFFF ) return -1;
+    cp = 0x10000 + ( ( (uint32_t)p->high - 0xD800 ) << 10 ) + ( cp - 0xDC00 );
+    p->high = 0;
+  } else if ( cp >= 0xD800 && cp <= 0xDBFF ) {
+    // wait for the second half
+    p->high = (uint16_t)cp;
+    return 0;
+  } else if ( cp >= 0xDC00 && cp <= 0xDFFF ) {
+    return -1;
+  }
+  return put_code(p, cp);
+}
+
+static int string_end(json_sax_t *p) {
+  if ( p->is_key ) {
+    p->state = S_COLON;
+    return 0;
+  }
+  if ( emit(p, json_sax_string) < 0 ) return -1;
+  return value_end(p);
+}
+
+static int number_end(json_sax_t *p) {
+  char *end = NULL;
+  if ( p->value[0] != '-' && !is_digit(p->value[0]) ) return -1;
+  p->number = strtod(p->value, &end);
+  if ( end != p->value + p->len ) return -1;
+  if ( emit(p, json_sax_number) < 0 ) return -1;
+  return value_end(p);
+}
+
+static int value_start(json_sax_t *p, char c) {
+  p->len = 0;
+  p->value[0] = '\0';
+  switch ( c ) {
+    case '{': return push(p, 1);
+    case '[': return push(p, 0);
+    case '"':
+      p->is_key = 0;
+      p->state = S_STRING;
+      return 0;
+    case 't': p->lit = "true"; break;
+    case 'f': p->lit = "false"; break;
+    case 'n': p->lit = "null"; break;
+    default:
+      if ( c != '-' && !is_digit(c) ) return -1;
+      p->value[p->len++] = c;
+      p->value[p->len] = '\0';
+      p->state = S_NUMBER;
+      return 0;
+  }
+  p->lit_pos = 1;
+  p->state = S_LITERAL;
+  return 0;
+}
+
+static int key_start(json_sax_t *p) {
+  p->key_len = 0;
+  p->key[0] = '\0';
+  p->is_key = 1;
+  p->state = S_STRING;
+  return 0;
+}
+
+static int step(json_sax_t *p, char c) {
+  switch ( p->state ) {
+    case S_VALUE:
+      if ( is_space(c) ) return 0;
+      return value_start(p, c);
+    case S_ARRAY_FIRST:
+      if ( is_space(c) ) return 0;
+      if ( c == ']' ) return pop(p, 0);
+      return value_start(p, c);
+    case S_OBJ_FIRST:
+      if ( is_space(c) ) return 0;
+      if ( c == '}' ) return pop(p, 1);
+      if ( c == '"' ) return key_start(p);
+      return -1;
+    case S_KEY:
+      if ( is_space(c) ) return 0;
+      if ( c == '"' ) return key_start(p);
+      return -1;
+    case S_COLON:
+      if ( is_space(c) ) return 0;
+      if ( c != ':' ) return -1;
+      p->state = S_VALUE;
+      return 0;
+    case S_NEXT:
+      if ( is_space(c) ) return 0;
+      if ( c == '}' ) return pop(p, 1);
+      if ( c == ']' ) return pop(p, 0);
+      if ( c != ',' ) return -1;
+      if ( top_is_object(p) ) {
+        p->state = S_KEY;
+      } else {
+        p->key[0] = '\0';
+        p->key_len = 0;
+        p->state = S_VALUE;
+      }
+      return 0;
+    case S_STRING:
+      if ( p->high && c != '\\' ) return -1;
+      if ( c == '"' ) return string_end(p);
+      if ( c == '\\' ) {
+        p->state = S_ESC;
+        return 0;
+      }
+      if ( (unsigned char)c < 0x20 ) return -1;
+      put_bytes(p, &c, 1);
+      return 0;
+    case S_ESC:
+      if ( p->high && c != 'u' ) return -1;
+      p->state = S_STRING;
+      switch ( c ) {
+        case '"':
+        case '\\':
+        case '/': break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'u':
+          p->hex = 0;
+          p->hex_n = 0;
+          p->state = S_HEX;
+          return 0;
+        default: return -1;
+      }
+      put_bytes(p, &c, 1);
+      return 0;
+    case S_HEX:
+      p->hex <<= 4;
+      if ( is_digit(c) ) p->hex |= (uint16_t)( c - '0' );
+      else if ( c >= 'a' && c <= 'f' ) p->hex |= (uint16_t)( c - 'a' + 10 );
+      else if ( c >= 'A' && c <= 'F' ) p->hex |= (uint16_t)( c - 'A' + 10 );
+      else return -1;
+      if ( ++p->hex_n < 4 ) return 0;
+      p->state = S_STRING;
+      return hex_end(p);
+    case S_LITERAL:
+      if ( c != p->lit[p->lit_pos] ) return -1;
+      if ( p->lit[++p->lit_pos] ) return 0;
+      p->bool_ = ( p->lit[0] == 't' );
+      if ( emit(p, p->lit[0] == 'n' ? json_sax_null : json_sax_bool) < 0 ) return -1;
+      return value_end(p);
+    case S_DONE:
+      if ( is_space(c) ) return 0;
+      return -1;
+    default:
+      return -1;
+  }
+}
+
+int json_sax_feed(json_sax_t *p, const char *buf, int len) {
+  int i = 0;
+  while ( i < len ) {
+    char c = buf[i];
+    if ( p->state == S_ERROR ) return -1;
+    if ( p->state == S_NUMBER ) {
+      if ( is_number_char(c) ) {
+        if ( p->len + 1 >= JSON_SAX_VALUE_SIZE ) {
+          p->state = S_ERROR;
+          return -1;
+        }
+        p->value[p->len++] = c;
+        p->value[p->len] = '\0';
+        i++;
+        continue;
+      }
+      // the number is over, this char is the next token
+      if ( number_end(p) < 0 ) {
+        p->state = S_ERROR;
+        return -1;
+      }
+      continue;
+    }
+    if ( step(p, c) < 0 ) {
+      p->state = S_ERROR;
+      return -1;
+    }
+    i++;
+  }
+  return p->state == S_ERROR ? -1 : 0;
+}
+
+int json_sax_finish(json_sax_t *p) {
+  if ( p->state == S_NUMBER && !p->depth ) {
+    if ( number_end(p) < 0 ) p->state = S_ERROR;
+  }
+  return p->state == S_DONE ? 0 : -1;
+}
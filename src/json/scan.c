@@ -0,0 +1,102 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/scan.h"
+#include <sys/mem.h>
+
+#if defined(JSON_SCAN_SSE2)
+# include <emmintrin.h>
+# define SCAN_BLOCK 16
+#elif defined(JSON_SCAN_NEON)
+# include <arm_neon.h>
+# define SCAN_BLOCK 16
+#else
+# define SCAN_BLOCK sizeof(size_t)
+#endif
+
+// The aligned block load may cover the bytes after the null terminator.
+// It never crosses a page but the address sanitizer doesn't know it.
+#if defined(__SANITIZE_ADDRESS__)
+# define WHOLE_BLOCK_READ __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define WHOLE_BLOCK_READ __attribute__((no_sanitize_address))
+# endif
+#endif
+#if !defined(WHOLE_BLOCK_READ)
+# define WHOLE_BLOCK_READ
+#endif
+
+static int special(unsigned char c, int plain) {
+  if ( c < 0x20 || c > 0x7F ) return 1;
+  return plain && ( c == '"' || c == '\\' );
+}
+
+#if defined(JSON_SCAN_SSE2)
+WHOLE_BLOCK_READ
+static int dirty_block(const char *p, int plain) {
+  __m128i v = _mm_load_si128((const __m128i *)p);
+  // the signed compare catches both the control chars and 0x80..0xFF
+  __m128i m = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+  if ( plain ) {
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+  }
+  return _mm_movemask_epi8(m);
+}
+#elif defined(JSON_SCAN_NEON)
+WHOLE_BLOCK_READ
+static int dirty_block(const char *p, int plain) {
+  uint8x16_t v = vld1q_u8((const uint8_t *)p);
+  uint8x16_t m = vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)),
+                          vcgtq_u8(v, vdupq_n_u8(0x7F)));
+  if ( plain ) {
+    m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('"')));
+    m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('\\')));
+  }
+  return vmaxvq_u8(m) != 0;
+}
+#else
+# define ONES           ( (size_t)-1 / 0xFF )
+# define HIGHS          ( ONES * 0x80 )
+// any byte less than n (n <= 0x80)
+# define has_less(x, n) ( ( (x) - ONES * (n) ) & ~(x) & HIGHS )
+# define has_byte(x, n) has_less( (x) ^ ( ONES * (n) ), 1 )
+# if defined(__GNUC__)
+typedef size_t __attribute__((__may_alias__)) word_t;
+# else
+typedef size_t word_t;
+# endif
+WHOLE_BLOCK_READ
+static int dirty_block(const char *p, int plain) {
+  size_t x = *(const word_t *)p;
+  if ( ( x & HIGHS ) || has_less(x, 0x20) ) return 1;
+  return plain && ( has_byte(x, '"') || has_byte(x, '\\') );
+}
+#endif
+
+static int scan(const char *s, int plain) {
+  const char *p = s;
+  // one by one up to the aligned block
+  while ( (size_t)p & ( SCAN_BLOCK - 1 ) ) {
+    if ( special((unsigned char)*p, plain) ) return (int)(p - s);
+    p++;
+  }
+  while ( !dirty_block(p, plain) ) p += SCAN_BLOCK;
+  // the null terminator stops it within the block at least
+  while ( !special((unsigned char)*p, plain) ) p++;
+  return (int)(p - s);
+}
+
+int json_scan_ascii(const char *s) {
+  return scan(s, 0);
+}
+
+int json_scan_plain(const char *s) {
+  return scan(s, 1);
+}
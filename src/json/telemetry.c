@@ -0,0 +1,18 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/telemetry.h"
+#include <sys/mem.h>
+
+int __attribute__((weak)) telemetry_serialize_into(arrow_device_t *device, void *data, char *buf, int size) {
+  SSP_PARAMETER_NOT_USED(device);
+  SSP_PARAMETER_NOT_USED(data);
+  SSP_PARAMETER_NOT_USED(buf);
+  SSP_PARAMETER_NOT_USED(size);
+  return -1;
+}
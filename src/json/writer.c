@@ -0,0 +1,238 @@
+/* Copyright (c) 2017 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/writer.h"
+#include <json/dtoa.h>
+#include <sys/mem.h>
+#include <stdio.h>
+
+#if JSON_WRITER_DEPTH > 32
+# error "JSON_WRITER_DEPTH is limited by 32"
+#endif
+
+#define level_bit(w)  ( 1u << ((w)->depth - 1) )
+
+void json_writer_init(json_writer_t *w, char *buf, int size) {
+  memset(w, 0, sizeof(json_writer_t));
+  w->buf = buf;
+  w->size = size;
+}
+
+void json_writer_init_flush(json_writer_t *w, char *buf, int size,
+                            json_writer_flush_f flush, void *arg) {
+  json_writer_init(w, buf, size);
+  w->flush = flush;
+  w->arg = arg;
+}
+
+static int fail(json_writer_t *w) {
+  w->err = -1;
+  return -1;
+}
+
+static int put(json_writer_t *w, const char *s, int n) {
+  if ( w->err ) return -1;
+  w->total += n;
+  if ( !w->buf ) return 0;
+  if ( !w->flush ) {
+    // keep a byte for the null
+    if ( w->len + n >= w->size ) return fail(w);
+    memcpy(w->buf + w->len, s, (size_t)n);
+    w->len += n;
+    return 0;
+  }
+  while ( n > 0 ) {
+    int chunk = w->size - w->len;
+    if ( chunk > n ) chunk = n;
+    memcpy(w->buf + w->len, s, (size_t)chunk);
+    w->len += chunk;
+    s += chunk;
+    n -= chunk;
+    if ( w->len == w->size ) {
+      if ( w->flush(w->arg, w->buf, w->len) < 0 ) return fail(w);
+      w->len = 0;
+    }
+  }
+  return 0;
+}
+
+// the comma and the checks before any value
+static int value_start(json_writer_t *w) {
+  if ( w->err ) return -1;
+  if ( !w->depth ) {
+    // only one value at the top
+    return w->total ? fail(w) : 0;
+  }
+  if ( w->object & level_bit(w) ) {
+    if ( !w->key ) return fail(w);
+    w->key = 0;
+    return 0;
+  }
+  if ( w->first & level_bit(w) ) {
+    w->first &= ~level_bit(w);
+    return 0;
+  }
+  return put(w, ",", 1);
+}
+
+static int begin(json_writer_t *w, int object) {
+  if ( value_start(w) < 0 ) return -1;
+  if ( w->depth >= JSON_WRITER_DEPTH ) return fail(w);
+  if ( put(w, object ? "{" : "[", 1) < 0 ) return -1;
+  w->depth++;
+  if ( object ) w->object |= level_bit(w);
+  else w->object &= ~level_bit(w);
+  w->first |= level_bit(w);
+  return 0;
+}
+
+static int end(json_writer_t *w, int object) {
+  if ( w->err ) return -1;
+  if ( !w->depth || w->key ) return fail(w);
+  if ( !( w->object & level_bit(w) ) != !object ) return fail(w);
+  w->depth--;
+  return put(w, object ? "}" : "]", 1);
+}
+
+int json_write_begin_object(json_writer_t *w) {
+  return begin(w, 1);
+}
+
+int json_write_end_object(json_writer_t *w) {
+  return end(w, 1);
+}
+
+int json_write_begin_array(json_writer_t *w) {
+  return begin(w, 0);
+}
+
+int json_write_end_array(json_writer_t *w) {
+  return end(w, 0);
+}
+
+static int put_string(json_writer_t *w, const char *s) {
+  const char *run = s;
+  char esc[8];
+  if ( put(w, "\"", 1) < 0 ) return -1;
+  for ( ; *s; s++ ) {
+    unsigned char c = (unsigned char)*s;
+    int n = 2;
+    if ( c >= 0x20 && c != '"' && c != '\\' ) continue;
+    // the plain chars are written at once
+    if ( s > run && put(w, run, (int)(s - run)) < 0 ) return -1;
+    run = s + 1;
+    esc[0] = '\\';
+    switch ( c ) {
+      case '"':  esc[1] = '"'; break;
+      case '\\': esc[1] = '\\'; break;
+      case '\b': esc[1] = 'b'; break;
+      case '\f': esc[1] = 'f'; break;
+      case '\n': esc[1] = 'n'; break;
+      case '\r': esc[1] = 'r'; break;
+      case '\t': esc[1] = 't'; break;
+      default:
+        n = snprintf(esc, sizeof(esc), "\\u%04x", c);
+        break;
+    }
+    if ( put(w, esc, n) < 0 ) return -1;
+  }
+  if ( s > run && put(w, run, (int)(s - run)) < 0 ) return -1;
+  return put(w, "\"", 1);
+}
+
+int json_write_key(json_writer_t *w, const char *key) {
+  if ( w->err ) return -1;
+  if ( !w->depth || !( w->object & level_bit(w) ) || w->key || !key ) return fail(w);
+  if ( w->first & level_bit(w) ) w->first &= ~level_bit(w);
+  else if ( put(w, ",", 1) < 0 ) return -1;
+  if ( put_string(w, key) < 0 || put(w, ":", 1) < 0 ) return -1;
+  w->key = 1;
+  return 0;
+}
+
+int json_write_string(json_writer_t *w, const char *s) {
+  if ( !s ) return json_write_null(w);
+  if ( value_start(w) < 0 ) return -1;
+  return put_string(w, s);
+}
+
+int json_write_number(json_writer_t *w, double n) {
+  char buf[JSON_DTOA_SIZE];
+  int len;
+  if ( value_start(w) < 0 ) return -1;
+  // the same text as json_encode
+  len = json_dtoa(n, buf);
+  if ( len < 0 ) return put(w, "null", 4);
+  return put(w, buf, len);
+}
+
+int json_write_bool(json_writer_t *w, int b) {
+  if ( value_start(w) < 0 ) return -1;
+  return b ? put(w, "true", 4) : put(w, "false", 5);
+}
+
+int json_write_null(json_writer_t *w) {
+  if ( value_start(w) < 0 ) return -1;
+  return put(w, "null", 4);
+}
+
+int json_write_node(json_writer_t *w, const JsonNode *node) {
+  const JsonNode *child;
+  if ( !node ) return json_write_null(w);
+  switch ( node->tag ) {
+    case JSON_BOOL:   return json_write_bool(w, node->bool_);
+    case JSON_STRING: return json_write_string(w, node->string_);
+    case JSON_NUMBER: return json_write_number(w, node->number_);
+    case JSON_ARRAY:
+      if ( json_write_begin_array(w) < 0 ) return -1;
+      for ( child = node->children.head; child; child = child->next )
+        if ( json_write_node(w, child) < 0 ) return -1;
+      return json_write_end_array(w);
+    case JSON_OBJECT:
+      if ( json_write_begin_object(w) < 0 ) return -1;
+      for ( child = node->children.head; child; child = child->next ) {
+        if ( json_write_key(w, child->key) < 0 ) return -1;
+        if ( json_write_node(w, child) < 0 ) return -1;
+      }
+      return json_write_end_object(w);
+    default:
+      return json_write_null(w);
+  }
+}
+
+int json_writer_finish(json_writer_t *w) {
+  if ( w->err || w->depth || !w->total ) return -1;
+  if ( w->buf ) {
+    if ( w->flush ) {
+      if ( w->len && w->flush(w->arg, w->buf, w->len) < 0 ) return fail(w);
+      w->len = 0;
+    } else {
+      w->buf[w->len] = '\0';
+    }
+  }
+  return w->total;
+}
+
+char *json_write_alloc(json_write_f write, void *arg) {
+  json_writer_t w;
+  char *buf;
+  int size;
+  json_writer_init(&w, NULL, 0);
+  write(&w, arg);
+  size = json_writer_finish(&w);
+  if ( size < 0 ) return NULL;
+  buf = (char *)malloc((size_t)size + 1);
+  if ( !buf ) return NULL;
+  json_writer_init(&w, buf, size + 1);
+  write(&w, arg);
+  if ( json_writer_finish(&w) != size ) {
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
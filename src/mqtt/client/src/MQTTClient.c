@@ -24,18 +24,45 @@ static void NewMessageData(MessageData* md, MQTTString* aTopicName, MQTTMessage*
 }
 
 
+/* the in-flight slot of the packet id, id 0 finds a free slot */
+static int inflightFind(MQTTClient* c, unsigned short id)
+{
+    int i;
+    for (i = 0; i < c->inflight_size; ++i)
+        if (c->inflight[i].id == id)
+            return i;
+    return -1;
+}
+
+
+static void inflightDone(MQTTClient* c, int i, int rc)
+{
+    MQTTInflight m = c->inflight[i];
+    /* the slot is free for the done callback already */
+    c->inflight[i].id = 0;
+    c->inflight[i].packet = NULL;
+    if (m.packet)
+        free(m.packet);
+    if (m.done)
+        m.done(m.arg, m.id, rc);
+}
+
+
 static unsigned short getNextPacketId(MQTTClient *c) {
-    return c->next_packetid = (unsigned short int)((c->next_packetid == MAX_PACKET_ID) ? 1 : c->next_packetid + 1);
+    do
+        c->next_packetid = (unsigned short int)((c->next_packetid == MAX_PACKET_ID) ? 1 : c->next_packetid + 1);
+    while (inflightFind(c, c->next_packetid) >= 0); /* still waiting for its ack */
+    return c->next_packetid;
 }
 
-static int sendPacket(MQTTClient* c, int length, TimerInterval* timer)
+static int sendBuffer(MQTTClient* c, unsigned char* buf, int length, TimerInterval* timer)
 {
     int rc = FAILURE,
         sent = 0;
 
     while (sent < length && !TimerIsExpired(timer))
     {
-        rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer));
+        rc = c->ipstack->mqttwrite(c->ipstack, &buf[sent], length - sent, TimerLeftMS(timer));
         if (rc < 0)  // there was an error writing the data
             break;
         sent += rc;
@@ -51,6 +78,12 @@ static int sendPacket(MQTTClient* c, int length, TimerInterval* timer)
 }
 
 
+static int sendPacket(MQTTClient* c, int length, TimerInterval* timer)
+{
+    return sendBuffer(c, c->buf, length, timer);
+}
+
+
 void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeout_ms,
     unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size)
 {
@@ -68,6 +101,8 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
     c->ping_outstanding = 0;
     c->defaultMessageHandler = NULL;
   c->next_packetid = 1;
+    c->inflight = NULL;
+    c->inflight_size = 0;
     TimerInit(&c->ping_timer);
 #if defined(MQTT_TASK)
   MutexInit(&c->mutex);
@@ -89,12 +124,16 @@ static int decodePacket(MQTTClient* c, int* value, int timeout)
 
         if (++len > MAX_NO_OF_REMAINING_LENGTH_BYTES)
         {
-            rc = MQTTPACKET_READ_ERROR; /* bad data */
+            len = MQTTPACKET_READ_ERROR; /* bad data */
             goto exit;
         }
+        /* the network layer serves these bytes from its receive buffer */
         rc = c->ipstack->mqttread(c->ipstack, &i, 1, timeout);
         if (rc != 1)
+        {
+            len = MQTTPACKET_READ_ERROR;
             goto exit;
+        }
         *value += (i & 127) * multiplier;
         multiplier *= 128;
     } while ((i & 128) != 0);
@@ -116,8 +155,24 @@ static int readPacket(MQTTClient* c, TimerInterval* timer)
 
     len = 1;
     /* 2. read the remaining length.  This is variable in itself */
-    decodePacket(c, &rem_len, TimerLeftMS(timer));
+    if (decodePacket(c, &rem_len, TimerLeftMS(timer)) < 0)
+        goto exit;
     len += MQTTPacket_encode(c->readbuf + 1, rem_len); /* put the original remaining length back into the buffer */
+    if (rem_len > (int)c->readbuf_size - len)
+    {
+        /* the packet doesn't fit the read buffer: skip its body to stay in sync */
+        while (rem_len > 0)
+        {
+            int part = rem_len < (int)c->readbuf_size ? rem_len : (int)c->readbuf_size;
+            if (c->ipstack->mqttread(c->ipstack, c->readbuf, part, TimerLeftMS(timer)) != part)
+            {
+                c->isconnected = 0; /* the stream position is lost */
+                break;
+            }
+            rem_len -= part;
+        }
+        goto exit;
+    }
 
     /* 3. read the rest of the buffer using a callback to supply the rest of the data */
     if (rem_len > 0 && (c->ipstack->mqttread(c->ipstack, c->readbuf + len, rem_len, TimerLeftMS(timer)) != rem_len))
@@ -231,9 +286,20 @@ static int cycle(MQTTClient* c, TimerInterval* timer)
     switch (packet_type)
     {
         case CONNACK:
-        case PUBACK:
         case SUBACK:
             break;
+        case PUBACK:
+        case PUBCOMP:
+        {
+            unsigned short mypacketid;
+            unsigned char dup, type;
+            int i;
+            /* a pipelined publish is complete */
+            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, (int)c->readbuf_size) == 1 &&
+                    mypacketid != 0 && (i = inflightFind(c, mypacketid)) >= 0)
+                inflightDone(c, i, MQTT_SUCCESS);
+            break;
+        }
         case PUBLISH:
         {
             MQTTString topicName;
@@ -264,18 +330,24 @@ static int cycle(MQTTClient* c, TimerInterval* timer)
         {
             unsigned short mypacketid;
             unsigned char dup, type;
+            int i;
             if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, (int)c->readbuf_size) != 1)
                 rc = FAILURE;
             else if ((len = MQTTSerialize_ack(c->buf, (int)c->buf_size, PUBREL, 0, mypacketid)) <= 0)
                 rc = FAILURE;
             else if ((rc = sendPacket(c, len, timer)) != MQTT_SUCCESS) // send the PUBREL packet
                 rc = FAILURE; // there was a problem
+            else if (mypacketid != 0 && (i = inflightFind(c, mypacketid)) >= 0)
+            {
+                /* the PUBLISH copy isn't needed anymore, only PUBREL is sent again */
+                c->inflight[i].released = 1;
+                free(c->inflight[i].packet);
+                c->inflight[i].packet = NULL;
+            }
             if (rc == FAILURE)
                 goto exit; // there was a problem
             break;
         }
-        case PUBCOMP:
-            break;
         case PINGRESP:
             c->ping_outstanding = 0;
             break;
@@ -353,6 +425,53 @@ static int waitfor(MQTTClient* c, int packet_type, TimerInterval* timer)
 }
 
 
+/* the acks of the pipelined publishes may come first */
+static int waitforAck(MQTTClient* c, int packet_type, unsigned short id, TimerInterval* timer)
+{
+    while (waitfor(c, packet_type, timer) == packet_type)
+    {
+        unsigned short mypacketid;
+        unsigned char dup, type;
+        if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, (int)c->readbuf_size) != 1)
+            return FAILURE;
+        if (mypacketid == id)
+            return MQTT_SUCCESS;
+    }
+    return FAILURE;
+}
+
+
+/* send the messages the last connection didn't complete */
+static int inflightResend(MQTTClient* c, TimerInterval* timer)
+{
+    int i, len;
+    int rc = MQTT_SUCCESS;
+
+    for (i = 0; i < c->inflight_size && rc == MQTT_SUCCESS; ++i)
+    {
+        MQTTInflight* m = &c->inflight[i];
+        if (m->id == 0)
+            continue;
+        if (m->released)
+        {
+            if ((len = MQTTSerialize_ack(c->buf, (int)c->buf_size, PUBREL, 0, m->id)) <= 0)
+                rc = FAILURE;
+            else
+                rc = sendPacket(c, len, timer);
+        }
+        else
+        {
+            MQTTHeader header = {0};
+            header.byte = m->packet[0];
+            header.bits.dup = 1;
+            m->packet[0] = header.byte;
+            rc = sendBuffer(c, m->packet, m->len, timer);
+        }
+    }
+    return rc;
+}
+
+
 int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
 {
     TimerInterval connect_timer;
@@ -395,7 +514,12 @@ int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
 
 exit:
     if (rc == MQTT_SUCCESS)
+    {
         c->isconnected = 1;
+        TimerCountdownMS(&connect_timer, c->command_timeout_ms);
+        /* the rest stays in the table for the next connection */
+        inflightResend(c, &connect_timer);
+    }
 
 #if defined(MQTT_TASK)
   MutexUnlock(&c->mutex);
@@ -531,28 +655,116 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
     }
 
     if (message->qos == QOS1)
+        rc = waitforAck(c, PUBACK, message->id, &timer);
+    else if (message->qos == QOS2)
+        rc = waitforAck(c, PUBCOMP, message->id, &timer);
+
+exit:
+#if defined(MQTT_TASK)
+  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
+void MQTTSetInflight(MQTTClient* c, MQTTInflight* table, int size)
+{
+    c->inflight = table;
+    c->inflight_size = table ? size : 0;
+}
+
+
+int MQTTInflightCount(MQTTClient* c)
+{
+    int i, count = 0;
+    for (i = 0; i < c->inflight_size; ++i)
+        if (c->inflight[i].id != 0)
+            count++;
+    return count;
+}
+
+
+void MQTTInflightAbort(MQTTClient* c)
+{
+    int i;
+    for (i = 0; i < c->inflight_size; ++i)
+        if (c->inflight[i].id != 0)
+            inflightDone(c, i, FAILURE);
+}
+
+
+int MQTTPublishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message, publishDone done, void* arg)
+{
+    int rc = FAILURE;
+    TimerInterval timer;
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = (char *)topicName;
+    int len = 0;
+    int i = -1;
+    unsigned char* packet = NULL;
+
+#if defined(MQTT_TASK)
+  MutexLock(&c->mutex);
+#endif
+  if (!c->isconnected) {
+    goto exit;
+  }
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    if ((message->qos == QOS1 || message->qos == QOS2) && c->inflight_size > 0)
     {
-        if (waitfor(c, PUBACK, &timer) == PUBACK)
+        /* the window is full: read the acks until a slot is free */
+        while ((i = inflightFind(c, 0)) < 0)
         {
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, (int)c->readbuf_size) != 1)
-                rc = FAILURE;
+            if (TimerIsExpired(&timer))
+                goto exit;
+            cycle(c, &timer);
         }
-        else
-            rc = FAILURE;
     }
-    else if (message->qos == QOS2)
+    if (message->qos == QOS1 || message->qos == QOS2)
+        message->id = getNextPacketId(c);
+
+    len = MQTTSerialize_publish(c->buf, (int)c->buf_size, 0, message->qos, message->retained, message->id,
+              topic, (unsigned char*)message->payload, (int)message->payloadlen);
+    if (len <= 0)
+        goto exit;
+    if (i >= 0)
     {
-        if (waitfor(c, PUBCOMP, &timer) == PUBCOMP)
-        {
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, (int)c->readbuf_size) != 1)
-                rc = FAILURE;
-        }
-        else
-            rc = FAILURE;
+        /* the send buffer is reused, the copy is kept until the ack */
+        packet = (unsigned char*)malloc((size_t)len);
+        if (packet == NULL)
+            goto exit;
+        memcpy(packet, c->buf, (size_t)len);
+    }
+    if ((rc = sendPacket(c, len, &timer)) != MQTT_SUCCESS)
+    {
+        if (packet)
+            free(packet);
+        goto exit;
+    }
+
+    if (i >= 0)
+    {
+        MQTTInflight* m = &c->inflight[i];
+        m->id = message->id;
+        m->qos = (unsigned char)message->qos;
+        m->released = 0;
+        m->packet = packet;
+        m->len = len;
+        m->done = done;
+        m->arg = arg;
+    }
+    else
+    {
+        /* QoS 0 is complete when it's sent, no table - wait as MQTTPublish does */
+        if (message->qos == QOS1)
+            rc = waitforAck(c, PUBACK, message->id, &timer);
+        else if (message->qos == QOS2)
+            rc = waitforAck(c, PUBCOMP, message->id, &timer);
+        if (rc == MQTT_SUCCESS && done)
+            done(arg, message->id, rc);
     }
 
 exit:
@@ -1,6 +1,7 @@
 #include "mqtt/client/network.h"
 
 #include <bsd/socket.h>
+#include <bsd/connect.h>
 #include <debug.h>
 #include <bsd/inet.h>
 #include <sys/mem.h>
@@ -9,26 +10,72 @@
 # include <errno.h>
 #endif
 
-static int _read(Network* n, unsigned char* buffer, int len, int timeout_ms) {
-    struct timeval interval = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
-    if ((int)interval.tv_sec < 0 || (interval.tv_sec == 0 && interval.tv_usec <= 0)) {
-        interval.tv_sec = 0;
-        interval.tv_usec = 100;
-    }
+// The callers pass the time left to their deadline, so the socket timeout
+// is rounded down to a power of two and set only when that changes.
+// A read that times out early waits again for the rest.
+static int timeout_bucket(int timeout_ms) {
+    int b = 1;
+    if (timeout_ms <= 0) return 0;
+    while (b <= timeout_ms / 2) b <<= 1;
+    return b;
+}
 
+static void set_timeout(Network* n, int timeout_ms) {
+    if (timeout_ms < 0) timeout_ms = 0;
+    if (n->timeout_ms == timeout_ms) return;
+    struct timeval interval = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    if (!timeout_ms) interval.tv_usec = 100;
     setsockopt(n->my_socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&interval, sizeof(struct timeval));
+    n->timeout_ms = timeout_ms;
+}
 
+static int sock_recv(Network* n, unsigned char* buffer, int len) {
+#if defined(MQTT_CIPHER)
+    return ssl_recv(n->my_socket, (char*)buffer, (uint16_t)len);
+#else
+    return recv(n->my_socket, (char*)buffer, (uint16_t)len, 0);
+#endif
+}
+
+static int _read(Network* n, unsigned char* buffer, int len, int timeout_ms) {
     int bytes = 0;
+#if !defined(NO_MQTT_RECV_BUF)
+    // what is left from the last socket read goes first
+    int have = n->rx_len - n->rx_pos;
+    if (have > 0) {
+        if (have > len) have = len;
+        memcpy(buffer, n->rx + n->rx_pos, (size_t)have);
+        n->rx_pos += have;
+        bytes = have;
+        if (bytes == len) return bytes;
+    }
+#endif
+    TimerInterval timer;
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, timeout_ms > 0 ? (unsigned int)timeout_ms : 0);
     while (bytes < len) {
         int rc = 0;
-//    	if (rc) DBG("mqtt recv ---%d", timeout_ms);
-#if defined(MQTT_CIPHER)
-    	rc = ssl_recv(n->my_socket, (char*)(buffer + bytes), (uint16_t)(len - bytes));
-#else
-    	rc = recv(n->my_socket, (char*)(buffer + bytes), (uint16_t)(len - bytes), 0);
+        int want = len - bytes;
+        int left = TimerLeftMS(&timer);
+        set_timeout(n, timeout_bucket(left));
+#if !defined(NO_MQTT_RECV_BUF)
+        if (want < MQTT_RECV_BUF_LEN) {
+            // take all that is ready, the rest stays for the next reads
+            rc = sock_recv(n, n->rx, MQTT_RECV_BUF_LEN);
+            if (rc > want) {
+                n->rx_pos = want;
+                n->rx_len = rc;
+                rc = want;
+            }
+            if (rc > 0) memcpy(buffer + bytes, n->rx, (size_t)rc);
+        } else
 #endif
-//      if (rc) DBG("mqtt recv %d/%d", rc, len);
+        rc = sock_recv(n, buffer + bytes, want);
         if (rc < 0) {
+            // the rounded timeout expired before the deadline
+            if (n->timeout_ms > 0 && TimerLeftMS(&timer) > 0 &&
+                    (left - TimerLeftMS(&timer)) * 2 >= n->timeout_ms)
+                continue;
 #if defined(errno) && defined(__linux__) && defined(MQTT_DEBUG)
             DBG("error(%d): %s", rc, strerror(errno));
 #endif
@@ -42,9 +89,7 @@ static int _read(Network* n, unsigned char* buffer, int len, int timeout_ms) {
 
 
 static int _write(Network* n, unsigned char* buffer, int len, int timeout_ms) {
-    struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
-
-    setsockopt(n->my_socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(struct timeval));
+    set_timeout(n, timeout_bucket(timeout_ms));
     int rc = 0;
 #if defined(MQTT_CIPHER)
 //    DBG("mqtt send %d", len);
@@ -55,11 +100,28 @@ static int _write(Network* n, unsigned char* buffer, int len, int timeout_ms) {
     return rc;
 }
 
+static void reset_input(Network* n) {
+    n->timeout_ms = -1;
+#if !defined(NO_MQTT_RECV_BUF)
+    n->rx_pos = 0;
+    n->rx_len = 0;
+#endif
+}
 
 void NetworkInit(Network* n) {
     n->my_socket = -1;
     n->mqttread = _read;
     n->mqttwrite = _write;
+    reset_input(n);
+}
+
+int NetworkPending(Network* n) {
+#if !defined(NO_MQTT_RECV_BUF)
+    return n->rx_len - n->rx_pos;
+#else
+    SSP_PARAMETER_NOT_USED(n);
+    return 0;
+#endif
 }
 
 void NetworkDisconnect(Network* n) {
@@ -67,34 +129,14 @@ void NetworkDisconnect(Network* n) {
     ssl_close(n->my_socket);
 #endif
     soc_close(n->my_socket);
+    n->my_socket = -1;
 }
 
 int NetworkConnect(Network* n, char* addr, int port) {
-    struct sockaddr_in serv;
-    struct hostent *serv_resolve;
-    serv_resolve = gethostbyname(addr);
-    if (serv_resolve == NULL) {
-        DBG("MQTT ERROR: no such host %s", addr);
-        return -1;
-    }
-    memset(&serv, 0, sizeof(serv));
-
-    if (serv_resolve->h_addrtype == AF_INET) {
-        serv.sin_family = PF_INET;
-        bcopy((char *)serv_resolve->h_addr,
-                (char *)&serv.sin_addr.s_addr,
-                (size_t)serv_resolve->h_length);
-        serv.sin_port = htons((uint16_t)port);
-    } else
-        return -1;
-
-    n->my_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    reset_input(n);
+    n->my_socket = soc_connect_host(addr, (uint16_t)port, DEFAULT_MQTT_TIMEOUT);
     if ( n->my_socket < 0 ) {
-        DBG("MQTT connetion fail %d", n->my_socket);
-        return n->my_socket;
-    }
-    if ( connect(n->my_socket, (struct sockaddr*)&serv, sizeof(serv)) < 0) {
-        soc_close(n->my_socket);
+        DBG("MQTT connetion fail %s", addr);
         return -2;
     }
 #if defined(MQTT_CIPHER)
@@ -21,6 +21,7 @@
 #include <debug.h>
 #include <bsd/socket.h>
 #include <bsd/inet.h>
+#include <bsd/resolve.h>
 #include <sys/mem.h>
 #include <time/time.h>
 
@@ -40,7 +41,7 @@ int ntp_set_time(
   int udp_sock;
   socklen_t serverlen;
   struct sockaddr_in serveraddr;
-  struct hostent *server;
+  soc_addr_list_t server;
 
   udp_sock = socket(AF_INET, SOCK_DGRAM, 0);
   if (udp_sock < 0) {
@@ -59,9 +60,8 @@ int ntp_set_time(
       }
   }
 
-  /* gethostbyname: get the server's DNS entry */
-  server = gethostbyname(host);
-  if (server == NULL) {
+  /* get the server's address */
+  if ( soc_resolve(host, &server) < 0 ) {
       DBG("ERROR, no such host as %s\n", host);
       soc_close(udp_sock);
       return NTP_DNS;
@@ -70,8 +70,7 @@ int ntp_set_time(
   /* build the server's Internet address */
   bzero((char *) &serveraddr, sizeof(serveraddr));
   serveraddr.sin_family = AF_INET;
-  bcopy((char *)server->h_addr,
-          (char *)&serveraddr.sin_addr.s_addr, (size_t)server->h_length);
+  serveraddr.sin_addr.s_addr = server.addr[0];
   serveraddr.sin_port = htons(port);
   serverlen = sizeof(serveraddr);
 
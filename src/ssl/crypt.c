@@ -20,6 +20,18 @@ void __attribute__((weak)) sha256(char *shasum, char *buf, int size) {
   wc_Sha256Final(&sh, (byte*)shasum);
 }
 
+int __attribute__((weak)) sha256_stream(char *shasum, int (*read)(void *, uint8_t *, int), void *arg) {
+  Sha256 sh;
+  uint8_t buf[64];
+  int len;
+  wc_InitSha256(&sh);
+  while ( ( len = read(arg, buf, (int)sizeof(buf)) ) > 0 ) {
+    wc_Sha256Update(&sh, (byte*)buf, (word32)len);
+  }
+  wc_Sha256Final(&sh, (byte*)shasum);
+  return len;
+}
+
 void __attribute__((weak)) hmac256(char *hmacdig, const char *key, int key_size, const char *buf, int buf_size) {
   Hmac hmac;
   wc_HmacSetKey(&hmac, SHA256, (const byte*)key, (word32)key_size);
@@ -22,13 +22,24 @@
 #include <data/propmap.h>
 #include <data/find_by.h>
 #include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
+#include <json/sax.h>
+#include <json/writer.h>
 #include <http/client.h>
 #include <http/request.h>
 #include <http/response.h>
 #include <http/routine.h>
+#include <http/pool.h>
+#include <http/encoding.h>
+#include <http/parser.h>
+#include <bsd/connect.h>
+#include <bsd/resolve.h>
+#include <bsd/reactor.h>
 #include <ssl/crypt.h>
 #include <arrow/state.h>
 #include <arrow/telemetry_api.h>
+#include <arrow/telemetry_queue.h>
 #include <arrow/mqtt.h>
 #include <arrow/events.h>
 #include <arrow/gateway_payload_sign.h>
@@ -106,13 +117,12 @@ void test_gateway_register(void) {
     set_http_cb(http_resp_text, sizeof(http_resp_text));
     struct hostent *fake_addr = dns_fake(0xc0a80001, ARROW_ADDR);
     struct sockaddr_in *serv = prepsock(fake_addr, ARROW_PORT);
-    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 0);
     gethostbyname_ExpectAndReturn(ARROW_ADDR, fake_addr);
+    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 0);
     setsockopt_IgnoreAndReturn(0);
     connect_ExpectAndReturn(0, (struct sockaddr*)serv, sizeof(struct sockaddr_in), 0);
     send_StubWithCallback(send_cb);
     recv_StubWithCallback(recv_cb);
-    soc_close_Expect(0);
 
     arrow_prepare_gateway(&_test_gateway);
     int ret = arrow_register_gateway(&_test_gateway);
@@ -136,7 +146,7 @@ char gateway_config_text[] =
         "x-xss-protection: 1; mode=block\r\n"
         "Expires: 0\r\n"
         "\r\n"
-        "B4\r\n"
+        "B3\r\n"
         "{ \"cloudPlatform\": \"IotConnect\","
         "\"key\": \{"
         "\"apiKey\": \""
@@ -148,16 +158,10 @@ char gateway_config_text[] =
         "\r\n00\r\n";
 
 void test_gateway_config() {
+    // the keep-alive connection of the previous request is used
     set_http_cb(gateway_config_text, sizeof(gateway_config_text));
-    struct hostent *fake_addr = dns_fake(0xc0a80001, ARROW_ADDR);
-    struct sockaddr_in *serv = prepsock(fake_addr, ARROW_PORT);
-    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 0);
-    gethostbyname_ExpectAndReturn(ARROW_ADDR, fake_addr);
-    setsockopt_IgnoreAndReturn(0);
-    connect_ExpectAndReturn(0, (struct sockaddr*)serv, sizeof(struct sockaddr_in), 0);
     send_StubWithCallback(send_cb);
     recv_StubWithCallback(recv_cb);
-    soc_close_Expect(0);
 
     arrow_gateway_config_init(&_test_gateway_config);
     int ret = arrow_gateway_config(&_test_gateway, &_test_gateway_config);
@@ -167,3 +171,64 @@ void test_gateway_config() {
     TEST_ASSERT_EQUAL_STRING(TEST_API_KEY, get_api_key());
     TEST_ASSERT_EQUAL_STRING(TEST_SECRET_KEY, get_secret_key());
 }
+
+char telemetry_list_text[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-type: application/json;charset=UTF-8\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "B4\r\n"
+        "{\"size\":2,\"page\":0,\"totalSize\":2,\"totalPages\":1,\"data\":["
+        "{\"deviceHid\":\"d1\",\"name\":\"temperature\",\"type\":\"float\","
+        "\"timestamp\":1530000000,\"floatValue\":21},"
+        "{\"deviceHid\":\"d1\",\"name\":\"temp"
+        "\r\n41\r\n"
+        "erature\",\"type\":\"float\",\"timestamp\":1530000060,\"floatValue\":22}]}"
+        "\r\n00\r\n";
+
+void test_telemetry_find_by_device_hid(void) {
+    // the list is parsed chunk by chunk
+    telemetry_response_data_list_t list;
+    set_http_cb(telemetry_list_text, sizeof(telemetry_list_text));
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+
+    int ret = arrow_telemetry_find_by_device_hid("d1", &list, 0);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT_EQUAL_INT(2, list.size);
+    TEST_ASSERT_EQUAL_INT(1, list.totalPages);
+    TEST_ASSERT( list.data );
+    TEST_ASSERT_EQUAL_STRING("temperature", list.data->name);
+    TEST_ASSERT_EQUAL_INT(21, list.data->floatValue);
+    TEST_ASSERT( list.data->node.next );
+    telemetry_data_info_t *next = container_of(list.data->node.next, telemetry_data_info_t, node);
+    TEST_ASSERT_EQUAL_STRING("temperature", next->name);
+    TEST_ASSERT_EQUAL_STRING("float", next->type);
+    TEST_ASSERT_EQUAL_INT(1530000060, (int)next->timestamp);
+    TEST_ASSERT_EQUAL_INT(22, next->floatValue);
+    telemetry_response_data_list_free(&list);
+}
+
+static int failing_producer(void *arg, uint8_t *buf, int len) {
+    (void)(arg);
+    (void)(len);
+    return buf ? -1 : 0;
+}
+
+static void failing_payload_init(http_request_t *request, void *arg) {
+    (void)(arg);
+    http_request_init(request, POST, "http://api.arrowconnect.io:80/api/v1/kronos/telemetries/batch");
+    http_request_set_payload_producer(request, failing_producer, NULL);
+}
+
+void test_sign_request_payload_fail(void) {
+    // nothing is sent with the signature of a partial payload
+    TEST_ASSERT_EQUAL_INT(-1, __http_routine(failing_payload_init, NULL, NULL, NULL));
+}
+
+void test_pool_close(void) {
+    soc_close_Expect(0);
+    http_pool_close_all();
+    TEST_ASSERT_EQUAL_INT(-1, current_client()->sock);
+}
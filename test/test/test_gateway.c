@@ -6,6 +6,9 @@
 #include <sys/mem.h>
 #include <data/property.h>
 #include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
+#include <json/writer.h>
 #include "mock_mac.h"
 
 void setUp(void)
@@ -9,12 +9,22 @@
 #include <data/ringbuffer.h>
 #include <data/propmap.h>
 #include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
 #include <bsd/socket.h>
 #include <http/request.h>
 #include <http/response.h>
+#include <http/encoding.h>
+#include <http/parser.h>
+#include <bsd/connect.h>
+#include <bsd/resolve.h>
+#include <bsd/reactor.h>
+#include <http/async.h>
+#include <http/pool.h>
 #include <data/find_by.h>
 
 #include "acnsdkc_ssl.h"
+#include "acnsdkc_time.h"
 
 #include "mock_mac.h"
 #include "mock_sockdecl.h"
@@ -58,8 +68,8 @@ void test_http_client_do( void ) {
     http_request_init(&request, GET, "http://api.arrowconnect.io:80/api/v1/kronos/gateways");
     TEST_ASSERT( !request.query );
 
-    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 0);
     gethostbyname_ExpectAndReturn(P_VALUE(request.host), fake_addr);
+    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 0);
     struct sockaddr_in *serv = prepsock(fake_addr, request.port);
 
     setsockopt_IgnoreAndReturn(0);
@@ -73,6 +83,399 @@ void test_http_client_do( void ) {
     TEST_ASSERT_EQUAL_INT(200, response.m_httpResponseCode);
 }
 
+static int send_calls = 0;
+static char send_text[1024];
+
+static ssize_t send_count_cb(int sockfd, const void *buf, size_t len, int flags, int count) {
+    (void)(sockfd);
+    (void)(flags);
+    (void)(count);
+    if ( send_calls++ == 0 ) {
+        memcpy(send_text, buf, len);
+        send_text[len] = 0x0;
+    }
+    return (int)len;
+}
+
+void test_http_client_do_single_send( void ) {
+    set_http_cb(http_resp_text, sizeof(http_resp_text));
+    http_request_init(&request, POST, "http://api.arrowconnect.io:80/api/v1/kronos/gateways");
+    http_request_add_header(&request, p_const("Accept"), p_const("application/json"));
+    http_request_set_content_type(&request, p_const("application/json"));
+    http_request_set_payload(&request, p_const("{}"));
+
+    send_calls = 0;
+    send_StubWithCallback(send_count_cb);
+    recv_StubWithCallback(recv_cb);
+
+    int ret = http_client_do(&_test_cli, &request, &response);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT_EQUAL_INT(1, send_calls);
+    TEST_ASSERT_EQUAL_STRING("POST /api/v1/kronos/gateways HTTP/1.1\r\n"
+                             "Host: api.arrowconnect.io:80\r\n"
+                             "Content-Length: 2\r\n"
+                             "Content-Type: application/json\r\n"
+                             "Accept: application/json\r\n"
+                             "\r\n"
+                             "{}", send_text);
+    http_request_close(&request);
+    http_response_free(&response);
+}
+
+char http_gzip_text[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Encoding: gzip\r\n"
+        "Content-Length: 123\r\n"
+        "\r\n"
+        "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x3d\xcc\x31\x0e\xc2\x30"
+        "\x0c\x05\xd0\xbb\x78\xee\xd0\xef\x92\x06\xe7\x2a\x88\x21\xb6\x83"
+        "\xda\x1d\xb1\x54\xb9\x3b\x12\xb2\x99\xde\xf6\x2e\x3a\x4e\xa7\x46"
+        "\xa2\xa3\x76\x5d\x95\x4b\xb1\x61\x5a\x79\x37\x13\xb0\xbb\xe1\xc5"
+        "\x32\x4a\xed\x62\xea\xbe\xd1\x42\xde\xdf\x9d\xda\xe3\xa2\x0f\xb5"
+        "\x75\x2e\x3f\x11\x72\xb8\x85\xb7\xb0\x84\x7b\x58\xc3\x7b\x28\xf9"
+        "\xfc\xc3\x1c\x91\x25\xf2\x44\xa6\xc8\x15\xd9\x22\x5f\x64\x0c\x99"
+        "\xcf\xf9\x05\x3f\x98\x8e\x10\xe5\x00\x00\x00";
+
+void test_http_client_do_gzip( void ) {
+    set_http_cb(http_gzip_text, sizeof(http_gzip_text));
+    http_request_init(&request, GET, "http://api.arrowconnect.io:80/api/v1/kronos/gateways");
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+
+    int ret = http_client_do(&_test_cli, &request, &response);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT_EQUAL_INT(200, response.m_httpResponseCode);
+    TEST_ASSERT_EQUAL_STRING("{\"hid\":\"9be7ab0b255cecb726cc912ddc1f29e57a9cbdd3\",\"data\":["
+            "{\"v\":0},{\"v\":1},{\"v\":2},{\"v\":3},{\"v\":4},{\"v\":5},{\"v\":6},"
+            "{\"v\":7},{\"v\":8},{\"v\":9},{\"v\":10},{\"v\":11},{\"v\":12},{\"v\":13},"
+            "{\"v\":14},{\"v\":15},{\"v\":16},{\"v\":17},{\"v\":18},{\"v\":19}]}",
+            P_VALUE(response.payload.buf));
+    http_request_close(&request);
+    http_response_free(&response);
+}
+
+char http_pipeline_text[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 5\r\n"
+        "\r\n"
+        "{\"a\"}"
+        "HTTP/1.0 404 Not Found\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "3\r\n"
+        "{\"b\r\n"
+        "1\r\n"
+        "}\r\n"
+        "0\r\n"
+        "\r\n";
+
+void test_http_client_pipeline( void ) {
+    http_request_t req[2];
+    http_response_t res;
+    set_http_cb(http_pipeline_text, (int)strlen(http_pipeline_text));
+    http_request_init(req, PUT, "http://api.arrowconnect.io:80/api/v1/kronos/events/1/received");
+    http_request_init(req + 1, PUT, "http://api.arrowconnect.io:80/api/v1/kronos/events/1/succeeded");
+    send_calls = 0;
+    send_StubWithCallback(send_count_cb);
+    recv_StubWithCallback(recv_cb);
+    _test_cli.flags._close = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, http_client_send(&_test_cli, req));
+    TEST_ASSERT_EQUAL_INT(0, http_client_send(&_test_cli, req + 1));
+    TEST_ASSERT_EQUAL_INT(2, send_calls);
+
+    TEST_ASSERT_EQUAL_INT(0, http_client_receive(&_test_cli, req, &res));
+    TEST_ASSERT_EQUAL_INT(200, res.m_httpResponseCode);
+    TEST_ASSERT_EQUAL_STRING("{\"a\"}", P_VALUE(res.payload.buf));
+    http_response_free(&res);
+
+    TEST_ASSERT_EQUAL_INT(0, http_client_receive(&_test_cli, req + 1, &res));
+    TEST_ASSERT_EQUAL_INT(404, res.m_httpResponseCode);
+    TEST_ASSERT_EQUAL_STRING("{\"b}", P_VALUE(res.payload.buf));
+    TEST_ASSERT_EQUAL_INT(0, _test_cli.flags._close);
+    TEST_ASSERT_EQUAL_INT(0, ringbuf_size(_test_cli.queue));
+    http_response_free(&res);
+    http_request_close(req);
+    http_request_close(req + 1);
+}
+
+static int async_status = 1;
+static int async_code = 0;
+
+static void async_complete(http_request_t *req, http_response_t *res, int status, void *arg) {
+    (void)(req);
+    (void)(arg);
+    async_status = status;
+    async_code = res->m_httpResponseCode;
+}
+
+void test_http_client_do_async( void ) {
+    http_request_t req;
+    set_http_cb(http_resp_text, (int)strlen(http_resp_text));
+    http_request_init(&req, GET, "http://api.arrowconnect.io:80/api/v1/kronos/gateways");
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    struct hostent *fake_addr = dns_fake(0xc0a80001, ARROW_ADDR);
+    struct sockaddr_in *serv = prepsock(fake_addr, req.port);
+    soc_resolve_flush(NULL);
+    gethostbyname_ExpectAndReturn(P_VALUE(req.host), fake_addr);
+    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 1);
+    setsockopt_IgnoreAndReturn(0);
+    connect_ExpectAndReturn(1, (struct sockaddr*)serv, sizeof(struct sockaddr_in), 0);
+
+    TEST_ASSERT_EQUAL_INT(0, http_client_do_async(&req, async_complete, NULL));
+    TEST_ASSERT_EQUAL_INT(1, http_async_pending());
+    TEST_ASSERT_EQUAL_INT(1, async_status);
+    // no framing: the connection isn't kept
+    soc_close_Expect(1);
+    TEST_ASSERT_EQUAL_INT(1, reactor_poll(10));
+    TEST_ASSERT_EQUAL_INT(0, http_async_pending());
+    TEST_ASSERT_EQUAL_INT(0, async_status);
+    TEST_ASSERT_EQUAL_INT(200, async_code);
+    http_request_close(&req);
+}
+
+static char send_all[4096];
+static int send_all_len = 0;
+
+static ssize_t send_collect_cb(int sockfd, const void *buf, size_t len, int flags, int count) {
+    (void)(sockfd);
+    (void)(flags);
+    (void)(count);
+    memcpy(send_all + send_all_len, buf, len);
+    send_all_len += (int)len;
+    return (int)len;
+}
+
+static char *gzip_body = NULL;
+static int gzip_body_len = 0;
+static char gzip_plain[2048];
+static int gzip_plain_len = 0;
+
+static int gzip_body_read(void *arg, uint8_t *buf, int len) {
+    (void)(arg);
+    if ( len > gzip_body_len ) len = gzip_body_len;
+    memcpy(buf, gzip_body, len);
+    gzip_body += len;
+    gzip_body_len -= len;
+    return len;
+}
+
+static int gzip_plain_write(void *arg, uint8_t *buf, int len) {
+    (void)(arg);
+    memcpy(gzip_plain + gzip_plain_len, buf, len);
+    gzip_plain_len += len;
+    return 0;
+}
+
+void test_http_client_do_gzip_request( void ) {
+    static char body[1024];
+    static char payload[1024];
+    int i;
+    strcpy(payload, "[");
+    for ( i = 0; i < 10; i++ ) {
+        if ( i ) strcat(payload, ",");
+        strcat(payload, "{\"deviceHid\":\"9be7ab0b255cecb726cc912ddc1f29e57a9cbdd3\",\"f|temperature\":21.5}");
+    }
+    strcat(payload, "]");
+    set_http_cb(http_resp_text, sizeof(http_resp_text));
+    http_request_init(&request, POST, "http://api.arrowconnect.io:80/api/v1/kronos/telemetries/batch");
+    http_request_set_content_type(&request, p_const("application/json"));
+    http_request_set_payload(&request, p_stack(payload));
+    request.is_gzip = 1;
+
+    send_all_len = 0;
+    send_StubWithCallback(send_collect_cb);
+    recv_StubWithCallback(recv_cb);
+
+    int ret = http_client_do(&_test_cli, &request, &response);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    send_all[send_all_len] = 0x0;
+    TEST_ASSERT( strstr(send_all, "Transfer-Encoding: chunked\r\n") );
+    TEST_ASSERT( strstr(send_all, "Content-Encoding: gzip\r\n") );
+
+    // collect the chunks
+    char *p = strstr(send_all, "\r\n\r\n") + 4;
+    int body_len = 0;
+    unsigned int chunk;
+    while ( sscanf(p, "%x", &chunk) == 1 && chunk ) {
+        p = strstr(p, "\r\n") + 2;
+        memcpy(body + body_len, p, chunk);
+        body_len += chunk;
+        p += chunk + 2;
+    }
+    TEST_ASSERT( body_len > 0 );
+    TEST_ASSERT( body_len < (int)strlen(payload) / 4 );
+
+    gzip_body = body;
+    gzip_body_len = body_len;
+    gzip_plain_len = 0;
+    ret = http_inflate(http_gzip, gzip_body_read, NULL, gzip_plain_write, NULL);
+    TEST_ASSERT_EQUAL_INT((int)strlen(payload), ret);
+    gzip_plain[gzip_plain_len] = 0x0;
+    TEST_ASSERT_EQUAL_STRING(payload, gzip_plain);
+    http_request_close(&request);
+    http_response_free(&response);
+}
+
+static const char *produce_text = NULL;
+static int produce_pos = 0;
+static int produce_rewind = 0;
+
+static int produce_cb(void *arg, uint8_t *buf, int len) {
+    (void)(arg);
+    if ( !buf ) {
+        produce_pos = 0;
+        produce_rewind++;
+        return 0;
+    }
+    int rest = (int)strlen(produce_text) - produce_pos;
+    // the small parts
+    if ( len > 100 ) len = 100;
+    if ( len > rest ) len = rest;
+    memcpy(buf, produce_text + produce_pos, len);
+    produce_pos += len;
+    return len;
+}
+
+void test_http_client_do_producer( void ) {
+    static char payload[1024];
+    static char body[1024];
+    int i;
+    strcpy(payload, "[");
+    for ( i = 0; i < 10; i++ ) {
+        if ( i ) strcat(payload, ",");
+        strcat(payload, "{\"deviceHid\":\"9be7ab0b255cecb726cc912ddc1f29e57a9cbdd3\",\"f|temperature\":21.5}");
+    }
+    strcat(payload, "]");
+    produce_text = payload;
+    produce_rewind = 0;
+    set_http_cb(http_resp_text, sizeof(http_resp_text));
+    http_request_init(&request, POST, "http://api.arrowconnect.io:80/api/v1/kronos/telemetries/batch");
+    http_request_set_content_type(&request, p_const("application/json"));
+    http_request_set_payload_producer(&request, produce_cb, NULL);
+
+    send_all_len = 0;
+    send_StubWithCallback(send_collect_cb);
+    recv_StubWithCallback(recv_cb);
+
+    int ret = http_client_do(&_test_cli, &request, &response);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT_EQUAL_INT(1, produce_rewind);
+    send_all[send_all_len] = 0x0;
+    TEST_ASSERT( strstr(send_all, "Transfer-Encoding: chunked\r\n") );
+    TEST_ASSERT( !strstr(send_all, "Content-Length") );
+
+    char *p = strstr(send_all, "\r\n\r\n") + 4;
+    int body_len = 0;
+    unsigned int chunk;
+    while ( sscanf(p, "%x", &chunk) == 1 && chunk ) {
+        p = strstr(p, "\r\n") + 2;
+        memcpy(body + body_len, p, chunk);
+        body_len += chunk;
+        p += chunk + 2;
+    }
+    body[body_len] = 0x0;
+    TEST_ASSERT_EQUAL_STRING(payload, body);
+    http_request_close(&request);
+    http_response_free(&response);
+}
+
+static int stale_recv_calls = 0;
+
+// the kept alive connection was closed by the server before the request
+static ssize_t recv_stale_cb(int sockfd, void *buf, size_t len, int flags, int count) {
+    if ( !stale_recv_calls++ ) return 0;
+    return recv_cb(sockfd, buf, len, flags, count);
+}
+
+void test_http_client_do_stale_reconnect( void ) {
+    set_http_cb(http_resp_text, sizeof(http_resp_text));
+    http_request_init(&request, POST, "http://api.arrowconnect.io:80/api/v1/kronos/telemetries");
+    http_request_set_content_type(&request, p_const("application/json"));
+    http_request_set_payload(&request, p_const("{}"));
+    struct hostent *fake_addr = dns_fake(0xc0a80001, ARROW_ADDR);
+    struct sockaddr_in *serv = prepsock(fake_addr, request.port);
+    soc_resolve_flush(NULL);
+    _test_cli.sock = 0;
+    stale_recv_calls = 0;
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_stale_cb);
+    soc_close_Expect(0);
+    gethostbyname_ExpectAndReturn(P_VALUE(request.host), fake_addr);
+    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 0);
+    setsockopt_IgnoreAndReturn(0);
+    connect_ExpectAndReturn(0, (struct sockaddr*)serv, sizeof(struct sockaddr_in), 0);
+
+    TEST_ASSERT_EQUAL_INT(0, http_client_do(&_test_cli, &request, &response));
+    TEST_ASSERT_EQUAL_INT(200, response.m_httpResponseCode);
+    TEST_ASSERT( stale_recv_calls > 1 );
+    http_request_close(&request);
+    http_response_free(&response);
+}
+
+void test_http_client_do_timeout_no_resend( void ) {
+    // no answer in time on the kept alive connection:
+    // the server may have the request already
+    set_http_cb(http_resp_text, 0);
+    http_request_init(&request, POST, "http://api.arrowconnect.io:80/api/v1/kronos/telemetries");
+    http_request_set_content_type(&request, p_const("application/json"));
+    http_request_set_payload(&request, p_const("{}"));
+    _test_cli.sock = 0;
+    send_calls = 0;
+    send_StubWithCallback(send_count_cb);
+    recv_StubWithCallback(recv_cb);
+    soc_close_Expect(0);
+
+    TEST_ASSERT_EQUAL_INT(-1, http_client_do(&_test_cli, &request, &response));
+    TEST_ASSERT_EQUAL_INT(-1, _test_cli.sock);
+    http_request_close(&request);
+    http_response_free(&response);
+    _test_cli.sock = 0;
+}
+
+static char keep_resp_text[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+
+void test_http_client_do_async_timeout_no_resend( void ) {
+    http_request_t req;
+    set_http_cb(keep_resp_text, (int)strlen(keep_resp_text));
+    http_request_init(&req, GET, "http://api.arrowconnect.io:80/api/v1/kronos/gateways");
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    struct hostent *fake_addr = dns_fake(0xc0a80001, ARROW_ADDR);
+    struct sockaddr_in *serv = prepsock(fake_addr, req.port);
+    soc_resolve_flush(NULL);
+    gethostbyname_ExpectAndReturn(P_VALUE(req.host), fake_addr);
+    socket_ExpectAndReturn(PF_INET, SOCK_STREAM, IPPROTO_TCP, 1);
+    setsockopt_IgnoreAndReturn(0);
+    connect_ExpectAndReturn(1, (struct sockaddr*)serv, sizeof(struct sockaddr_in), 0);
+    TEST_ASSERT_EQUAL_INT(0, http_client_do_async(&req, async_complete, NULL));
+    TEST_ASSERT_EQUAL_INT(1, reactor_poll(10));
+    TEST_ASSERT_EQUAL_INT(0, async_status);
+    http_request_close(&req);
+
+    // no answer in time on the kept alive connection:
+    // the server may have the request already
+    set_http_cb(http_resp_text, 0);
+    http_request_init(&req, POST, "http://api.arrowconnect.io:80/api/v1/kronos/telemetries");
+    http_request_set_content_type(&req, p_const("application/json"));
+    http_request_set_payload(&req, p_const("{}"));
+    send_calls = 0;
+    send_StubWithCallback(send_count_cb);
+    TEST_ASSERT_EQUAL_INT(0, http_client_do_async(&req, async_complete, NULL));
+    soc_close_Expect(1);
+    TEST_ASSERT_EQUAL_INT(1, reactor_poll(10));
+    TEST_ASSERT_EQUAL_INT(0, http_async_pending());
+    TEST_ASSERT_EQUAL_INT(-1, async_status);
+    TEST_ASSERT_EQUAL_INT(1, send_calls);
+    http_request_close(&req);
+}
+
 void test_http_client_free( void ) {
     soc_close_Expect(0);
     http_client_free(&_test_cli);
@@ -0,0 +1,101 @@
+#include "unity.h"
+#include <string.h>
+#include <config.h>
+#include <http/parser.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static const char resp[] =
+        "\r\n"
+        "HTTP/1.0 200 OK\r\n"
+        "content-length:  12 \r\n"
+        "TRANSFER-ENCODING: gzip, Chunked\r\n"
+        "X-Test:\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+void test_http_parser_whole(void) {
+    char buf[sizeof(resp)];
+    http_parser_t p;
+    int ret;
+    char *ptr = buf;
+    memcpy(buf, resp, sizeof(resp));
+    http_parser_init(&p);
+    ret = http_parser_execute(&p, ptr, (int)strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(19, ret);
+    TEST_ASSERT_EQUAL_INT(http_parse_status, p.event);
+    TEST_ASSERT_EQUAL_INT(0, p.minor);
+    TEST_ASSERT_EQUAL_INT(200, p.status);
+    ptr += ret;
+
+    ret = http_parser_execute(&p, ptr, (int)strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(http_parse_header, p.event);
+    TEST_ASSERT_EQUAL_INT(http_hdr_content_length, p.id);
+    TEST_ASSERT_EQUAL_INT(2, p.value.len);
+    uint32_t len = 0;
+    TEST_ASSERT_EQUAL_INT(0, http_span_to_uint(&p.value, &len));
+    TEST_ASSERT_EQUAL_INT(12, len);
+    ptr += ret;
+
+    ret = http_parser_execute(&p, ptr, (int)strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(http_hdr_transfer_encoding, p.id);
+    TEST_ASSERT(http_span_has_token(&p.value, "chunked"));
+    TEST_ASSERT(!http_span_has_token(&p.value, "chunk"));
+    ptr += ret;
+
+    ret = http_parser_execute(&p, ptr, (int)strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(http_hdr_other, p.id);
+    TEST_ASSERT_EQUAL_INT(6, p.name.len);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(p.name.ptr, "X-Test", 6));
+    TEST_ASSERT_EQUAL_INT(0, p.value.len);
+    ptr += ret;
+
+    ret = http_parser_execute(&p, ptr, (int)strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(http_hdr_connection, p.id);
+    TEST_ASSERT(http_span_has_token(&p.value, "keep-alive"));
+    ptr += ret;
+
+    ret = http_parser_execute(&p, ptr, (int)strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_INT(http_parse_done, p.event);
+}
+
+void test_http_parser_partial(void) {
+    char buf[sizeof(resp)];
+    http_parser_t p;
+    int i, ret = 0;
+    int events = 0;
+    int start = 0;
+    memcpy(buf, resp, sizeof(resp));
+    http_parser_init(&p);
+    // the data comes by one byte
+    for ( i = 1; i < (int)sizeof(resp); i++ ) {
+        ret = http_parser_execute(&p, buf + start, i - start);
+        TEST_ASSERT(ret >= 0);
+        if ( ret ) {
+            TEST_ASSERT_EQUAL_INT(i - start, ret);
+            start += ret;
+            events++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(6, events);
+    TEST_ASSERT_EQUAL_INT(http_parse_done, p.event);
+}
+
+void test_http_parser_bad(void) {
+    http_parser_t p;
+    char status[] = "HTTP/2 200 OK\r\n";
+    char header[] = "HTTP/1.1 404 Not Found\r\nBad Name: x\r\n";
+    http_parser_init(&p);
+    TEST_ASSERT_EQUAL_INT(-1, http_parser_execute(&p, status, (int)strlen(status)));
+    http_parser_init(&p);
+    int ret = http_parser_execute(&p, header, (int)strlen(header));
+    TEST_ASSERT_EQUAL_INT(404, p.status);
+    TEST_ASSERT_EQUAL_INT(-1, http_parser_execute(&p, header + ret, (int)strlen(header + ret)));
+}
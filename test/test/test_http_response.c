@@ -7,6 +7,8 @@
 #include <data/ringbuffer.h>
 #include <data/propmap.h>
 #include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
 #include <bsd/socket.h>
 #include <http/request.h>
 #include <http/response.h>
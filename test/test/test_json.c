@@ -0,0 +1,169 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static const char *event_text =
+        "{\"hid\":\"a1b2\",\"name\":\"ServerToGateway_DeviceCommand\","
+        "\"encrypted\":false,\"parameters\":{\"deviceHid\":\"c3d4\","
+        "\"command\":\"led\",\"payload\":\"{\\\"on\\\":true}\",\"level\":-1.5e2,"
+        "\"list\":[1,null,\"\\u00e9\\ud83d\\ude00\"]}}";
+
+void test_json_decode_escapes( void ) {
+    JsonNode *_main = json_decode(event_text);
+    TEST_ASSERT( _main );
+    JsonNode *par = json_find_member(_main, "parameters");
+    TEST_ASSERT_EQUAL_STRING("{\"on\":true}", json_find_member(par, "payload")->string_);
+    TEST_ASSERT_EQUAL_INT(-150, (int)json_number(json_find_member(par, "level")));
+    JsonNode *list = json_find_member(par, "list");
+    TEST_ASSERT_EQUAL_STRING("\xc3\xa9\xf0\x9f\x98\x80", json_find_element(list, 2)->string_);
+    char *text = json_encode(json_find_member(par, "list"));
+    TEST_ASSERT_EQUAL_STRING("[1,null,\"\xc3\xa9\xf0\x9f\x98\x80\"]", text);
+    free(text);
+    json_delete(_main);
+
+    TEST_ASSERT( !json_decode("{\"a\":\"b}") );
+    TEST_ASSERT( !json_decode("{\"a\":\"\\u0000\"}") );
+}
+
+void test_json_decode_arena( void ) {
+    json_arena_t arena;
+    json_arena_init(&arena, 0);
+    JsonNode *_main = json_decode_arena(&arena, event_text);
+    TEST_ASSERT( _main );
+    TEST_ASSERT( _main->arena_ );
+    // one block for the whole tree
+    TEST_ASSERT( arena.head );
+    TEST_ASSERT( !arena.head->next );
+    JsonNode *par = json_find_member(_main, "parameters");
+    TEST_ASSERT_EQUAL_STRING("led", json_find_member(par, "command")->string_);
+    // unlinked only
+    json_delete(json_find_member(par, "list"));
+    TEST_ASSERT( !json_find_member(par, "list") );
+
+    JsonNode *obj = json_arena_mkobject(&arena);
+    json_arena_append_member(&arena, obj, "state", json_arena_mkstring(&arena, "on"));
+    json_arena_append_member(&arena, obj, "value", json_arena_mknumber(&arena, 2));
+    char *text = json_encode(obj);
+    TEST_ASSERT_EQUAL_STRING("{\"state\":\"on\",\"value\":2}", text);
+    free(text);
+    json_arena_free(&arena);
+    TEST_ASSERT( !arena.head );
+}
+
+void test_json_decode_arena_no_memory( void ) {
+    json_arena_t arena;
+    // no block of this size can be allocated
+    json_arena_init(&arena, (size_t)1 << 62);
+    TEST_ASSERT( !json_decode_arena(&arena, event_text) );
+    TEST_ASSERT( !json_decode_arena(&arena, "[1,2]") );
+    TEST_ASSERT( !json_decode_arena(&arena, "true") );
+    TEST_ASSERT( !json_decode_arena(&arena, "null") );
+    TEST_ASSERT( !json_decode_arena(&arena, "12.5") );
+    TEST_ASSERT( !json_decode_arena(&arena, "\"text\"") );
+    json_arena_free(&arena);
+}
+
+void test_json_decode_insitu( void ) {
+    json_arena_t arena;
+    char *text = strdup(event_text);
+    json_arena_init(&arena, 0);
+    JsonNode *_main = json_decode_insitu(&arena, text);
+    TEST_ASSERT( _main );
+    JsonNode *par = json_find_member(_main, "parameters");
+    JsonNode *pay = json_find_member(par, "payload");
+    // the strings are in the text
+    TEST_ASSERT( pay->string_ > text && pay->string_ < text + strlen(event_text) );
+    TEST_ASSERT( par->key > text && par->key < text + strlen(event_text) );
+    TEST_ASSERT_EQUAL_STRING("{\"on\":true}", pay->string_);
+    TEST_ASSERT_EQUAL_STRING("\xc3\xa9\xf0\x9f\x98\x80",
+                             json_find_element(json_find_member(par, "list"), 2)->string_);
+
+    // a part of the tree outlives the text
+    JsonNode *copy = json_copy(par);
+    json_arena_free(&arena);
+    free(text);
+    TEST_ASSERT( !copy->arena_ );
+    TEST_ASSERT_EQUAL_STRING("led", json_find_member(copy, "command")->string_);
+    char *out = json_encode(json_find_member(copy, "list"));
+    TEST_ASSERT_EQUAL_STRING("[1,null,\"\xc3\xa9\xf0\x9f\x98\x80\"]", out);
+    free(out);
+    json_delete(copy);
+}
+
+void test_json_find_member_index( void ) {
+    static const char *keys[] = { "hid", "uid", "name", "type", "enabled",
+                                  "createdDate", "lastModifiedDate", "osName",
+                                  "softwareName", "softwareVersion", "sdkVersion" };
+    int i, n = (int)(sizeof(keys) / sizeof(keys[0]));
+    JsonNode *obj = json_mkobject();
+    for ( i = 0; i < n; i++ ) json_append_member(obj, keys[i], json_mknumber(i));
+    // the same key again: the first one is found
+    json_append_member(obj, "name", json_mknumber(100));
+    for ( i = 0; i < n; i++ )
+        TEST_ASSERT_EQUAL_INT(i, (int)json_number(json_find_member(obj, keys[i])));
+    TEST_ASSERT( obj->children.index );
+    TEST_ASSERT( !json_find_member(obj, "missing") );
+
+    // the index follows the changes
+    json_delete(json_find_member(obj, "name"));
+    TEST_ASSERT_EQUAL_INT(100, (int)json_number(json_find_member(obj, "name")));
+    json_append_member(obj, "gatewayHid", json_mkstring("g1"));
+    TEST_ASSERT_EQUAL_STRING("g1", json_find_member(obj, "gatewayHid")->string_);
+    json_delete(obj);
+
+    // the decoder indexes the arena objects
+    json_arena_t arena;
+    char text[512];
+    char *p = text;
+    p += sprintf(p, "{");
+    for ( i = 0; i < n; i++ ) p += sprintf(p, "%s\"%s\":%d", i ? "," : "", keys[i], i);
+    sprintf(p, "}");
+    json_arena_init(&arena, 0);
+    obj = json_decode_insitu(&arena, text);
+    TEST_ASSERT( obj );
+    TEST_ASSERT( obj->children.index );
+    for ( i = 0; i < n; i++ )
+        TEST_ASSERT_EQUAL_INT(i, (int)json_number(json_find_member(obj, keys[i])));
+    json_arena_free(&arena);
+}
+
+void test_json_encode_into( void ) {
+    char buf[256];
+    JsonNode *node = json_decode(event_text);
+    char *text = json_encode(node);
+    int len = (int)strlen(text);
+
+    memset(buf, 'x', sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(len, json_encode_into(node, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING(text, buf);
+    // the exact size fits even though the encoder asks for a slack
+    TEST_ASSERT_EQUAL_INT(len, json_encode_into(node, buf, len + 1));
+    TEST_ASSERT_EQUAL_STRING(text, buf);
+    TEST_ASSERT_EQUAL_INT(-1, json_encode_into(node, buf, len));
+    TEST_ASSERT_EQUAL_INT(-1, json_encode_into(node, buf, 1));
+    TEST_ASSERT_EQUAL_INT(-1, json_encode_into(node, buf, 0));
+
+    // the escapes go beyond the size guess
+    JsonNode *str = json_mkstring("\x01\x02\x03\x04\x05\x06\x07\x08\"\\\n");
+    char *enc = json_encode(str);
+    TEST_ASSERT_EQUAL_STRING("\"\\u0001\\u0002\\u0003\\u0004\\u0005\\u0006\\u0007\\b\\\"\\\\\\n\"", enc);
+    free(enc);
+    json_delete(str);
+
+    free(text);
+    json_delete(node);
+}
@@ -0,0 +1,87 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <config.h>
+#include <json/dtoa.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void check_dtoa(const char *expected, double v) {
+    char buf[JSON_DTOA_SIZE];
+    int len = json_dtoa(v, buf);
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL_INT((int)strlen(expected), len);
+}
+
+void test_json_dtoa_shortest( void ) {
+    check_dtoa("0", 0.0);
+    check_dtoa("0", -0.0);
+    check_dtoa("1", 1.0);
+    check_dtoa("-150", -150.0);
+    check_dtoa("9007199254740992", 9007199254740992.0);
+    check_dtoa("0.1", 0.1);
+    check_dtoa("0.3", 0.3);
+    check_dtoa("0.30000000000000004", 0.1 + 0.2);
+    check_dtoa("-2.5", -2.5);
+    check_dtoa("123.456", 123.456);
+    check_dtoa("0.000001", 1e-6);
+    check_dtoa("5e-7", 5e-7);
+    check_dtoa("1e21", 1e21);
+    check_dtoa("1.7976931348623157e308", 1.7976931348623157e308);
+    check_dtoa("5e-324", 5e-324);
+
+    char buf[JSON_DTOA_SIZE];
+    TEST_ASSERT_EQUAL_INT(-1, json_dtoa(NAN, buf));
+    TEST_ASSERT_EQUAL_INT(-1, json_dtoa(INFINITY, buf));
+    TEST_ASSERT_EQUAL_INT(-1, json_dtoa(-INFINITY, buf));
+
+    TEST_ASSERT_EQUAL_INT(20, json_itoa(INT64_MIN, buf));
+    TEST_ASSERT_EQUAL_STRING("-9223372036854775808", buf);
+}
+
+void test_json_dtoa_roundtrip( void ) {
+    char buf[JSON_DTOA_SIZE];
+    unsigned int seed = 7;
+    int i;
+    for ( i = 0; i < 20000; i++ ) {
+        uint64_t bits = 0;
+        double v;
+        int j;
+        for ( j = 0; j < 4; j++ ) {
+            seed = seed * 1103515245u + 12345u;
+            bits = ( bits << 16 ) | ( ( seed >> 8 ) & 0xffff );
+        }
+        memcpy(&v, &bits, sizeof(v));
+        if ( isnan(v) || isinf(v) ) continue;
+        TEST_ASSERT( json_dtoa(v, buf) > 0 );
+        TEST_ASSERT( strtod(buf, NULL) == v );
+    }
+}
+
+void test_json_dtoa_fixed( void ) {
+    static const double values[] = {
+        0.0, -0.0, 1.0, -1.5, 0.1, 2.675, 123.456789, 1e-7, 0.5e-6,
+        1234567.0000005, -98765.4321, 4294967296.25, 1e20
+    };
+    char buf[64];
+    char expected[64];
+    size_t i;
+    int prec;
+    for ( i = 0; i < sizeof(values) / sizeof(values[0]); i++ ) {
+        for ( prec = 0; prec <= 9; prec++ ) {
+            snprintf(expected, sizeof(expected), "%.*f", prec, values[i]);
+            TEST_ASSERT_EQUAL_INT((int)strlen(expected),
+                                  json_dtoa_fixed(values[i], prec, buf, sizeof(buf)));
+            TEST_ASSERT_EQUAL_STRING(expected, buf);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(-1, json_dtoa_fixed(123456.0, 6, buf, 8));
+}
@@ -0,0 +1,116 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <config.h>
+#include <json/sax.h>
+
+static char trace[1024];
+
+static int trace_cb(json_sax_t *p, json_sax_event_t ev, void *arg) {
+    char *t = trace + strlen(trace);
+    (void)arg;
+    switch ( ev ) {
+    case json_sax_null: sprintf(t, "%d:%s=null;", p->depth, p->key); break;
+    case json_sax_bool: sprintf(t, "%d:%s=%s;", p->depth, p->key, p->bool_ ? "true" : "false"); break;
+    case json_sax_string: sprintf(t, "%d:%s=\"%s\"%s;", p->depth, p->key, p->value, p->truncated ? "..." : ""); break;
+    case json_sax_number: sprintf(t, "%d:%s=%g;", p->depth, p->key, p->number); break;
+    case json_sax_object_start: sprintf(t, "%d:%s{;", p->depth, p->key); break;
+    case json_sax_object_end: sprintf(t, "%d:};", p->depth); break;
+    case json_sax_array_start: sprintf(t, "%d:%s[;", p->depth, p->key); break;
+    case json_sax_array_end: sprintf(t, "%d:];", p->depth); break;
+    }
+    return 0;
+}
+
+static int stop_cb(json_sax_t *p, json_sax_event_t ev, void *arg) {
+    (void)p;
+    return ev == json_sax_number ? -1 : 0;
+}
+
+static const char *list_text =
+        "{\"size\":2,\"data\":[{\"deviceHid\":\"a\\\"1\",\"v\":-1.5e2},"
+        "{\"deviceHid\":\"\\u00e9\\ud83d\\ude00\",\"v\":true,\"x\":null}],\"page\" : 0}";
+
+static const char *list_trace =
+        "0:{;1:size=2;1:data[;2:{;3:deviceHid=\"a\"1\";3:v=-150;2:};"
+        "2:{;3:deviceHid=\"\xc3\xa9\xf0\x9f\x98\x80\";3:v=true;3:x=null;2:};"
+        "1:];1:page=0;0:};";
+
+void setUp(void)
+{
+    trace[0] = '\0';
+}
+
+void tearDown(void)
+{
+}
+
+void test_json_sax_chunks( void ) {
+    json_sax_t p;
+    int step, i, len = (int)strlen(list_text);
+    // the result does not depend on how the text is split
+    for ( step = 1; step <= len; step += 7 ) {
+        trace[0] = '\0';
+        json_sax_init(&p, trace_cb, NULL);
+        for ( i = 0; i < len; i += step ) {
+            int n = len - i < step ? len - i : step;
+            TEST_ASSERT_EQUAL_INT(0, json_sax_feed(&p, list_text + i, n));
+        }
+        TEST_ASSERT_EQUAL_INT(0, json_sax_finish(&p));
+        TEST_ASSERT_EQUAL_STRING(list_trace, trace);
+    }
+
+    // a top level number ends with the text
+    trace[0] = '\0';
+    json_sax_init(&p, trace_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(0, json_sax_feed(&p, " 12", 3));
+    TEST_ASSERT_EQUAL_STRING("", trace);
+    TEST_ASSERT_EQUAL_INT(0, json_sax_finish(&p));
+    TEST_ASSERT_EQUAL_STRING("0:=12;", trace);
+}
+
+void test_json_sax_truncate( void ) {
+    json_sax_t p;
+    char text[JSON_SAX_VALUE_SIZE + 16];
+    char expect[JSON_SAX_VALUE_SIZE + 16];
+    text[0] = '"';
+    memset(text + 1, 'x', JSON_SAX_VALUE_SIZE + 4);
+    strcpy(text + JSON_SAX_VALUE_SIZE + 5, "\"");
+    json_sax_init(&p, trace_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(0, json_sax_feed(&p, text, (int)strlen(text)));
+    TEST_ASSERT_EQUAL_INT(0, json_sax_finish(&p));
+    strcpy(expect, "0:=\"");
+    memset(expect + 4, 'x', JSON_SAX_VALUE_SIZE - 1);
+    strcpy(expect + 4 + JSON_SAX_VALUE_SIZE - 1, "\"...;");
+    TEST_ASSERT_EQUAL_STRING(expect, trace);
+}
+
+void test_json_sax_errors( void ) {
+    static const char *bad[] = {
+        "{\"a\":\"b}",
+        "{\"a\" 1}",
+        "{\"a\":1,}",
+        "[1 2]",
+        "[1}",
+        "{\"a\":tru}",
+        "{\"a\":\"\\u0000\"}",
+        "{\"a\":\"\\udc00\"}",
+        "{\"a\":\"\\ud83dx\"}",
+        "{\"a\":1.2.3}",
+        "{} {}",
+        "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]"
+    };
+    json_sax_t p;
+    int i;
+    for ( i = 0; i < (int)(sizeof(bad) / sizeof(bad[0])); i++ ) {
+        json_sax_init(&p, trace_cb, NULL);
+        int ret = json_sax_feed(&p, bad[i], (int)strlen(bad[i]));
+        if ( !ret ) ret = json_sax_finish(&p);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(-1, ret, bad[i]);
+    }
+    // the callback stops the parser
+    json_sax_init(&p, stop_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(-1, json_sax_feed(&p, "[\"a\",1,2]", 9));
+    TEST_ASSERT_EQUAL_INT(-1, json_sax_finish(&p));
+}
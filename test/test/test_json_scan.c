@@ -0,0 +1,101 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
+#include <arrow/utf8.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_json_scan_runs( void ) {
+    static const char stops[] = { '"', '\\', '\n', 0x1F, (char)0x80, (char)0xC3, 0 };
+    static char area[128] __attribute__((aligned(64)));
+    int start, pos;
+    size_t i;
+    for ( start = 0; start < 32; start++ ) {
+        for ( pos = 0; pos < 48; pos++ ) {
+            for ( i = 0; i < sizeof(stops); i++ ) {
+                char *s = area + start;
+                memset(area, 'a', sizeof(area) - 1);
+                area[sizeof(area) - 1] = 0;
+                s[pos] = stops[i];
+                s[pos + 1] = 'b';
+                TEST_ASSERT_EQUAL_INT(pos, json_scan_plain(s));
+                if ( stops[i] == '"' || stops[i] == '\\' )
+                    TEST_ASSERT_EQUAL_INT((int)strlen(s), json_scan_ascii(s));
+                else
+                    TEST_ASSERT_EQUAL_INT(pos, json_scan_ascii(s));
+            }
+        }
+    }
+    // DEL is a printable char here
+    TEST_ASSERT_EQUAL_INT(3, json_scan_plain("~\x7f?\x01"));
+}
+
+void test_json_scan_strings( void ) {
+    char text[1024];
+    char *p = text;
+    int i;
+    // the special chars on the both sides of the block borders
+    for ( i = 0; i < 40; i++ ) {
+        memset(p, 'x', (size_t)i);
+        p += i;
+        *p++ = ( i % 3 == 0 ) ? '"' : ( i % 3 == 1 ) ? '\t' : '\\';
+        if ( i % 5 == 0 ) {
+            memcpy(p, "\xc3\xa9", 2);
+            p += 2;
+        }
+    }
+    *p = 0;
+
+    JsonNode *node = json_mkstring(text);
+    char *enc = json_encode(node);
+    json_delete(node);
+    JsonNode *dec = json_decode(enc);
+    TEST_ASSERT( dec );
+    TEST_ASSERT_EQUAL_STRING(text, dec->string_);
+    json_delete(dec);
+
+    json_arena_t arena;
+    json_arena_init(&arena, 0);
+    dec = json_decode_insitu(&arena, enc);
+    TEST_ASSERT( dec );
+    TEST_ASSERT_EQUAL_STRING(text, dec->string_);
+    json_arena_free(&arena);
+    free(enc);
+
+    // no closing quote after a long run
+    memset(text, 'y', 300);
+    text[0] = '"';
+    text[300] = 0;
+    TEST_ASSERT( !json_decode(text) );
+    // a raw control char in the literal
+    text[200] = '\n';
+    text[299] = '"';
+    TEST_ASSERT( !json_decode(text) );
+}
+
+void test_json_scan_utf8check( void ) {
+    char text[200];
+    memset(text, 'z', sizeof(text) - 1);
+    text[sizeof(text) - 1] = 0;
+    TEST_ASSERT_EQUAL_INT(1, utf8check(text));
+    memcpy(text + 150, "\xe2\x82\xac", 3);
+    TEST_ASSERT_EQUAL_INT(1, utf8check(text));
+    text[180] = (char)0xC0;
+    TEST_ASSERT_EQUAL_INT(0, utf8check(text));
+    text[180] = '\r';
+    TEST_ASSERT_EQUAL_INT(0, utf8check(text));
+    memcpy(text + 150, "\xed\xa0\x80", 3);
+    text[180] = 'z';
+    TEST_ASSERT_EQUAL_INT(0, utf8check(text));
+}
@@ -0,0 +1,127 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
+#include <json/writer.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static const char *tree_text =
+        "{\"name\":\"gate \\\"1\\\"\",\"list\":[1,-2.5,true,false,null,\"\\u0001\\n\"],"
+        "\"info\":{},\"empty\":[],\"path\":\"a\\\\b\xc3\xa9\"}";
+
+static int write_sample(json_writer_t *w, void *arg) {
+    (void)arg;
+    json_write_begin_object(w);
+    json_write_member(w, "name", string, "gate \"1\"");
+    json_write_key(w, "list");
+    json_write_begin_array(w);
+    json_write_number(w, 1);
+    json_write_number(w, -2.5);
+    json_write_bool(w, 1);
+    json_write_bool(w, 0);
+    json_write_null(w);
+    json_write_string(w, "\x01\n");
+    json_write_end_array(w);
+    json_write_key(w, "info");
+    json_write_begin_object(w);
+    json_write_end_object(w);
+    json_write_key(w, "empty");
+    json_write_begin_array(w);
+    json_write_end_array(w);
+    json_write_member(w, "path", string, "a\\b\xc3\xa9");
+    return json_write_end_object(w);
+}
+
+static char sink[512];
+static int sink_len;
+static int sink_calls;
+
+static int sink_flush(void *arg, const char *buf, int len) {
+    (void)arg;
+    memcpy(sink + sink_len, buf, (size_t)len);
+    sink_len += len;
+    sink[sink_len] = '\0';
+    sink_calls++;
+    return 0;
+}
+
+void test_json_writer_buffer( void ) {
+    char buf[256];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf));
+    write_sample(&w, NULL);
+    TEST_ASSERT_EQUAL_INT((int)strlen(tree_text), json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(tree_text, buf);
+
+    // the same text as the tree encoder
+    JsonNode *node = json_decode(tree_text);
+    char *text = json_encode(node);
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_node(&w, node);
+    TEST_ASSERT( json_writer_finish(&w) > 0 );
+    TEST_ASSERT_EQUAL_STRING(text, buf);
+    free(text);
+    json_delete(node);
+
+    // no room
+    json_writer_init(&w, buf, 16);
+    write_sample(&w, NULL);
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+}
+
+void test_json_writer_flush( void ) {
+    char buf[7];
+    json_writer_t w;
+    sink_len = 0;
+    sink_calls = 0;
+    json_writer_init_flush(&w, buf, sizeof(buf), sink_flush, NULL);
+    write_sample(&w, NULL);
+    TEST_ASSERT_EQUAL_INT((int)strlen(tree_text), json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(tree_text, sink);
+    TEST_ASSERT( sink_calls > 1 );
+
+    char *text = json_write_alloc(write_sample, NULL);
+    TEST_ASSERT_EQUAL_STRING(tree_text, text);
+    free(text);
+}
+
+void test_json_writer_errors( void ) {
+    char buf[64];
+    json_writer_t w;
+    // a value without a key
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_begin_object(&w);
+    TEST_ASSERT_EQUAL_INT(-1, json_write_string(&w, "x"));
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+    // a key in an array
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_begin_array(&w);
+    TEST_ASSERT_EQUAL_INT(-1, json_write_key(&w, "x"));
+    // wrong end
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_begin_array(&w);
+    TEST_ASSERT_EQUAL_INT(-1, json_write_end_object(&w));
+    // not closed
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_begin_object(&w);
+    json_write_key(&w, "a");
+    TEST_ASSERT_EQUAL_INT(-1, json_write_end_object(&w));
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_begin_array(&w);
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+    // two values at the top
+    json_writer_init(&w, buf, sizeof(buf));
+    json_write_number(&w, 1);
+    TEST_ASSERT_EQUAL_INT(-1, json_write_number(&w, 2));
+}
@@ -0,0 +1,213 @@
+#include "unity.h"
+#include <string.h>
+#include <config.h>
+#include <bsd/socket.h>
+#include <bsd/connect.h>
+#include <bsd/resolve.h>
+#include <mqtt/client/network.h>
+#include <mqtt/client/MQTTClient.h>
+#include <mqtt/packet/MQTTPacket.h>
+#include <mqtt/packet/MQTTConnect.h>
+#include <mqtt/packet/MQTTPublish.h>
+
+#include "acnsdkc_ssl.h"
+#include "timer.h"
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+
+#include "mock_sockdecl.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static const unsigned char mqtt_in_packets[] = {
+    0xD0, 0x00,             // PINGRESP
+    0x40, 0x02, 0x00, 0x07  // PUBACK
+};
+static unsigned char mqtt_in_large[300];
+static const unsigned char *mqtt_in;
+static size_t mqtt_in_len;
+static int mqtt_recv_calls;
+static int mqtt_timeout_calls;
+
+static ssize_t mqtt_recv_cb(int sockfd, void *buf, size_t len, int flags, int num_calls) {
+    (void)sockfd; (void)flags; (void)num_calls;
+    mqtt_recv_calls++;
+    if ( !mqtt_in_len ) return -1;
+    if ( len > mqtt_in_len ) len = mqtt_in_len;
+    memcpy(buf, mqtt_in, len);
+    mqtt_in += len;
+    mqtt_in_len -= len;
+    return (ssize_t)len;
+}
+
+static int mqtt_setsockopt_cb(int sockfd, int level, int optname,
+                              const void *optval, socklen_t optlen, int num_calls) {
+    (void)sockfd; (void)level; (void)optname; (void)optval; (void)optlen; (void)num_calls;
+    mqtt_timeout_calls++;
+    return 0;
+}
+
+void test_mqtt_network_buffered_read(void) {
+    Network n;
+    unsigned char buf[sizeof(mqtt_in_large)];
+    NetworkInit(&n);
+    n.my_socket = 3;
+    mqtt_in = mqtt_in_packets;
+    mqtt_in_len = sizeof(mqtt_in_packets);
+    mqtt_recv_calls = 0;
+    mqtt_timeout_calls = 0;
+    recv_StubWithCallback(mqtt_recv_cb);
+    setsockopt_StubWithCallback(mqtt_setsockopt_cb);
+
+    // the header byte takes both packets with one socket read
+    TEST_ASSERT_EQUAL_INT(1, n.mqttread(&n, buf, 1, 1000));
+    TEST_ASSERT_EQUAL_INT(0xD0, buf[0]);
+    TEST_ASSERT_EQUAL_INT(5, NetworkPending(&n));
+    TEST_ASSERT_EQUAL_INT(1, n.mqttread(&n, buf, 1, 900));
+    TEST_ASSERT_EQUAL_INT(4, n.mqttread(&n, buf, 4, 800));
+    TEST_ASSERT_EQUAL_MEMORY(mqtt_in_packets + 2, buf, 4);
+    TEST_ASSERT_EQUAL_INT(0, NetworkPending(&n));
+    TEST_ASSERT_EQUAL_INT(1, mqtt_recv_calls);
+    TEST_ASSERT_EQUAL_INT(1, mqtt_timeout_calls);
+
+    // the same timeout isn't set again
+    TEST_ASSERT_EQUAL_INT(-1, n.mqttread(&n, buf, 1, 1000));
+    TEST_ASSERT_EQUAL_INT(1, mqtt_timeout_calls);
+    // nor a close one
+    TEST_ASSERT_EQUAL_INT(-1, n.mqttread(&n, buf, 1, 700));
+    TEST_ASSERT_EQUAL_INT(1, mqtt_timeout_calls);
+
+    // a body larger than the buffer is read in place
+    memset(mqtt_in_large, 0x5A, sizeof(mqtt_in_large));
+    mqtt_in = mqtt_in_large;
+    mqtt_in_len = sizeof(mqtt_in_large);
+    mqtt_recv_calls = 0;
+    TEST_ASSERT_EQUAL_INT((int)sizeof(buf), n.mqttread(&n, buf, sizeof(buf), 500));
+    TEST_ASSERT_EQUAL_MEMORY(mqtt_in_large, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(1, mqtt_recv_calls);
+    TEST_ASSERT_EQUAL_INT(0, NetworkPending(&n));
+}
+
+static unsigned char mqtt_out[64];
+static int mqtt_out_len;
+static unsigned char mqtt_out_first[8];
+static int mqtt_out_count;
+static int mqtt_done_ok;
+static int mqtt_done_fail;
+
+static ssize_t mqtt_send_cb(int sockfd, const void *buf, size_t len, int flags, int num_calls) {
+    (void)sockfd; (void)flags; (void)num_calls;
+    // the first byte of every packet
+    if ( mqtt_out_count < (int)sizeof(mqtt_out_first) )
+        mqtt_out_first[mqtt_out_count] = *(const unsigned char *)buf;
+    mqtt_out_count++;
+    if ( len > sizeof(mqtt_out) ) len = sizeof(mqtt_out);
+    memcpy(mqtt_out, buf, len);
+    mqtt_out_len = (int)len;
+    return (ssize_t)len;
+}
+
+static void mqtt_done(void *arg, unsigned short id, int rc) {
+    (void)arg; (void)id;
+    if ( rc == MQTT_SUCCESS ) mqtt_done_ok++;
+    else mqtt_done_fail++;
+}
+
+void test_mqtt_publish_inflight(void) {
+    static const unsigned char acks[] = {
+        0x40, 0x02, 0x00, 0x02,   // PUBACK 2
+        0x20, 0x02, 0x00, 0x00    // CONNACK
+    };
+    static unsigned char sendbuf[128];
+    static unsigned char readbuf[128];
+    static MQTTInflight table[2];
+    Network n;
+    MQTTClient c;
+    MQTTMessage msg = { QOS1, 0, 0, 0, "t", 1 };
+    NetworkInit(&n);
+    n.my_socket = 3;
+    MQTTClientInit(&c, &n, 200, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+    MQTTSetInflight(&c, table, 2);
+    c.keepAliveInterval = 0;
+    c.isconnected = 1;
+    mqtt_in = acks;
+    mqtt_in_len = 4;
+    mqtt_out_count = 0;
+    mqtt_done_ok = mqtt_done_fail = 0;
+    recv_StubWithCallback(mqtt_recv_cb);
+    setsockopt_StubWithCallback(mqtt_setsockopt_cb);
+    send_StubWithCallback(mqtt_send_cb);
+
+    // no wait for the acks while the window has room
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, MQTTPublishAsync(&c, "topic", &msg, mqtt_done, NULL));
+    TEST_ASSERT_EQUAL_INT(2, msg.id);
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, MQTTPublishAsync(&c, "topic", &msg, mqtt_done, NULL));
+    TEST_ASSERT_EQUAL_INT(2, MQTTInflightCount(&c));
+    TEST_ASSERT_EQUAL_INT(4, (int)mqtt_in_len);
+    // the full window takes an ack first
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, MQTTPublishAsync(&c, "topic", &msg, mqtt_done, NULL));
+    TEST_ASSERT_EQUAL_INT(0, (int)mqtt_in_len);
+    TEST_ASSERT_EQUAL_INT(1, mqtt_done_ok);
+    TEST_ASSERT_EQUAL_INT(4, msg.id);
+    TEST_ASSERT_EQUAL_INT(2, MQTTInflightCount(&c));
+    TEST_ASSERT_EQUAL_INT(3, mqtt_out_count);
+    TEST_ASSERT_EQUAL_HEX8(0x32, mqtt_out_first[0]);
+    // the window stays full without the acks
+    TEST_ASSERT_EQUAL_INT(FAILURE, MQTTPublishAsync(&c, "topic", &msg, mqtt_done, NULL));
+
+    // a new connection sends them again with DUP
+    mqtt_in = acks + 4;
+    mqtt_in_len = 4;
+    mqtt_out_count = 0;
+    MQTTClientInit(&c, &n, 200, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+    MQTTSetInflight(&c, table, 2);
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, MQTTConnect(&c, NULL));
+    TEST_ASSERT_EQUAL_INT(3, mqtt_out_count);
+    TEST_ASSERT_EQUAL_HEX8(0x10, mqtt_out_first[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x3A, mqtt_out_first[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x3A, mqtt_out_first[2]);
+    TEST_ASSERT_EQUAL_INT(2, MQTTInflightCount(&c));
+
+    MQTTInflightAbort(&c);
+    TEST_ASSERT_EQUAL_INT(2, mqtt_done_fail);
+    TEST_ASSERT_EQUAL_INT(0, MQTTInflightCount(&c));
+}
+
+void test_mqtt_oversized_packet(void) {
+    static const unsigned char in[] = {
+        0x30, 0x0D, 0x00, 0x01, 't',    // PUBLISH larger than the read buffer
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+        0xD0, 0x00                      // PINGRESP
+    };
+    static unsigned char sendbuf[16];
+    static unsigned char readbuf[8];
+    Network n;
+    MQTTClient c;
+    NetworkInit(&n);
+    n.my_socket = 3;
+    MQTTClientInit(&c, &n, 200, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+    c.isconnected = 1;
+    c.keepAliveInterval = 0;
+    c.ping_outstanding = 1;
+    mqtt_in = in;
+    mqtt_in_len = sizeof(in);
+    recv_StubWithCallback(mqtt_recv_cb);
+    setsockopt_StubWithCallback(mqtt_setsockopt_cb);
+    send_StubWithCallback(mqtt_send_cb);
+
+    // the body is skipped, the next packet is framed right
+    TEST_ASSERT_EQUAL_INT(FAILURE, MQTTYield(&c, 50));
+    TEST_ASSERT_EQUAL_INT(2, NetworkPending(&n) + (int)mqtt_in_len);
+    TEST_ASSERT_EQUAL_INT(1, c.isconnected);
+    MQTTYield(&c, 50);
+    TEST_ASSERT_EQUAL_INT(0, c.ping_outstanding);
+}
@@ -0,0 +1,102 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <data/property.h>
+#include <data/linkedlist.h>
+#include <json/json.h>
+#include <json/dtoa.h>
+#include <json/scan.h>
+#include <arrow/api/json/parse.h>
+#include <arrow/api/log.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+typedef struct {
+    property_t hid;
+    who_when_t created;
+    int enabled;
+    int count;
+    JsonNode *info;
+} test_item_t;
+
+static const json_field_t _test_item_field[] = {
+    JSON_FIELD(test_item_t, hid, json_field_string),
+    JSON_FIELD_WHO_WHEN(test_item_t, created, "created"),
+    JSON_FIELD(test_item_t, enabled, json_field_bool),
+    JSON_FIELD(test_item_t, count, json_field_int),
+    JSON_FIELD(test_item_t, info, json_field_node)
+};
+static JSON_FIELDS(_test_item_fields, _test_item_field);
+
+static const char *item_text =
+        "{\"hid\":\"h1\",\"createdDate\":\"2018-07-27T12:28:53.123Z\","
+        "\"createdBy\":\"admin\",\"enabled\":true,\"count\":7,"
+        "\"info\":{\"a\":[1,2]},\"unknown\":\"x\",\"count\":\"wrong type\"}";
+
+void test_json_fields( void ) {
+    json_arena_t arena;
+    test_item_t item, copy;
+    json_arena_init(&arena, 0);
+    JsonNode *_main = json_decode_arena(&arena, item_text);
+    TEST_ASSERT( _main );
+    json_fields_init(&_test_item_fields, &item);
+    TEST_ASSERT_EQUAL_INT(0, json_fields_parse(&_test_item_fields, &item, _main));
+    json_arena_free(&arena);
+
+    TEST_ASSERT_EQUAL_STRING("h1", P_VALUE(item.hid));
+    TEST_ASSERT_EQUAL_STRING("admin", P_VALUE(item.created.by));
+    TEST_ASSERT_EQUAL_INT(118, item.created.date.tm_year);
+    TEST_ASSERT_EQUAL_INT(53, item.created.date.tm_sec);
+    TEST_ASSERT_EQUAL_INT(1, item.enabled);
+    TEST_ASSERT_EQUAL_INT(7, item.count);
+    TEST_ASSERT( item.info && !item.info->arena_ );
+
+    json_fields_init(&_test_item_fields, &copy);
+    json_fields_move(&_test_item_fields, &copy, &item);
+    TEST_ASSERT( IS_EMPTY(item.hid) );
+    TEST_ASSERT( !item.info );
+    JsonNode *enc = json_fields_encode(&_test_item_fields, &copy);
+    char *text = json_encode(enc);
+    TEST_ASSERT_EQUAL_STRING("{\"hid\":\"h1\",\"createdDate\":\"2018-07-27T12:28:53\","
+                             "\"createdBy\":\"admin\",\"enabled\":true,\"count\":7,"
+                             "\"info\":{\"a\":[1,2]}}", text);
+    free(text);
+    json_delete(enc);
+    json_fields_free(&_test_item_fields, &copy);
+    json_fields_free(&_test_item_fields, &item);
+    TEST_ASSERT( !copy.info );
+    TEST_ASSERT( IS_EMPTY(copy.created.by) );
+
+    TEST_ASSERT_EQUAL_INT(-1, json_fields_parse(&_test_item_fields, &item, NULL));
+}
+
+void test_log_parse( void ) {
+    log_t *list = NULL;
+    log_t *tmp = NULL;
+    int n = 0;
+    TEST_ASSERT_EQUAL_INT(0, log_parse(&list,
+        "{\"size\":2,\"data\":["
+        "{\"productName\":\"p1\",\"type\":\"t1\",\"objectHid\":\"o1\","
+        "\"createdDate\":\"2018-07-27T12:28:53\",\"parameters\":{\"k\":\"v\"}},"
+        "{\"productName\":\"p2\",\"type\":\"t2\",\"objectHid\":\"o2\"}]}"));
+    for_each_node(tmp, list, log_t) {
+        n++;
+        TEST_ASSERT_EQUAL_STRING(n == 1 ? "p1" : "p2", P_VALUE(tmp->productName));
+        TEST_ASSERT_EQUAL_STRING(n == 1 ? "o1" : "o2", P_VALUE(tmp->objectHid));
+        TEST_ASSERT( n == 1 ? tmp->parameters != NULL : tmp->parameters == NULL );
+    }
+    TEST_ASSERT_EQUAL_INT(2, n);
+    TEST_ASSERT_EQUAL_STRING("v", json_find_member(list->parameters, "k")->string_);
+    for_each_node_hard(tmp, list, log_t) {
+        log_free(tmp);
+        free(tmp);
+    }
+}
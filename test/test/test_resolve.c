@@ -0,0 +1,42 @@
+#include "unity.h"
+#include <config.h>
+#include <bsd/socket.h>
+#include <bsd/resolve.h>
+
+#include "mock_sockdecl.h"
+#include "fakedns.h"
+
+void setUp(void)
+{
+    soc_resolve_flush(NULL);
+}
+
+void tearDown(void)
+{
+}
+
+void test_resolve_cache(void) {
+    soc_addr_list_t list;
+    struct hostent *fake_addr = dns_fake(0xc0a80001, "api.test.io");
+    gethostbyname_ExpectAndReturn("api.test.io", fake_addr);
+    TEST_ASSERT_EQUAL_INT(0, soc_resolve("api.test.io", &list));
+    TEST_ASSERT_EQUAL_INT(1, list.count);
+    TEST_ASSERT_EQUAL_HEX32(0xc0a80001, list.addr[0]);
+    // no DNS request anymore
+    list.count = 0;
+    TEST_ASSERT_EQUAL_INT(0, soc_resolve("api.test.io", &list));
+    TEST_ASSERT_EQUAL_INT(1, list.count);
+    TEST_ASSERT_EQUAL_HEX32(0xc0a80001, list.addr[0]);
+
+    soc_resolve_flush("api.test.io");
+    gethostbyname_ExpectAndReturn("api.test.io", fake_addr);
+    TEST_ASSERT_EQUAL_INT(0, soc_resolve_prefetch("api.test.io"));
+}
+
+void test_resolve_negative(void) {
+    soc_addr_list_t list;
+    gethostbyname_ExpectAndReturn("none.test.io", NULL);
+    TEST_ASSERT_EQUAL_INT(-1, soc_resolve("none.test.io", &list));
+    // the failure is cached too
+    TEST_ASSERT_EQUAL_INT(-1, soc_resolve("none.test.io", &list));
+}
@@ -103,3 +103,79 @@ void test_pop_push_complex(void) {
     ringbuf_free(&rb);
 }
 
+
+void test_span_write_read(void) {
+    ring_buffer_t rb;
+    int res = ringbuf_init(&rb, 16);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    uint16_t len = 0;
+    uint8_t *ptr = ringbuf_write_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 15, len );
+    TEST_ASSERT( ptr == rb.buffer );
+    memcpy(ptr, "0123456789", 10);
+    TEST_ASSERT_EQUAL_INT( 0, ringbuf_commit(&rb, 10) );
+    TEST_ASSERT_EQUAL_INT( 10, ringbuf_size(&rb) );
+    ptr = ringbuf_read_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 10, len );
+    TEST_ASSERT_EQUAL_INT( 0, memcmp(ptr, "0123456789", 10) );
+    TEST_ASSERT_EQUAL_INT( 0, ringbuf_consume(&rb, 8) );
+    TEST_ASSERT_EQUAL_INT( 2, ringbuf_size(&rb) );
+    TEST_ASSERT_EQUAL_INT( -1, ringbuf_consume(&rb, 3) );
+    ringbuf_free(&rb);
+}
+
+void test_span_wrap(void) {
+    ring_buffer_t rb;
+    ringbuf_init(&rb, 16);
+    uint16_t len = 0;
+    ringbuf_push(&rb, (uint8_t*)"0123456789ab", 12);
+    char buf[16] = {0};
+    ringbuf_pop(&rb, (uint8_t*)buf, 10);
+    // free space is split by the border: 4 bytes at the end
+    uint8_t *ptr = ringbuf_write_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 4, len );
+    TEST_ASSERT( ptr == rb.buffer + 12 );
+    memcpy(ptr, "cdef", 4);
+    ringbuf_commit(&rb, 4);
+    ptr = ringbuf_write_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 9, len );
+    TEST_ASSERT( ptr == rb.buffer );
+    memcpy(ptr, "gh", 2);
+    ringbuf_commit(&rb, 2);
+    TEST_ASSERT_EQUAL_INT( -1, ringbuf_commit(&rb, 8) );
+    // data is split too
+    ptr = ringbuf_read_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 6, len );
+    TEST_ASSERT_EQUAL_INT( 0, memcmp(ptr, "abcdef", 6) );
+    ringbuf_consume(&rb, 6);
+    ptr = ringbuf_read_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 2, len );
+    TEST_ASSERT_EQUAL_INT( 0, memcmp(ptr, "gh", 2) );
+    ringbuf_consume(&rb, 2);
+    // empty buffer starts from the beginning again
+    ptr = ringbuf_write_span(&rb, &len);
+    TEST_ASSERT( ptr == rb.buffer );
+    TEST_ASSERT_EQUAL_INT( 15, len );
+    ringbuf_free(&rb);
+}
+
+void test_linearize(void) {
+    ring_buffer_t rb;
+    ringbuf_init(&rb, 16);
+    uint16_t len = 0;
+    ringbuf_push(&rb, (uint8_t*)"0123456789ab", 12);
+    char buf[16] = {0};
+    ringbuf_pop(&rb, (uint8_t*)buf, 10);
+    ringbuf_push(&rb, (uint8_t*)"cdefgh", 6);
+    uint8_t *ptr = ringbuf_read_span(&rb, &len);
+    TEST_ASSERT_EQUAL_INT( 6, len );
+    ringbuf_linearize(&rb);
+    ptr = ringbuf_read_span(&rb, &len);
+    TEST_ASSERT( ptr == rb.buffer );
+    TEST_ASSERT_EQUAL_INT( 8, len );
+    TEST_ASSERT_EQUAL_INT( 0, memcmp(ptr, "abcdefgh", 8) );
+    ringbuf_push(&rb, (uint8_t*)"ijklmno", 7);
+    ringbuf_pop(&rb, (uint8_t*)buf, 15);
+    TEST_ASSERT_EQUAL_INT( 0, memcmp(buf, "abcdefghijklmno", 15) );
+    ringbuf_free(&rb);
+}
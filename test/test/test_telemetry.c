@@ -0,0 +1,34 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <json/telemetry.h>
+
+typedef struct {
+    int id;
+    double temperature;
+} sample_t;
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+char *telemetry_serialize(arrow_device_t *device, void *data) {
+    (void)(device);
+    sample_t *s = (sample_t *)data;
+    char *tmp = (char *)malloc(64);
+    sprintf(tmp, "{\"i\":%d,\"t\":%.1f}", s->id, s->temperature);
+    return tmp;
+}
+
+void test_telemetry_serialize_into_default( void ) {
+    sample_t sample = { 1, 20.5 };
+    char buf[64];
+    // the heap telemetry_serialize is used unless the port has its own
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_serialize_into(NULL, &sample, buf, sizeof(buf)));
+}
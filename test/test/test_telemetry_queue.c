@@ -0,0 +1,141 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <config.h>
+#include <arrow/telemetry_queue.h>
+
+// the segment storage of the platform
+static unsigned char segs[TELEMETRY_QUEUE_SEGMENTS][TELEMETRY_QUEUE_SEGMENT_SIZE];
+static int seg_writes;
+
+int telemetry_queue_seg_read(int seg, int offset, void *buf, int len) {
+    memcpy(buf, segs[seg] + offset, (size_t)len);
+    return len;
+}
+
+int telemetry_queue_seg_write(int seg, int offset, const void *buf, int len) {
+    seg_writes++;
+    memcpy(segs[seg] + offset, buf, (size_t)len);
+    return len;
+}
+
+int telemetry_queue_seg_erase(int seg) {
+    memset(segs[seg], 0xFF, sizeof(segs[seg]));
+    return 0;
+}
+
+void setUp(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_clear());
+}
+
+void tearDown(void)
+{
+    telemetry_queue_clear();
+    telemetry_queue_close();
+}
+
+typedef struct {
+    int calls;
+    int fail_at;
+    int next;
+    char last[256];
+} sink_t;
+
+static int sink_send(const char *payload, int len, void *arg) {
+    sink_t *s = (sink_t *)arg;
+    int n;
+    if ( s->calls++ == s->fail_at ) return -1;
+    TEST_ASSERT_EQUAL_INT((int)strlen(payload), len);
+    if ( payload[0] != '[' ) {
+        TEST_ASSERT_EQUAL_INT(1, sscanf(payload, "{\"n\":%d}", &n));
+        TEST_ASSERT_EQUAL_INT(s->next, n);
+        s->next++;
+    }
+    strncpy(s->last, payload, sizeof(s->last) - 1);
+    return 0;
+}
+
+static void push_n(int from, int count) {
+    char msg[32];
+    int i;
+    for ( i = from; i < from + count; i++ ) {
+        int len = snprintf(msg, sizeof(msg), "{\"n\":%04d}", i);
+        TEST_ASSERT_EQUAL_INT(0, telemetry_queue_push(msg, len));
+    }
+}
+
+void test_telemetry_queue_order( void ) {
+    sink_t s = { 0, 2, 0, "" };
+    push_n(0, 5);
+    TEST_ASSERT_EQUAL_INT(5, telemetry_queue_count());
+    // the failed message stays first
+    TEST_ASSERT_EQUAL_INT(2, telemetry_queue_drain(10, sink_send, &s));
+    TEST_ASSERT_EQUAL_INT(3, telemetry_queue_count());
+    s.fail_at = -1;
+    TEST_ASSERT_EQUAL_INT(2, telemetry_queue_drain(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_INT(1, telemetry_queue_drain(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_INT(5, s.next);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_count());
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_drain(2, sink_send, &s));
+}
+
+void test_telemetry_queue_batch( void ) {
+    sink_t s = { 0, 0, 0, "" };
+    push_n(0, 3);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_drain_batch(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_INT(3, telemetry_queue_count());
+    TEST_ASSERT_EQUAL_INT(2, telemetry_queue_drain_batch(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_STRING("[{\"n\":0000},{\"n\":0001}]", s.last);
+    TEST_ASSERT_EQUAL_INT(1, telemetry_queue_drain_batch(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_STRING("[{\"n\":0002}]", s.last);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_count());
+}
+
+void test_telemetry_queue_bounded( void ) {
+    sink_t s = { 0, -1, 0, "" };
+    char big[TELEMETRY_QUEUE_SEGMENT_SIZE];
+    int total = 4 * TELEMETRY_QUEUE_SEGMENTS * TELEMETRY_QUEUE_SEGMENT_SIZE / 13;
+    memset(big, 'x', sizeof(big));
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_queue_push(big, (int)sizeof(big)));
+    push_n(0, total);
+    TEST_ASSERT( telemetry_queue_dropped() > 0 );
+    TEST_ASSERT_EQUAL_INT(total, telemetry_queue_count() + telemetry_queue_dropped());
+    // the newest ones are kept
+    s.next = telemetry_queue_dropped();
+    while ( telemetry_queue_drain(TELEMETRY_QUEUE_BATCH, sink_send, &s) > 0 ) ;
+    TEST_ASSERT_EQUAL_INT(total, s.next);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_count());
+}
+
+void test_telemetry_queue_reboot( void ) {
+    sink_t s = { 0, -1, 0, "" };
+    // the record of the lost power: the length and data without the state byte
+    static const unsigned char torn[] = { 10, 0, '{', '"', 'n', '"', ':', '9', '9', '9', '9', '}' };
+    push_n(0, 10);
+    TEST_ASSERT_EQUAL_INT(4, telemetry_queue_drain(4, sink_send, &s));
+    telemetry_queue_close();
+    TEST_ASSERT_EQUAL_INT(12, telemetry_queue_seg_write(0, 8 + 10 * 13 + 1, torn, sizeof(torn)));
+
+    TEST_ASSERT_EQUAL_INT(6, telemetry_queue_count());
+    push_n(10, 2);
+    telemetry_queue_close();
+    TEST_ASSERT_EQUAL_INT(8, telemetry_queue_count());
+    while ( telemetry_queue_drain(3, sink_send, &s) > 0 ) ;
+    TEST_ASSERT_EQUAL_INT(12, s.next);
+}
+
+void test_telemetry_queue_lazy( void ) {
+    sink_t s = { 0, -1, 0, "" };
+    telemetry_queue_close();
+    seg_writes = 0;
+    // nothing is written before the first message
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_count());
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_drain(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_INT(0, telemetry_queue_drain_batch(2, sink_send, &s));
+    TEST_ASSERT_EQUAL_INT(0, seg_writes);
+    push_n(0, 1);
+    TEST_ASSERT( seg_writes > 0 );
+    TEST_ASSERT_EQUAL_INT(1, telemetry_queue_count());
+}